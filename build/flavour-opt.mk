@@ -10,5 +10,17 @@ ifneq ($(OPENMSX_TARGET_OS),mingw32)
 CXXFLAGS+=-fomit-frame-pointer
 endif
 
+# Use computed goto's to speedup Z80 emulation:
+# - Computed goto's are a gcc extension (also supported by clang), it's not
+#   part of the official c++ standard.
+# - This is only beneficial on CPUs with branch prediction for indirect jumps
+#   and a reasonable amount of cache. For example it is very beneficial for a
+#   intel core2 cpu (10% faster), but not for a ARM920 (a few percent slower).
+#   So only enable it for CPUs where it's known to help.
+# - See the comments in src/cpu/CPUCore.ii for more details.
+ifneq ($(filter x86 x86_64 aarch64,$(OPENMSX_TARGET_CPU)),)
+CXXFLAGS+=-DUSE_COMPUTED_GOTO
+endif
+
 # Strip executable?
 OPENMSX_STRIP:=true
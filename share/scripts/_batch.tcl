@@ -0,0 +1,173 @@
+namespace eval batch {
+
+# Run a list of jobs (machine + media + some amount of MSX time) one after
+# the other, and write the results (CRC of the VRAM, optionally a screenshot)
+# to a file. Intended for (headless) regression testing.
+
+variable jobs [list]
+variable channel
+variable saved_throttle
+variable done_command
+variable num_errors
+
+set_help_text batch_run \
+{Run a list of jobs and write the results to a file.
+
+Each (non-empty) line in the job file that doesn't start with '#' is a Tcl
+dictionary describing a job. Recognized keys are:
+  name        name of the job, default 'job<n>'
+  machine     machine to use, default the 'default_machine' setting
+  media       list of commands to insert media, e.g. {{carta game.rom}}
+  commands    Tcl commands executed after the media are inserted
+  time        amount of MSX time (in seconds) to emulate, default 10
+  screenshot  filename for a screenshot taken at the end of the job
+Example:
+  name mg2 machine Philips_NMS_8250 media {{carta mg2.rom}} time 30
+
+For each job a new machine is created, the media are inserted, the commands
+are executed and then the given amount of MSX time is emulated (with
+throttling disabled). Each line in the result file is again a dictionary
+with the keys 'name', 'status' (ok or error), 'message', 'realtime' (in
+seconds) and 'vram_crc' (CRC32 of the VRAM content at the end of the job),
+and, when requested, 'screenshot'.
+
+The jobs run in the same process. For headless runs disable the video and
+sound output and exit when all jobs are done, e.g.:
+  openmsx -command "set renderer none" -command "set sound_driver null" \
+          -command "batch_run jobs.txt results.txt {exit [batch_errors]}"
+Note that with renderer 'none' screenshots can't be taken, compare the
+'vram_crc' values instead. To use multiple CPU cores, split the job list and
+start multiple openMSX processes.
+
+Usage:
+  batch_run <jobfile> [<resultfile>] [<command>]
+
+  <resultfile>  default is <jobfile> with '.results' appended
+  <command>     command to execute when all jobs are done, e.g. 'exit'
+}
+proc batch_run {jobfile {resultfile ""} {command ""}} {
+	variable jobs
+	variable channel
+	variable saved_throttle
+	variable done_command $command
+	variable num_errors 0
+
+	if {[llength $jobs] != 0} {
+		error "A batch is already running"
+	}
+	set jobs [read_jobs $jobfile]
+	if {$resultfile eq ""} {
+		set resultfile "$jobfile.results"
+	}
+	set channel [open $resultfile w]
+	set saved_throttle $::throttle
+	set ::throttle off
+	after realtime 0 [namespace code next_job]
+	return "Running [llength $jobs] jobs, results are written to $resultfile"
+}
+
+set_help_text batch_errors \
+{Returns the number of failed jobs of the last batch_run.}
+proc batch_errors {} {
+	variable num_errors
+	return $num_errors
+}
+
+proc read_jobs {jobfile} {
+	set f [open $jobfile r]
+	set lines [split [read $f] "\n"]
+	close $f
+
+	set result [list]
+	set n 0
+	foreach line $lines {
+		set line [string trim $line]
+		if {$line eq "" || [string index $line 0] eq "#"} continue
+		incr n
+		if {[catch {dict size $line}]} {
+			error "Job $n in $jobfile is not a valid dictionary: $line"
+		}
+		set job [dict create name "job$n" machine $::default_machine \
+		                     media [list] commands "" time 10]
+		lappend result [dict merge $job $line]
+	}
+	return $result
+}
+
+proc next_job {} {
+	variable jobs
+	if {[llength $jobs] == 0} {
+		finish
+		return
+	}
+	set job [lindex $jobs 0]
+	set start [clock microseconds]
+	if {[catch {
+		machine [dict get $job machine]
+		foreach cmd [dict get $job media] {
+			uplevel #0 $cmd
+		}
+		uplevel #0 [dict get $job commands]
+	} msg]} {
+		job_done $job $start error $msg
+		return
+	}
+	after time [dict get $job time] [namespace code [list job_done $job $start ok ""]]
+}
+
+proc job_done {job start status message} {
+	variable jobs
+	variable channel
+	variable num_errors
+
+	set result [dict create name [dict get $job name]]
+	if {$status eq "ok"} {
+		if {[catch {
+			set vram [debug read_block VRAM 0 [debug size VRAM]]
+			dict set result vram_crc [format %08x [zlib crc32 $vram]]
+		} msg]} {
+			set status error
+			set message "Can't read VRAM: $msg"
+		}
+	}
+	if {$status eq "ok" && [dict exists $job screenshot]} {
+		if {[catch {
+			dict set result screenshot [screenshot -raw [dict get $job screenshot]]
+		} msg]} {
+			set status error
+			set message "Can't take screenshot: $msg"
+		}
+	}
+	if {$status ne "ok"} {
+		incr num_errors
+	}
+	dict set result status $status
+	dict set result message $message
+	dict set result realtime [expr {([clock microseconds] - $start) / 1000000.0}]
+	puts $channel $result
+	flush $channel
+
+	set jobs [lrange $jobs 1 end]
+	# Don't directly switch machine from within an 'after time' callback
+	# of the current machine.
+	after realtime 0 [namespace code next_job]
+}
+
+proc finish {} {
+	variable channel
+	variable saved_throttle
+	variable done_command
+	variable num_errors
+	close $channel
+	set ::throttle $saved_throttle
+	message "Batch finished, $num_errors job(s) failed." \
+		[expr {$num_errors ? "warning" : "info"}]
+	uplevel #0 $done_command
+}
+
+namespace export batch_run
+namespace export batch_errors
+
+} ;# namespace batch
+
+namespace import batch::*
@@ -0,0 +1,203 @@
+namespace eval benchmark {
+
+# Helpers to measure emulation speed under various conditions. All
+# measurements run with throttling disabled, the result is the emulation
+# speed relative to a real MSX (so 100% means real-time).
+
+variable saved_throttle
+variable results
+variable bp_ids [list]
+variable sound_extensions {moonsound fmpac scc+ audio Yamaha_SFG-05 2nd_PSG}
+
+# Measure the emulation speed during 'duration' (real-time) seconds, then
+# invoke 'callback' with the measured speed (in percent) appended.
+proc measure_speed {duration callback} {
+	set emu_start  [machine_info time]
+	set real_start [clock microseconds]
+	after realtime $duration [namespace code [list measure_done $emu_start $real_start $callback]]
+}
+proc measure_done {emu_start real_start callback} {
+	set real [expr {([clock microseconds] - $real_start) / 1000000.0}]
+	set emu  [expr {[machine_info time] - $emu_start}]
+	{*}$callback [expr {100.0 * $emu / $real}]
+}
+
+proc format_speed {speed} {
+	set cycles [expr {$speed / 100.0 * [machine_info z80_freq] / 1000000.0}]
+	format "%7.1f%% (%.1fM Z80 cycles/s)" $speed $cycles
+}
+
+proc start {} {
+	variable saved_throttle $::throttle
+	variable results [list]
+	set ::throttle off
+}
+proc finish {title} {
+	variable saved_throttle
+	variable results
+	set ::throttle $saved_throttle
+	set text "$title:"
+	foreach {label speed} $results {
+		append text "\n  [format %-20s $label] [format_speed $speed]"
+	}
+	message $text info
+}
+
+set_help_text benchmark_breakpoints \
+{Measure the emulation speed with 0, 10 and 1000 breakpoints set.
+
+The breakpoints are spread over the whole address space and have an empty
+command, so they (mostly) measure the cost of checking for breakpoints. The
+results are printed when the benchmark is finished.
+
+Usage:
+  benchmark_breakpoints [<duration>] [<counts>]
+
+  <duration>  time in seconds for each measurement, default 10
+  <counts>    list with the number of breakpoints, default {0 10 1000}
+}
+proc benchmark_breakpoints {{duration 10} {counts {0 10 1000}}} {
+	start
+	bp_step $duration $counts
+	return "Measuring, this takes about [expr {$duration * [llength $counts]}] seconds..."
+}
+proc remove_bps {} {
+	variable bp_ids
+	foreach id $bp_ids {
+		debug remove_bp $id
+	}
+	set bp_ids [list]
+}
+proc bp_step {duration counts} {
+	variable bp_ids
+	remove_bps
+	if {[llength $counts] == 0} {
+		finish "Emulation speed with breakpoints"
+		return
+	}
+	set n [lindex $counts 0]
+	for {set i 0} {$i < $n} {incr i} {
+		lappend bp_ids [debug set_bp [expr {($i * 0x10000 / $n + 0x1F) & 0xFFFF}] {} {}]
+	}
+	measure_speed $duration [namespace code [list bp_done $duration $counts]]
+}
+proc bp_done {duration counts speed} {
+	variable results
+	lappend results "[lindex $counts 0] breakpoints" $speed
+	bp_step $duration [lrange $counts 1 end]
+}
+
+set_help_text benchmark_cpu \
+{Measure how fast a fixed span of emulated time can be emulated.
+
+Each measurement emulates <duration> seconds of MSX time (with throttling
+disabled) and measures how long that takes in real time. The results and
+their average are printed when the benchmark is finished. This is useful to
+compare the speed of different builds of openMSX (e.g. with or without
+computed goto's, see src/cpu/CPUCore.ii).
+
+For reproducible results use a fixed machine and workload, and disable the
+video and sound output. For example the C-BIOS machines run a fixed loop
+when no cartridge is inserted:
+  openmsx -machine C-BIOS_MSX2+ -command "set renderer none" \
+          -command "set mute on" -command "benchmark_cpu 60 3 exit"
+
+Usage:
+  benchmark_cpu [<duration>] [<repeat>] [<command>]
+
+  <duration>  MSX time in seconds for each measurement, default 30
+  <repeat>    number of measurements, default 3
+  <command>   command to execute when finished, e.g. 'exit', default none
+}
+proc benchmark_cpu {{duration 30} {repeat 3} {command ""}} {
+	start
+	cpu_step $duration $repeat $command 1
+	return "Measuring, this emulates [expr {$duration * $repeat}] seconds of MSX time..."
+}
+proc cpu_step {duration repeat command i} {
+	variable results
+	if {$i > $repeat} {
+		set sum 0.0
+		foreach {label speed} $results {
+			set sum [expr {$sum + $speed}]
+		}
+		lappend results "average" [expr {$sum / $repeat}]
+		finish "Emulation speed of [machine_info config_name] ([get_active_cpu])"
+		uplevel #0 $command
+		return
+	}
+	set real_start [clock microseconds]
+	after time $duration [namespace code [list cpu_done $duration $repeat $command $i $real_start]]
+}
+proc cpu_done {duration repeat command i real_start} {
+	variable results
+	set real [expr {([clock microseconds] - $real_start) / 1000000.0}]
+	lappend results "run $i" [expr {100.0 * $duration / $real}]
+	cpu_step $duration $repeat $command [expr {$i + 1}]
+}
+
+set_help_text benchmark_sound \
+{Measure the CPU cost of the sound chips of an idle machine.
+
+First emulates <duration> seconds of MSX time with the current machine as is,
+then inserts the given extensions (typically sound cartridges) and emulates
+the same amount of time again. For both runs the real time needed per second
+of MSX time is printed. The machine should be idle (e.g. at the BASIC prompt)
+so that mostly the cost of silent sound chips is measured. Extensions that
+can't be inserted (e.g. missing system ROMs) are skipped.
+
+Note that the sound is generated even when 'mute' is on, but use
+'sound_driver null' to measure without the overhead of the sound output:
+  openmsx -machine Panasonic_FS-A1GT -command "set renderer none" \
+          -command "set sound_driver null" -command "benchmark_sound 60 {} exit"
+
+Usage:
+  benchmark_sound [<duration>] [<extensions>] [<command>]
+
+  <duration>    MSX time in seconds for each measurement, default 30
+  <extensions>  list of extensions, default (or when empty) all sound
+                cartridges: moonsound fmpac scc+ audio Yamaha_SFG-05 2nd_PSG
+  <command>     command to execute when finished, e.g. 'exit', default none
+}
+proc benchmark_sound {{duration 30} {extensions {}} {command ""}} {
+	if {$extensions eq ""} {
+		variable sound_extensions
+		set extensions $sound_extensions
+	}
+	start
+	sound_step $duration $extensions $command "without extensions"
+	return "Measuring, this emulates [expr {2 * $duration}] seconds of MSX time..."
+}
+proc sound_step {duration extensions command label} {
+	set real_start [clock microseconds]
+	after time $duration [namespace code [list sound_done $duration $extensions $command $label $real_start]]
+}
+proc sound_done {duration extensions command label real_start} {
+	variable results
+	set real [expr {([clock microseconds] - $real_start) / 1000000.0}]
+	lappend results $label [expr {100.0 * $duration / $real}]
+	if {$label ne "without extensions"} {
+		variable saved_throttle
+		set ::throttle $saved_throttle
+		set text "Real time per second of MSX time on [machine_info config_name]:"
+		foreach {l speed} $results {
+			append text "\n  [format %-20s $l] [format %7.1f [expr {100000.0 / $speed}]]ms"
+		}
+		message $text info
+		uplevel #0 $command
+		return
+	}
+	set inserted 0
+	foreach ext $extensions {
+		if {![catch {ext $ext}]} {incr inserted}
+	}
+	sound_step $duration $extensions $command "with $inserted extensions"
+}
+
+namespace export benchmark_breakpoints
+namespace export benchmark_cpu
+namespace export benchmark_sound
+
+} ;# namespace benchmark
+
+namespace import benchmark::*
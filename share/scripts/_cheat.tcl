@@ -9,10 +9,15 @@ Welcome to the openMSX cheat finder. Please visit
 for a quick tutorial
 
 Usage:
-  findcheat [-start] [-max n] [expression]
-     -start     :  restart search, discard previously found addresses
-     -max n     :  show max n results
-     expression :  TODO
+  findcheat [-start] [-word] [-debuggable name] [-max n] [expression]
+     -start           :  restart search, discard previously found addresses
+     -word            :  restart, search for 16-bit instead of 8-bit values
+     -debuggable name :  restart, search in the given debuggable
+                         (default 'memory', e.g. use 'Main RAM' to also
+                         search the memory mapper pages that are not
+                         visible for the CPU)
+     -max n           :  show max n results
+     expression       :  a Tcl expression using 'new', 'old' and 'addr'
 
 Examples:
   findcheat 42                 search for specific value
@@ -23,12 +28,18 @@ Examples:
   findcheat -start new < 10    restart and search for values less than 10
   findcheat -max 40 smaller    search for smaller values, show max 40 results
   findcheat -start addr>0xe000 && addr<0xefff search in defined memory locations
+  findcheat -start -word 1000  search for a 16-bit value
+
+The expressions (and shortcuts) that compare 'new' with a constant or with
+'old' plus or minus a constant are handled by the (fast) 'debug cheat_finder'
+command, other expressions are evaluated in Tcl.
 }
 
 namespace eval cheat_finder {
 
 variable max_num_results 15 ;# maximum to display cheats
-variable mem
+variable debuggable "memory"
+variable width ""
 
 # build translation dictionary for convenience expressions
 variable translate [dict create \
@@ -64,50 +75,77 @@ proc tab_cheat_type {args} {
 	variable translate
 
 	set result [dict keys $translate]
-	lappend result "-start" "-max"
+	lappend result "-start" "-max" "-word" "-debuggable"
 	return $result
 }
 
 # Restart cheat finder.
 proc start {} {
-	variable mem [dict create]
-
-	set mymem [debug read_block memory 0 0x10000]
-	binary scan $mymem c* values
-	set addr 0
-	foreach val $values {
-		dict append mem $addr $val
-		incr addr
+	variable debuggable
+	variable width
+	debug cheat_finder start {*}$width $debuggable
+}
+
+# Translate an expression to the arguments of 'debug cheat_finder search',
+# returns an empty string if that's not possible. Handles the forms
+#   true,  new <op> <value>,  new <op> old,  new <op> (old +/- <value>)
+proc native_search_args {expression} {
+	set expression [string map {" " "" "\t" "" "(" "" ")" ""} $expression]
+	if {$expression eq "true"} {
+		return [list ge -value 0]
+	}
+	if {![regexp {^new(==|!=|<=|>=|<|>)(.+)$} $expression -> op rhs]} {
+		return ""
+	}
+	if {[string is entier -strict $rhs]} {
+		return [list $op -value [expr {$rhs}]]
+	}
+	if {$rhs eq "old"} {
+		return [list $op]
+	}
+	if {[regexp {^old([-+])(.+)$} $rhs -> sign delta] &&
+	    [string is entier -strict $delta]} {
+		return [list $op -delta [expr "$sign$delta"]]
 	}
+	return ""
 }
 
 # Helper function to do the actual search.
 # Returns a list of triplets (addr, old, new)
-proc search {expression} {
-	variable mem
-
-	set result [list]
-	dict for {addr old} $mem {
-		set new [debug read memory $addr]
-		#note: NO braces around $expression
-		if $expression {
-			dict set mem $addr $new
-			lappend result [list $addr $old $new]
-		} else {
-			dict unset mem $addr
+proc search {expression {max -1}} {
+	set args [native_search_args $expression]
+	if {$args ne ""} {
+		debug cheat_finder search {*}$args
+	} else {
+		# Take a new snapshot (keep all candidates) and evaluate the
+		# expression in Tcl for each remaining location.
+		debug cheat_finder search ge -value 0
+		# prefix 'old', 'new' and 'addr' with '$'
+		set expression [string map {old $old new $new addr $addr} $expression]
+		set keep [list]
+		foreach triplet [debug cheat_finder results] {
+			lassign $triplet addr old new
+			#note: NO braces around $expression
+			if $expression {
+				lappend keep $addr
+			}
 		}
+		debug cheat_finder retain $keep
 	}
-	return $result
+	if {$max < 0} {
+		return [debug cheat_finder results]
+	}
+	debug cheat_finder results $max
 }
 
 # main routine
 proc findcheat {args} {
-	variable mem
 	variable max_num_results
 	variable translate
+	variable debuggable
+	variable width
 
-	# create mem dictionary
-	if {![info exists mem]} start
+	set restart 0
 
 	# parse options
 	while (1) {
@@ -117,12 +155,24 @@ proc findcheat {args} {
 			  set args [lrange $args 2 end]
 		}
 		"-start" {
-			start
+			set restart 1
+			set width ""
 			set args [lrange $args 1 end]
 		}
+		"-word" {
+			set restart 1
+			set width "-word"
+			set args [lrange $args 1 end]
+		}
+		"-debuggable" {
+			set restart 1
+			set debuggable [lindex $args 1]
+			set args [lrange $args 2 end]
+		}
 		"default" break
 		}
 	}
+	if {$restart || ![debug cheat_finder active]} start
 
 	# all remaining arguments form the expression
 	set expression [join $args]
@@ -135,20 +185,16 @@ proc findcheat {args} {
 		set expression "new == $expression"
 	}
 
-	# prefix 'old', 'new' and 'addr' with '$'
-	set expression [string map {old $old new $new addr $addr} $expression]
-
 	# search memory
-	set result [search $expression]
+	set result [search $expression [expr {$max_num_results + 1}]]
 
 	# display the result
-	set num [llength $result]
+	set num [debug cheat_finder count]
 	if {$num == 0} {
 		return "No results left"
 	} elseif {$num <= $max_num_results} {
 		set output ""
-		set sorted [lsort -integer -index 0 $result]
-		foreach {addr old new} [join $sorted] {
+		foreach {addr old new} [join $result] {
 			append output [format "0x%04X : %d -> %d\n" $addr $old $new]
 		}
 		return $output
@@ -16,9 +16,13 @@ Examples:
 When switching trainers, the currently active trainer will be deactivated.
 "
 
+# The cheats themselves are applied by the 'trainer_engine' command. That's
+# part of the emulated machine, so it's deactivated on reset and stored in
+# savestates. This script translates the trainer definitions to lists of
+# pokes for that engine. Cheats that can't be translated (arbitrary Tcl code
+# in user defined trainers) are still executed from here.
+
 variable trainers ""
-variable active_trainer ""
-variable items_active
 variable after_id 0
 
 proc load_trainers {} {
@@ -54,8 +58,6 @@ proc tab_trainer {args} {
 }
 
 proc trainer {args} {
-	variable active_trainer
-	variable items_active
 	set trainers [load_trainers]
 
 	if {[llength $args] > 0} {
@@ -65,27 +67,35 @@ proc trainer {args} {
 			if {![dict exists $trainers $name]} {
 				error "no trainer for $name."
 			}
-			set same_trainer [string equal $name $active_trainer]
 			set items [parse_items $name $requested_items]
-			if {$same_trainer} {
-				set new_items [list]
-				foreach item1 $items item2 $items_active {
-					lappend new_items [expr {$item1 ^ $item2}]
+			if {$name eq [active_trainer]} {
+				set indices [list]
+				set i 0
+				foreach item $items {
+					if {$item} {lappend indices $i}
+					incr i
+				}
+				if {[llength $indices] > 0} {
+					trainer_engine toggle {*}$indices
 				}
-				set items_active $new_items
 			} else {
-				deactivate
-				set active_trainer $name
-				set items_active $items
-				execute
+				set cheats [list]
+				foreach {item_name item_impl} [dict get $trainers $name items] item_active $items {
+					lappend cheats [list $item_name $item_active [compile $item_impl]]
+				}
+				trainer_engine activate $name [dict get $trainers $name repeat] $cheats
+				schedule_fallback
 			}
 		} else {
-			deactivate
+			trainer_engine deactivate
 			return ""
 		}
 	}
 	print
 }
+proc active_trainer {} {
+	dict get [trainer_engine status] game
+}
 proc parse_items {name requested_items} {
 	variable trainers
 	set items [dict get $trainers $name items]
@@ -99,19 +109,37 @@ proc parse_items {name requested_items} {
 	}
 	return $result
 }
+# Translate the implementation of a cheat to a list of {poke|dpoke addr value}.
+# Returns an empty list if that's not possible.
+proc compile {impl} {
+	set result [list]
+	foreach cmd [split $impl ";\n"] {
+		if {[string trim $cmd] eq ""} continue
+		if {[catch {llength $cmd} len] || $len < 3 || $len > 4} {return ""}
+		lassign $cmd type addr value debuggable
+		if {$type ni {poke dpoke} ||
+		    ($len == 4 && $debuggable ne "memory") ||
+		    ![string is entier -strict $addr]  || $addr  < 0 || $addr  > 0xffff ||
+		    ![string is entier -strict $value] || $value < 0 || $value > 0xff} {
+			return ""
+		}
+		lappend result [list $type [expr {$addr}] [expr {$value}]]
+	}
+	return $result
+}
 proc print {} {
 	variable trainers
-	variable active_trainer
-	variable items_active
 
+	set status [trainer_engine status]
+	set active_trainer [dict get $status game]
 	if {$active_trainer eq ""} {
 		return "no trainer active"
 	}
 	set result [list]
-	set items [dict get $trainers $active_trainer items]
 	lappend result "active trainer: $active_trainer"
 	set i 1
-	foreach {item_name item_impl} $items item_active $items_active {
+	foreach cheat [dict get $status cheats] {
+		lassign $cheat item_name item_active
 		set line "$i \["
 		append line [expr {$item_active ? "x" : " "}]
 		append line "\] $item_name"
@@ -120,34 +148,36 @@ proc print {} {
 	}
 	join $result \n
 }
-proc execute {} {
+# Executes the active cheats that couldn't be compiled to pokes. For the
+# builtin trainers this is normally not needed.
+proc schedule_fallback {} {
+	variable after_id
+	after cancel $after_id
+	set after_id 0
+	set game [active_trainer]
+	if {$game eq "" || ![has_fallback $game]} return
+	execute_fallback $game
+}
+proc has_fallback {game} {
+	variable trainers
+	foreach {item_name item_impl} [dict get $trainers $game items] {
+		if {[compile $item_impl] eq ""} {return true}
+	}
+	return false
+}
+proc execute_fallback {game} {
 	variable trainers
-	variable active_trainer
-	variable items_active
 	variable after_id
 
-	set items  [dict get $trainers $active_trainer items ]
-	set repeat [dict get $trainers $active_trainer repeat]
-	foreach {item_name item_impl} $items item_active $items_active {
-		if {$item_active} {
+	set status [trainer_engine status]
+	if {[dict get $status game] ne $game} return
+	foreach {item_name item_impl} [dict get $trainers $game items] cheat [dict get $status cheats] {
+		if {[lindex $cheat 1] && [compile $item_impl] eq ""} {
 			eval $item_impl
 		}
 	}
-	set after_id [after {*}$repeat trainer::execute]
-}
-proc deactivate {} {
-	variable after_id
-	variable active_trainer
-
-	after cancel $after_id
-	set active_trainer ""
-}
-proc deactivate_after {event} {
-	deactivate
-	after $event "trainer::deactivate_after $event"
+	set after_id [after {*}[dict get $trainers $game repeat] [list trainer::execute_fallback $game]]
 }
-deactivate_after boot
-deactivate_after machine_switch
 
 proc create_trainer {name repeat items} {
 	variable trainers
@@ -43,6 +43,9 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 			{"hq",   ResampledSoundDevice::RESAMPLE_HQ},
 			{"fast", ResampledSoundDevice::RESAMPLE_LQ},
 			{"blip", ResampledSoundDevice::RESAMPLE_BLIP}})
+	, deferSoundWritesSetting(commandController, "sound_deferred_writes",
+		"apply sound chip register writes in batches while generating "
+		"sound, instead of generating sound on each write", false)
 	, speedManager(commandController)
 	, throttleManager(commandController)
 {
@@ -48,6 +48,9 @@ public:
 	[[nodiscard]] EnumSetting<ResampledSoundDevice::ResampleType>& getResampleSetting() {
 		return resampleSetting;
 	}
+	[[nodiscard]] BooleanSetting& getDeferSoundWritesSetting() {
+		return deferSoundWritesSetting;
+	}
 	[[nodiscard]] IntegerSetting& getJoyDeadZoneSetting(int i) {
 		return *deadZoneSettings[i];
 	}
@@ -72,6 +75,7 @@ private:
 	StringSetting  invalidPsgDirectionsSetting;
 	StringSetting  invalidPpiModeSetting;
 	EnumSetting<ResampledSoundDevice::ResampleType> resampleSetting;
+	BooleanSetting deferSoundWritesSetting;
 	std::vector<std::unique_ptr<IntegerSetting>> deadZoneSettings;
 	SpeedManager speedManager;
 	ThrottleManager throttleManager;
@@ -27,6 +27,7 @@
 #include "LedStatus.hh"
 #include "MSXEventDistributor.hh"
 #include "StateChangeDistributor.hh"
+#include "Trainer.hh"
 #include "EventDelay.hh"
 #include "RealTime.hh"
 #include "DeviceFactory.hh"
@@ -246,6 +247,7 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	machineMediaInfo = make_unique<MachineMediaInfo>(*this);
 	deviceInfo = make_unique<DeviceInfo>(*this);
 	debugger = make_unique<Debugger>(*this);
+	trainer = make_unique<Trainer>(*this);
 
 	msxMixer->mute(); // powered down
 
@@ -603,6 +605,7 @@ void MSXMotherBoard::doReset()
 
 	EmuTime::param time = getCurrentTime();
 	getCPUInterface().reset();
+	trainer->reset();
 	for (auto& d : availableDevices) {
 		d->reset(time);
 	}
@@ -639,6 +642,7 @@ void MSXMotherBoard::powerUp()
 
 	EmuTime::param time = getCurrentTime();
 	getCPUInterface().reset();
+	trainer->reset();
 	for (auto& d : availableDevices) {
 		d->powerUp(time);
 	}
@@ -1224,6 +1228,7 @@ void SettingObserver::update(const Setting& setting) noexcept
 // version 3: removed reRecordCount (moved to ReverseManager)
 // version 4: moved joystickportA/B from MSXPSG to here
 // version 5: do serialize renShaTurbo
+// version 6: added trainer
 template<typename Archive>
 void MSXMotherBoard::serialize(Archive& ar, unsigned version)
 {
@@ -1274,6 +1279,9 @@ void MSXMotherBoard::serialize(Archive& ar, unsigned version)
 	if (ar.versionAtLeast(version, 5)) {
 		if (renShaTurbo) ar.serialize("renShaTurbo", *renShaTurbo);
 	}
+	if (ar.versionAtLeast(version, 6)) {
+		ar.serialize("trainer", *trainer);
+	}
 
 	if constexpr (Archive::IS_LOADER) {
 		powered = true; // must come before changing power setting
@@ -57,6 +57,7 @@ class ReverseManager;
 class SettingObserver;
 class Scheduler;
 class StateChangeDistributor;
+class Trainer;
 
 class MediaInfoProvider
 {
@@ -144,6 +145,7 @@ public:
 	[[nodiscard]] CartridgeSlotManager& getSlotManager() { return *slotManager; }
 	[[nodiscard]] RealTime& getRealTime() { return *realTime; }
 	[[nodiscard]] Debugger& getDebugger() { return *debugger; }
+	[[nodiscard]] Trainer& getTrainer() { return *trainer; }
 	[[nodiscard]] MSXMixer& getMSXMixer() { return *msxMixer; }
 	[[nodiscard]] PluggingController& getPluggingController();
 	[[nodiscard]] MSXCPU& getCPU();
@@ -267,6 +269,7 @@ private:
 	std::unique_ptr<EventDelay> eventDelay;
 	std::unique_ptr<RealTime> realTime;
 	std::unique_ptr<Debugger> debugger;
+	std::unique_ptr<Trainer> trainer;
 	std::unique_ptr<MSXMixer> msxMixer;
 	// machineMediaInfo must be BEFORE PluggingController!
 	std::unique_ptr<MachineMediaInfo> machineMediaInfo;
@@ -306,7 +309,7 @@ private:
 	bool active = false;
 	bool fastForwarding = false;
 };
-SERIALIZE_CLASS_VERSION(MSXMotherBoard, 5);
+SERIALIZE_CLASS_VERSION(MSXMotherBoard, 6);
 
 class ExtCmd final : public RecordedCommand
 {
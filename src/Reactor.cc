@@ -1,5 +1,6 @@
 #include "Reactor.hh"
 #include "CommandLineParser.hh"
+#include "CheatFinder.hh"
 #include "RTScheduler.hh"
 #include "EventDistributor.hh"
 #include "GlobalCommandController.hh"
@@ -228,6 +229,7 @@ void Reactor::init()
 		*globalCommandController, *eventDistributor, *globalSettings);
 	symbolManager = make_unique<SymbolManager>(
 		*globalCommandController);
+	cheatFinder = make_unique<CheatFinder>();
 	imGuiManager = make_unique<ImGuiManager>(*this);
 	diskFactory = make_unique<DiskFactory>(
 		*this);
@@ -24,6 +24,7 @@ class GlobalSettings;
 class CliComm;
 class ImGuiManager;
 class Interpreter;
+class CheatFinder;
 class Display;
 class Mixer;
 class InputEventGenerator;
@@ -96,6 +97,7 @@ public:
 	[[nodiscard]] ImGuiManager& getImGuiManager() { return *imGuiManager; }
 	[[nodiscard]] const HotKey& getHotKey() const;
 	[[nodiscard]] SymbolManager& getSymbolManager() const { return *symbolManager; }
+	[[nodiscard]] CheatFinder& getCheatFinder() const { return *cheatFinder; }
 
 	[[nodiscard]] RomDatabase& getSoftwareDatabase();
 
@@ -160,6 +162,7 @@ private:
 	std::unique_ptr<GlobalSettings> globalSettings;
 	std::unique_ptr<InputEventGenerator> inputEventGenerator;
 	std::unique_ptr<SymbolManager> symbolManager; // before imGuiManager
+	std::unique_ptr<CheatFinder> cheatFinder; // outside the machine: survives reverse and loadstate
 	std::unique_ptr<ImGuiManager> imGuiManager; // before display
 	std::unique_ptr<Display> display;
 	std::unique_ptr<Mixer> mixer; // lazy initialized
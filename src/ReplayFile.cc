@@ -0,0 +1,218 @@
+#include "ReplayFile.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "endian.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include <array>
+#include <cassert>
+#include <zlib.h>
+
+namespace openmsx {
+
+static constexpr std::array<uint8_t, 8> HEADER_MAGIC  = {'o', 'M', 'S', 'X', '-', 'r', 'p', 'l'};
+static constexpr std::array<uint8_t, 8> TRAILER_MAGIC = {'o', 'M', 'S', 'X', '-', 'i', 'd', 'x'};
+static constexpr uint32_t FORMAT_VERSION = 1;
+static constexpr size_t HEADER_SIZE = 8 + 4;
+static constexpr size_t TRAILER_SIZE = 8 + 8;
+static constexpr size_t ENTRY_SIZE = 3 * 8; // offset, compressed size, size
+
+// class ReplayFileWriter
+
+ReplayFileWriter::ReplayFileWriter(std::string filename_)
+	: filename(std::move(filename_))
+	, tmpFilename(strCat(filename, ".tmp"))
+{
+	try {
+		file = File(tmpFilename, File::TRUNCATE);
+	} catch (FileException& e) {
+		throw MSXException("Could not write \"", filename, "\": ", e.getMessage());
+	}
+	std::array<uint8_t, HEADER_SIZE> header;
+	ranges::copy(HEADER_MAGIC, header.data());
+	Endian::write_UA_L32(&header[HEADER_MAGIC.size()], FORMAT_VERSION);
+	try {
+		write(header);
+	} catch (MSXException&) {
+		file.close();
+		FileOperations::unlink(tmpFilename);
+		throw;
+	}
+}
+
+ReplayFileWriter::~ReplayFileWriter()
+{
+	if (!finished) {
+		file.close();
+		FileOperations::unlink(tmpFilename);
+	}
+}
+
+void ReplayFileWriter::write(std::span<const uint8_t> data)
+{
+	try {
+		file.write(data);
+	} catch (FileException& e) {
+		throw MSXException("Could not write \"", filename, "\": ", e.getMessage());
+	}
+	offset += data.size();
+}
+
+ReplayFileWriter::IndexEntry ReplayFileWriter::writeBlock(std::string_view xml)
+{
+	auto len = xml.size();
+	auto dstLen = compressBound(uLong(len));
+	buffer.resize(dstLen);
+	// Level 6 instead of 9: the snapshots mostly contain blobs that are
+	// already compressed (see serialize_blob()).
+	if (compress2(buffer.data(), &dstLen,
+	              reinterpret_cast<const Bytef*>(xml.data()), uLong(len), 6)
+	    != Z_OK) {
+		throw MSXException("Error while compressing replay data.");
+	}
+	IndexEntry result{0, offset, dstLen, len};
+	write(std::span{buffer.data(), dstLen});
+	return result;
+}
+
+void ReplayFileWriter::addSnapshot(EmuTime::param time, std::string_view xml)
+{
+	assert(!finished);
+	auto entry = writeBlock(xml);
+	entry.time = (time - EmuTime::zero()).length();
+	index.push_back(entry);
+}
+
+void ReplayFileWriter::finish(std::string_view logXml)
+{
+	assert(!finished);
+	auto log = writeBlock(logXml);
+
+	std::vector<uint8_t> buf;
+	auto appendL32 = [&](uint32_t x) {
+		std::array<uint8_t, 4> tmp; Endian::write_UA_L32(tmp.data(), x);
+		buf.insert(buf.end(), tmp.begin(), tmp.end());
+	};
+	auto appendL64 = [&](uint64_t x) {
+		std::array<uint8_t, 8> tmp; Endian::write_UA_L64(tmp.data(), x);
+		buf.insert(buf.end(), tmp.begin(), tmp.end());
+	};
+	auto indexOffset = offset;
+	appendL32(uint32_t(index.size()));
+	for (const auto& e : index) {
+		appendL64(e.time);
+		appendL64(e.offset);
+		appendL64(e.compressedSize);
+		appendL64(e.size);
+	}
+	appendL64(log.offset);
+	appendL64(log.compressedSize);
+	appendL64(log.size);
+
+	appendL64(indexOffset);
+	buf.insert(buf.end(), TRAILER_MAGIC.begin(), TRAILER_MAGIC.end());
+	write(buf);
+
+	// Errors while flushing the last buffered data are not reported by
+	// close(), so check the size of the result.
+	file.close();
+	if (auto st = FileOperations::getStat(tmpFilename);
+	    !st || (uint64_t(st->st_size) != offset)) {
+		throw MSXException("Could not write \"", filename, "\": incomplete write");
+	}
+	// Rename (instead of overwrite) the old file. It may still be
+	// memory-mapped by a ReplayFileReader (e.g. when saving a replay
+	// under the same name as it was loaded from).
+	if (FileOperations::rename(tmpFilename, filename) != 0) {
+		throw MSXException("Could not write \"", filename, "\": rename failed");
+	}
+	finished = true;
+}
+
+
+// class ReplayFileReader
+
+bool ReplayFileReader::isReplayFile(std::span<const uint8_t> data)
+{
+	return (data.size() >= HEADER_SIZE) &&
+	       ranges::equal(data.subspan(0, HEADER_MAGIC.size()), HEADER_MAGIC);
+}
+
+ReplayFileReader::ReplayFileReader(File file_, std::string name_)
+	: file(std::move(file_))
+	, name(std::move(name_))
+{
+	auto data = file.mmap();
+	auto error = [&](std::string_view msg) {
+		return MSXException("Invalid replay file \"", name, "\": ", msg);
+	};
+	if (!isReplayFile(data) || (data.size() < (HEADER_SIZE + TRAILER_SIZE))) {
+		throw error("bad header");
+	}
+	if (auto version = Endian::read_UA_L32(&data[HEADER_MAGIC.size()]);
+	    version != FORMAT_VERSION) {
+		throw error(strCat("unsupported version ", version));
+	}
+	auto trailer = data.subspan(data.size() - TRAILER_SIZE);
+	if (!ranges::equal(trailer.subspan(8), TRAILER_MAGIC)) {
+		throw error("bad trailer (truncated file?)");
+	}
+
+	// Everything between header and index, bounds checked
+	auto limit = data.size() - TRAILER_SIZE;
+	auto indexOffset = Endian::read_UA_L64(trailer.data());
+	if ((indexOffset < HEADER_SIZE) || (indexOffset > limit) ||
+	    ((limit - indexOffset) < 4)) {
+		throw error("bad index offset");
+	}
+	auto index = data.subspan(indexOffset, limit - indexOffset);
+	auto num = Endian::read_UA_L32(index.data());
+	index = index.subspan(4);
+	if (index.size() != (num * (8 + ENTRY_SIZE) + ENTRY_SIZE)) {
+		throw error("bad index size");
+	}
+	auto readEntry = [&](std::span<const uint8_t> e) {
+		auto offset         = Endian::read_UA_L64(&e[ 0]);
+		auto compressedSize = Endian::read_UA_L64(&e[ 8]);
+		auto size           = Endian::read_UA_L64(&e[16]);
+		if ((offset < HEADER_SIZE) || (offset > indexOffset) ||
+		    (compressedSize > (indexOffset - offset)) ||
+		    (size > (compressedSize * 1032))) { // max zlib compression ratio
+			throw error("bad index entry");
+		}
+		Entry result;
+		result.data = data.subspan(offset, compressedSize);
+		result.size = size;
+		return result;
+	};
+	snapshots.reserve(num);
+	repeat(num, [&] {
+		auto entry = readEntry(index.subspan(8, ENTRY_SIZE));
+		entry.time = EmuTime::zero() + EmuDuration(Endian::read_UA_L64(index.data()));
+		if (!snapshots.empty() && (entry.time < snapshots.back().time)) {
+			throw error("snapshots are not sorted");
+		}
+		snapshots.push_back(entry);
+		index = index.subspan(8 + ENTRY_SIZE);
+	});
+	if (snapshots.empty()) {
+		throw error("no snapshots");
+	}
+	log = readEntry(index);
+}
+
+std::string ReplayFileReader::decompress(const Entry& entry) const
+{
+	std::string result(entry.size, '\0');
+	auto dstLen = uLongf(entry.size);
+	if ((uncompress(reinterpret_cast<Bytef*>(result.data()), &dstLen,
+	                entry.data.data(), uLong(entry.data.size())) != Z_OK) ||
+	    (dstLen != entry.size)) {
+		throw MSXException("Invalid replay file \"", name, "\": error while decompressing");
+	}
+	return result;
+}
+
+} // namespace openmsx
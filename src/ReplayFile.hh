@@ -0,0 +1,103 @@
+#ifndef REPLAYFILE_HH
+#define REPLAYFILE_HH
+
+#include "EmuTime.hh"
+#include "File.hh"
+#include "zstring_view.hh"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+/** Container format for replay ('.omr') files.
+ *
+ * Older openMSX versions stored a replay as one (gzipped) XML document that
+ * contains all snapshots and the event log. Such a file must be parsed
+ * completely (and all snapshots must be instantiated) before anything can be
+ * shown. In this format each snapshot is compressed separately, so that when
+ * loading a replay, only the snapshot(s) that are actually needed have to be
+ * decoded. Layout (all integers are little endian):
+ *
+ *   header:  8 bytes magic "oMSX-rpl", 4 bytes format version
+ *   blocks:  zlib compressed XML documents, one for each snapshot (same
+ *            format as a savestate) and one for the event log
+ *   index:   4 bytes number of snapshots, then for each snapshot
+ *              8 bytes EmuTime of the snapshot, 8 bytes offset, 8 bytes
+ *              compressed size, 8 bytes uncompressed size
+ *            followed by offset and compressed/uncompressed size of the log
+ *   trailer: 8 bytes offset of the index, 8 bytes magic "oMSX-idx"
+ *
+ * The content of the blocks is still XML (and not e.g. the binary format of
+ * MemOutputArchive) to keep the files loadable by future openMSX versions.
+ */
+class ReplayFileWriter
+{
+public:
+	/** Blocks are written (streamed) to a temporary file in the same
+	  * directory as 'filename'. Only when finish() succeeds that file
+	  * replaces 'filename', so on error an existing file is kept.
+	  * Throws MSXException on error (also the other methods). */
+	explicit ReplayFileWriter(std::string filename);
+	~ReplayFileWriter();
+
+	void addSnapshot(EmuTime::param time, std::string_view xml);
+	void finish(std::string_view logXml);
+
+private:
+	struct IndexEntry {
+		uint64_t time; // unused for the log
+		uint64_t offset;
+		uint64_t compressedSize;
+		uint64_t size;
+	};
+	[[nodiscard]] IndexEntry writeBlock(std::string_view xml);
+	void write(std::span<const uint8_t> data);
+
+	std::string filename;
+	std::string tmpFilename;
+	File file;
+	uint64_t offset = 0;
+	std::vector<IndexEntry> index;
+	std::vector<uint8_t> buffer; // reused for each compressed block
+	bool finished = false;
+};
+
+class ReplayFileReader
+{
+public:
+	// Is the given file content in this format? Note: returns false for
+	// the older XML-based format.
+	[[nodiscard]] static bool isReplayFile(std::span<const uint8_t> data);
+
+	// The file stays memory-mapped during the lifetime of this object.
+	// Throws MSXException when the file is corrupt.
+	ReplayFileReader(File file, std::string name);
+
+	[[nodiscard]] const std::string& getName() const { return name; }
+	[[nodiscard]] size_t getNumSnapshots() const { return snapshots.size(); }
+	[[nodiscard]] EmuTime::param getSnapshotTime(size_t i) const { return snapshots[i].time; }
+
+	// Decompress the XML document of a snapshot or the event log.
+	[[nodiscard]] std::string getSnapshot(size_t i) const { return decompress(snapshots[i]); }
+	[[nodiscard]] std::string getLog() const { return decompress(log); }
+
+private:
+	struct Entry {
+		EmuTime time = EmuTime::zero(); // unused for the log
+		std::span<const uint8_t> data; // compressed
+		uint64_t size; // uncompressed
+	};
+	[[nodiscard]] std::string decompress(const Entry& entry) const;
+
+	File file;
+	std::string name;
+	std::vector<Entry> snapshots;
+	Entry log;
+};
+
+} // namespace openmsx
+
+#endif
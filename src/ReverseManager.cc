@@ -18,18 +18,23 @@
 #include "MSXCliComm.hh"
 #include "Display.hh"
 #include "Reactor.hh"
+#include "ReplayFile.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
+#include "hash_map.hh"
 #include "narrow.hh"
 #include "one_of.hh"
 #include "ranges.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <iomanip>
+#include <iterator>
+#include <limits>
 
 namespace openmsx {
 
@@ -66,7 +71,7 @@ struct Replay
 	// is interesting for the TAS community (see tasvideos.org). It's an
 	// indication of the effort it took to create the replay. Note that
 	// there is no way to verify this number.
-	unsigned reRecordCount;
+	unsigned reRecordCount = 0;
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version)
@@ -96,6 +101,25 @@ struct Replay
 };
 SERIALIZE_CLASS_VERSION(Replay, 4);
 
+// In the binary replay format (see ReplayFile.hh) the snapshots are stored
+// separately. This is the remaining part: the event log plus some meta-data
+// (see Replay for the meaning of these fields).
+struct ReplayLog
+{
+	ReverseManager::Events* events;
+	EmuTime currentTime = EmuTime::zero();
+	unsigned reRecordCount = 0;
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned /*version*/)
+	{
+		ar.serialize("events",        *events,
+		             "currentTime",   currentTime,
+		             "reRecordCount", reRecordCount);
+	}
+};
+SERIALIZE_CLASS_VERSION(ReplayLog, 1);
+
 
 // struct ReverseHistory
 
@@ -137,6 +161,13 @@ ReverseManager::ReverseManager(MSXMotherBoard& motherBoard_)
 	, motherBoard(motherBoard_)
 	, eventDistributor(motherBoard.getReactor().getEventDistributor())
 	, reverseCmd(motherBoard.getCommandController())
+	, memoryBudgetSetting(motherBoard.getCommandController(),
+		"reverse_memory_budget",
+		"Upper limit (in MB) for the memory used by the reverse "
+		"snapshots of this machine, 0 means unlimited. When the limit "
+		"is exceeded, snapshots are dropped, mostly from the distant "
+		"past. The very first snapshot is always kept.",
+		0, 0, 1024 * 1024)
 {
 	eventDistributor.registerEventListener(EventType::TAKE_REVERSE_SNAPSHOT, *this);
 
@@ -226,6 +257,15 @@ std::vector<double> ReverseManager::getSnapshotTimes() const
 	}));
 }
 
+size_t ReverseManager::getMemoryUsage() const
+{
+	return history.getMemoryUsage();
+}
+size_t ReverseManager::getMemoryBudget() const
+{
+	return size_t(memoryBudgetSetting.getInt()) * 1024 * 1024;
+}
+
 void ReverseManager::status(TclObject& result) const
 {
 	result.addDictKeyValue("status", !isCollecting() ? "disabled"
@@ -247,6 +287,10 @@ void ReverseManager::status(TclObject& result) const
 	}
 	EmuTime le(isCollecting() && (lastEvent != rend(history.events)) ? (*lastEvent)->getTime() : EmuTime::zero());
 	result.addDictKeyValue("last_event", (le - EmuTime::zero()).toDouble());
+
+	// in MB, same unit as the 'reverse_memory_budget' setting
+	result.addDictKeyValue("memory", double(getMemoryUsage()) / (1024 * 1024));
+	result.addDictKeyValue("memory_budget", memoryBudgetSetting.getInt());
 }
 
 void ReverseManager::debugInfo(TclObject& result) const
@@ -263,7 +307,8 @@ void ReverseManager::debugInfo(TclObject& result) const
 		          " (next event index: ", chunk.eventCount, ")\n");
 		totalSize += chunk.size;
 	}
-	strAppend(res, "total size: ", totalSize, '\n');
+	strAppend(res, "total size: ", totalSize, '\n',
+	          "total memory (including delta blocks): ", getMemoryUsage(), '\n');
 	result = res;
 }
 
@@ -408,10 +453,7 @@ void ReverseManager::goTo(
 			// suppress messages we'd get by deserializing (and
 			// thus instantiating the parts of) the new board
 			newBoard->getMSXCliComm().setSuppressMessages(true);
-			MemInputArchive in(chunk.savestate.data(),
-					   chunk.size,
-					   chunk.deltaBlocks);
-			in.serialize("machine", *newBoard);
+			restoreSnapshot(chunk, *newBoard);
 
 			if (eventDelay) {
 				// Handle all events that are scheduled, but not yet
@@ -564,24 +606,9 @@ void ReverseManager::saveReplay(
 	auto filename = FileOperations::parseCommandFileArgument(
 		filenameArg, REPLAY_DIR, "openmsx", ".omr");
 
-	auto& reactor = motherBoard.getReactor();
-	Replay replay(reactor);
-	replay.reRecordCount = reRecordCount;
-
-	// store current time (possibly somewhere in the middle of the timeline)
-	// so that on load we can go back there
-	replay.currentTime = getCurrentTime();
-
-	// restore first snapshot to be able to serialize it to a file
-	auto initialBoard = reactor.createEmptyMotherBoard();
-	MemInputArchive in(begin(chunks)->second.savestate.data(),
-	                   begin(chunks)->second.size,
-			   begin(chunks)->second.deltaBlocks);
-	in.serialize("machine", *initialBoard);
-	replay.motherBoards.push_back(std::move(initialBoard));
-
+	// determine which snapshots to put in the replay, always the first
+	std::vector<const ReverseChunk*> selected = {&begin(chunks)->second};
 	if (maxNofExtraSnapshots > 0) {
-		// determine which extra snapshots to put in the replay
 		const auto& startTime = begin(chunks)->second.time;
 		// for the end time, try to take MAX_DIST_1_BEFORE_LAST_SNAPSHOT
 		// seconds before the normal end time so that we get an extra snapshot
@@ -602,12 +629,7 @@ void ReverseManager::saveReplay(
 				assert(it->second.time <= nextPartitionEnd);
 				if (it != lastAddedIt) {
 					// this is a new one, add it to the list of snapshots
-					Reactor::Board board = reactor.createEmptyMotherBoard();
-					MemInputArchive in2(it->second.savestate.data(),
-							    it->second.size,
-							    it->second.deltaBlocks);
-					in2.serialize("machine", *board);
-					replay.motherBoards.push_back(std::move(board));
+					selected.push_back(&it->second);
 					lastAddedIt = it;
 				}
 				++it;
@@ -619,6 +641,20 @@ void ReverseManager::saveReplay(
 		assert(lastAddedIt == std::prev(end(chunks))); // last snapshot must be included
 	}
 
+	// Restore the selected snapshots (one at a time) to be able to
+	// serialize them to the file.
+	auto& reactor = motherBoard.getReactor();
+	ReplayFileWriter writer(filename);
+	for (const auto* chunk : selected) {
+		auto board = reactor.createEmptyMotherBoard();
+		restoreSnapshot(*chunk, *board);
+		std::string xml;
+		XmlOutputArchive out(xml);
+		out.serialize("machine", *board);
+		out.close();
+		writer.addSnapshot(board->getCurrentTime(), xml);
+	}
+
 	// add sentinel when there isn't one yet
 	bool addSentinel = history.events.empty() ||
 		!dynamic_cast<EndLogEvent*>(history.events.back().get());
@@ -627,10 +663,13 @@ void ReverseManager::saveReplay(
 		history.events.push_back(std::make_unique<EndLogEvent>(
 			getCurrentTime()));
 	}
+	// store current time (possibly somewhere in the middle of the timeline)
+	// so that on load we can go back there
+	ReplayLog log{&history.events, getCurrentTime(), reRecordCount};
+	std::string logXml;
 	try {
-		XmlOutputArchive out(filename);
-		replay.events = &history.events;
-		out.serialize("replay", replay);
+		XmlOutputArchive out(logXml);
+		out.serialize("log", log);
 		out.close();
 	} catch (MSXException&) {
 		if (addSentinel) {
@@ -647,6 +686,8 @@ void ReverseManager::saveReplay(
 		history.events.pop_back();
 	}
 
+	writer.finish(logXml);
+
 	result = tmpStrCat("Saved replay to ", filename);
 }
 
@@ -682,13 +723,73 @@ void ReverseManager::loadReplay(
 	}}}
 
 	// restore replay
-	auto& reactor = motherBoard.getReactor();
-	Replay replay(reactor);
-	Events events;
-	replay.events = &events;
+	ReverseHistory newHistory;
+	auto saveTime = EmuTime::zero();
+	unsigned newReRecordCount = 0;
+	unsigned replayIdx = 0;
+	auto addChunk = [&](ReverseChunk&& newChunk) {
+		// update replayIdx
+		// TODO: should we use <= instead??
+		const auto& newEvents = newHistory.events;
+		while (replayIdx < newEvents.size() &&
+		       (newEvents[replayIdx]->getTime() < newChunk.time)) {
+			replayIdx++;
+		}
+		newChunk.eventCount = replayIdx;
+
+		newHistory.chunks[newHistory.getNextSeqNum(newChunk.time)] =
+			std::move(newChunk);
+	};
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("replay", replay);
+		File file(filename);
+		auto data = file.mmap();
+		if (ReplayFileReader::isReplayFile(data)) {
+			auto reader = std::make_shared<const ReplayFileReader>(
+				std::move(file), filename);
+			ReplayLog log{&newHistory.events};
+			XmlInputArchive in(filename, reader->getLog());
+			in.serialize("log", log);
+			saveTime = log.currentTime;
+			newReRecordCount = log.reRecordCount;
+
+			// Don't decode the snapshots yet, that's only needed
+			// when we actually go to (near) that point in time.
+			for (auto i : xrange(reader->getNumSnapshots())) {
+				ReverseChunk newChunk;
+				newChunk.time = reader->getSnapshotTime(i);
+				newChunk.replayFile = reader;
+				newChunk.replayFileIdx = narrow<unsigned>(i);
+				addChunk(std::move(newChunk));
+			}
+		} else {
+			// Older format: a single xml document that contains
+			// all snapshots and the event log.
+			auto& reactor = motherBoard.getReactor();
+			Replay replay(reactor);
+			replay.events = &newHistory.events;
+			XmlInputArchive in(filename, std::string_view(
+				reinterpret_cast<const char*>(data.data()), data.size()));
+			in.serialize("replay", replay);
+			saveTime = replay.currentTime;
+
+			assert(!replay.motherBoards.empty());
+			const auto& firstManager = replay.motherBoards[0]->getReverseManager();
+			newReRecordCount = (firstManager.reRecordCount == 0)
+				? replay.reRecordCount // serialize Replay version >= 4
+				: firstManager.reRecordCount; // initialized via call from
+				// MSXMotherBoard to setReRecordCount()
+
+			for (auto& m : replay.motherBoards) {
+				ReverseChunk newChunk;
+				newChunk.time = m->getCurrentTime();
+
+				MemOutputArchive out(newHistory.lastDeltaBlocks,
+				                     newChunk.deltaBlocks, false);
+				out.serialize("machine", *m);
+				newChunk.savestate = out.releaseBuffer(newChunk.size);
+				addChunk(std::move(newChunk));
+			}
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load replay, bad file format: ",
 		                       e.getMessage());
@@ -703,7 +804,7 @@ void ReverseManager::loadReplay(
 	} else if (*where == "end") {
 		destination = EmuTime::infinity();
 	} else if (*where == "savetime") {
-		destination = replay.currentTime;
+		destination = saveTime;
 	} else {
 		destination += EmuDuration(where->getDouble(interp));
 	}
@@ -713,54 +814,29 @@ void ReverseManager::loadReplay(
 	// now we can change the view only mode
 	motherBoard.getStateChangeDistributor().setViewOnlyMode(enableViewOnly);
 
-	assert(!replay.motherBoards.empty());
-	auto& newReverseManager = replay.motherBoards[0]->getReverseManager();
-	auto& newHistory = newReverseManager.history;
-
-	if (newReverseManager.reRecordCount == 0) {
-		// serialize Replay version >= 4
-		newReverseManager.reRecordCount = replay.reRecordCount;
-	} else {
-		// newReverseManager.reRecordCount is initialized via
-		// call from MSXMotherBoard to setReRecordCount()
-	}
-
-	// Restore event log
-	swap(newHistory.events, events);
-	auto& newEvents = newHistory.events;
-
-	// Restore snapshots
-	unsigned replayIdx = 0;
-	for (auto& m : replay.motherBoards) {
-		ReverseChunk newChunk;
-		newChunk.time = m->getCurrentTime();
-
-		MemOutputArchive out(newHistory.lastDeltaBlocks,
-		                     newChunk.deltaBlocks, false);
-		out.serialize("machine", *m);
-		newChunk.savestate = out.releaseBuffer(newChunk.size);
-
-		// update replayIdx
-		// TODO: should we use <= instead??
-		while (replayIdx < newEvents.size() &&
-		       (newEvents[replayIdx]->getTime() < newChunk.time)) {
-			replayIdx++;
-		}
-		newChunk.eventCount = replayIdx;
-
-		newHistory.chunks[newHistory.getNextSeqNum(newChunk.time)] =
-			std::move(newChunk);
-	}
-
 	// Note: until this point we didn't make any changes to the current
 	// ReverseManager/MSXMotherBoard yet
-	reRecordCount = newReverseManager.reRecordCount;
+	reRecordCount = newReRecordCount;
 	bool noVideo = false;
 	goTo(destination, noVideo, newHistory, false); // move to different time-line
 
 	result = tmpStrCat("Loaded replay from ", filename);
 }
 
+void ReverseManager::restoreSnapshot(const ReverseChunk& chunk, MSXMotherBoard& board)
+{
+	if (chunk.replayFile) {
+		const auto& file = *chunk.replayFile;
+		XmlInputArchive in(file.getName(), file.getSnapshot(chunk.replayFileIdx));
+		in.serialize("machine", board);
+	} else {
+		MemInputArchive in(chunk.savestate.data(),
+		                   chunk.size,
+		                   chunk.deltaBlocks);
+		in.serialize("machine", board);
+	}
+}
+
 void ReverseManager::transferHistory(ReverseHistory& oldHistory,
                                      unsigned oldEventCount)
 {
@@ -852,6 +928,25 @@ int ReverseManager::signalEvent(const Event& event)
 	return 0;
 }
 
+size_t ReverseManager::ReverseHistory::getMemoryUsage() const
+{
+	// DeltaBlocks can be shared between snapshots (and a DeltaBlockDiff
+	// shares its reference block with other diffs), count them only once.
+	std::vector<const DeltaBlock*> blocks;
+	size_t result = 0;
+	for (const auto& [idx, chunk] : chunks) {
+		result += chunk.size;
+		for (const auto& b : chunk.deltaBlocks) {
+			blocks.push_back(b.get());
+			if (const auto* ref = b->getReference()) blocks.push_back(ref);
+		}
+	}
+	ranges::sort(blocks);
+	blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+	for (const auto* b : blocks) result += b->getMemorySize();
+	return result;
+}
+
 unsigned ReverseManager::ReverseHistory::getNextSeqNum(EmuTime::param time) const
 {
 	if (chunks.empty()) {
@@ -878,11 +973,14 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	// actually create new snapshot
 	ReverseChunk& newChunk = history.chunks[seqNum];
 	newChunk.deltaBlocks.clear();
+	newChunk.replayFile.reset();
 	MemOutputArchive out(history.lastDeltaBlocks, newChunk.deltaBlocks, true);
 	out.serialize("machine", motherBoard);
 	newChunk.time = time;
 	newChunk.savestate = out.releaseBuffer(newChunk.size);
 	newChunk.eventCount = replayIndex;
+
+	dropSnapshotsOverBudget();
 }
 
 void ReverseManager::replayNextEvent()
@@ -945,6 +1043,65 @@ void ReverseManager::dropOldSnapshots(unsigned count)
 	}
 }
 
+/* Drop snapshots until the memory usage is below the configured budget.
+ * The snapshots that are dropped are the ones that leave the smallest gap
+ * relative to their age. This keeps the same pattern as dropOldSnapshots():
+ * a high density of snapshots in recent history, and a lower density further
+ * in the past. The oldest and the most recent snapshot are never dropped.
+ */
+void ReverseManager::dropSnapshotsOverBudget()
+{
+	auto budget = getMemoryBudget();
+	if (budget == 0) return;
+
+	auto& chunks = history.chunks;
+	if (chunks.size() <= 2) return;
+
+	// Calculate the memory usage only once (the same way as
+	// getMemoryUsage()), but also count how many times each DeltaBlock is
+	// used. Dropping a chunk then only subtracts the size of the blocks
+	// that are no longer used by any of the remaining chunks.
+	auto forEachBlock = [](const ReverseChunk& chunk, auto op) {
+		for (const auto& b : chunk.deltaBlocks) {
+			op(b.get());
+			if (const auto* ref = b->getReference()) op(ref);
+		}
+	};
+	hash_map<const DeltaBlock*, unsigned> uses;
+	size_t usage = 0;
+	for (const auto& [idx, chunk] : chunks) {
+		usage += chunk.size;
+		forEachBlock(chunk, [&](const DeltaBlock* b) {
+			if (uses[b]++ == 0) usage += b->getMemorySize();
+		});
+	}
+
+	while ((chunks.size() > 2) && (usage > budget)) {
+		// Measure age relative to the most recent snapshot (not the
+		// current time), during replay there can be snapshots in the
+		// 'future'.
+		auto last = std::prev(end(chunks));
+		auto newest = last->second.time;
+		auto best = end(chunks);
+		double bestCost = std::numeric_limits<double>::infinity();
+		for (auto it = std::next(begin(chunks)); it != last; ++it) {
+			auto gap = (std::next(it)->second.time - std::prev(it)->second.time).toDouble();
+			auto age = (newest - it->second.time).toDouble() + SNAPSHOT_PERIOD;
+			auto cost = gap / age;
+			if (cost < bestCost) {
+				bestCost = cost;
+				best = it;
+			}
+		}
+		assert(best != end(chunks));
+		usage -= best->second.size;
+		forEachBlock(best->second, [&](const DeltaBlock* b) {
+			if (--uses[b] == 0) usage -= b->getMemorySize();
+		});
+		chunks.erase(best);
+	}
+}
+
 void ReverseManager::schedule(EmuTime::param time)
 {
 	syncNewSnapshot.setSyncPoint(time + EmuDuration(SNAPSHOT_PERIOD));
@@ -5,6 +5,7 @@
 #include "EventListener.hh"
 #include "Command.hh"
 #include "EmuTime.hh"
+#include "IntegerSetting.hh"
 #include "MemBuffer.hh"
 #include "DeltaBlock.hh"
 #include "outer.hh"
@@ -23,6 +24,7 @@ class EventDistributor;
 class Interpreter;
 class MSXMotherBoard;
 class Keyboard;
+class ReplayFileReader;
 class StateChange;
 class TclObject;
 
@@ -73,6 +75,11 @@ public:
 	[[nodiscard]] double getCurrent() const;
 	[[nodiscard]] std::vector<double> getSnapshotTimes() const;
 
+	// Memory (in bytes) used by the snapshots, and the configured upper
+	// limit for it (0 means unlimited).
+	[[nodiscard]] size_t getMemoryUsage() const;
+	[[nodiscard]] size_t getMemoryBudget() const;
+
 private:
 	struct ReverseChunk {
 		ReverseChunk() : time(EmuTime::zero()) {}
@@ -80,7 +87,13 @@ private:
 		EmuTime time;
 		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
 		MemBuffer<uint8_t> savestate;
-		size_t size;
+		size_t size = 0;
+
+		// Snapshots loaded from a replay file are only decoded when
+		// they're actually needed. Until then 'savestate' is empty and
+		// the snapshot is located in 'replayFile'.
+		std::shared_ptr<const ReplayFileReader> replayFile;
+		unsigned replayFileIdx = 0;
 
 		// Number of recorded events (or replay index) when this
 		// snapshot was created. So when going back replay should
@@ -94,6 +107,7 @@ private:
 		void swap(ReverseHistory& other) noexcept;
 		void clear();
 		[[nodiscard]] unsigned getNextSeqNum(EmuTime::param time) const;
+		[[nodiscard]] size_t getMemoryUsage() const;
 
 		Chunks chunks;
 		Events events;
@@ -110,6 +124,7 @@ private:
 	                std::span<const TclObject> tokens, TclObject& result);
 	void loadReplay(Interpreter& interp,
 	                std::span<const TclObject> tokens, TclObject& result);
+	static void restoreSnapshot(const ReverseChunk& chunk, MSXMotherBoard& board);
 
 	void signalStopReplay(EmuTime::param time);
 	[[nodiscard]] EmuTime::param getEndTime(const ReverseHistory& history) const;
@@ -123,6 +138,7 @@ private:
 	void schedule(EmuTime::param time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
+	void dropSnapshotsOverBudget();
 
 	// Schedulable
 	struct SyncNewSnapshot final : Schedulable {
@@ -160,6 +176,8 @@ private:
 		void tabCompletion(std::vector<std::string>& tokens) const override;
 	} reverseCmd;
 
+	IntegerSetting memoryBudgetSetting; // in MB
+
 	Keyboard* keyboard = nullptr;
 	EventDelay* eventDelay = nullptr;
 	ReverseHistory history;
@@ -170,6 +188,7 @@ private:
 	unsigned reRecordCount = 0;
 
 	friend struct Replay;
+	friend struct ReplayLog;
 };
 
 } // namespace openmsx
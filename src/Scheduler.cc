@@ -37,10 +37,13 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 	assert(time >= scheduleTime);
 
 	// Push sync point into queue.
+#ifdef SCHEDULER_USE_HEAP
+	queue.insert(SynchronizationPoint(time, &device));
+#else
 	queue.insert(SynchronizationPoint(time, &device),
 	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity()); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	             LessSyncPoint{});
+#endif
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -54,6 +57,10 @@ Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 {
 	SyncPoints result;
 	ranges::copy_if(queue, back_inserter(result), EqualSchedulable(device));
+#ifdef SCHEDULER_USE_HEAP
+	// heap is not sorted, but the result should be
+	ranges::stable_sort(result, LessSyncPoint{});
+#endif
 	return result;
 }
 
@@ -73,9 +80,8 @@ bool Scheduler::pendingSyncPoint(const Schedulable& device,
                                  EmuTime& result) const
 {
 	assert(Thread::isMainThread());
-	if (auto it = ranges::find(queue, &device, &SynchronizationPoint::getDevice);
-	    it != std::end(queue)) {
-		result = it->getTime();
+	if (const auto* sp = queue.find(EqualSchedulable(device))) {
+		result = sp->getTime();
 		return true;
 	}
 	return false;
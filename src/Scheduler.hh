@@ -2,6 +2,7 @@
 #define SCHEDULER_HH
 
 #include "EmuTime.hh"
+#include "SchedulerHeap.hh"
 #include "SchedulerQueue.hh"
 #include <vector>
 
@@ -108,10 +109,22 @@ private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
 
 private:
-	/** Vector used as heap, not a priority queue because that
-	  * doesn't allow removal of non-top element.
+	struct LessSyncPoint {
+		[[nodiscard]] bool operator()(const SynchronizationPoint& x,
+		                              const SynchronizationPoint& y) const {
+			return x.getTime() < y.getTime();
+		}
+	};
+	/** By default a SchedulerQueue (a sorted array) is used. Define
+	  * SCHEDULER_USE_HEAP to use a SchedulerHeap instead, this may be
+	  * faster when there are many sync points. (Not a priority queue
+	  * because that doesn't allow removal of non-top elements.)
 	  */
+#ifdef SCHEDULER_USE_HEAP
+	SchedulerHeap<SynchronizationPoint, LessSyncPoint> queue;
+#else
 	SchedulerQueue<SynchronizationPoint> queue;
+#endif
 	EmuTime scheduleTime = EmuTime::zero();
 	MSXCPU* cpu = nullptr;
 	bool scheduleInProgress = false;
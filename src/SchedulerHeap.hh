@@ -0,0 +1,173 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue: a 4-ary min-heap. Inserting or removing
+// an element is O(log N) instead of (worst case) O(N), but for the typical
+// Scheduler usage pattern (remove the smallest element, insert a new element
+// slightly bigger) SchedulerQueue is often O(1). Which one is faster depends
+// on the number of elements and on the usage pattern. See the benchmark in
+// unittest/SchedulerQueue_test.cc.
+//
+// Like SchedulerQueue, equivalent elements (according to LESS) are ordered in
+// insertion order (FIFO). To achieve this each element gets a sequence number.
+//
+// Iterating over a SchedulerHeap visits all elements, but not in sorted order.
+template<typename T, typename LESS> class SchedulerHeap
+{
+public:
+	[[nodiscard]] size_t size()  const { return items.size(); }
+	[[nodiscard]] bool   empty() const { return items.empty(); }
+
+	// Returns reference to the smallest element.
+	[[nodiscard]]       T& front()       { assert(!empty()); return items.front(); }
+	[[nodiscard]] const T& front() const { assert(!empty()); return items.front(); }
+
+	[[nodiscard]]       T* begin()       { return items.data(); }
+	[[nodiscard]] const T* begin() const { return items.data(); }
+	[[nodiscard]]       T* end()         { return items.data() + items.size(); }
+	[[nodiscard]] const T* end()   const { return items.data() + items.size(); }
+
+	// Insert new element.
+	void insert(const T& t)
+	{
+		items.push_back(t);
+		seqs.push_back(nextSeq++);
+		siftUp(items.size() - 1);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		removeAt(0);
+	}
+
+	// Returns the smallest element for which the given predicate returns
+	// true, or nullptr if there's no such element.
+	[[nodiscard]] const T* find(std::predicate<T> auto p) const
+	{
+		auto i = findIndex(p);
+		return (i == NONE) ? nullptr : &items[i];
+	}
+
+	// Remove the smallest element for which the given predicate returns true.
+	bool remove(std::predicate<T> auto p)
+	{
+		auto i = findIndex(p);
+		if (i == NONE) return false;
+		removeAt(i);
+		return true;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	void remove_all(std::predicate<T> auto p)
+	{
+		size_t j = 0;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (p(items[i])) continue;
+			if (i != j) {
+				items[j] = std::move(items[i]);
+				seqs[j] = seqs[i];
+			}
+			++j;
+		}
+		if (j == items.size()) return;
+		items.resize(j);
+		seqs.resize(j);
+		// restore the heap property
+		if (j > 1) {
+			for (size_t i = (j - 2) / ARITY + 1; i-- > 0; /**/) {
+				siftDown(i);
+			}
+		}
+	}
+
+private:
+	static constexpr size_t ARITY = 4;
+	static constexpr size_t NONE = size_t(-1);
+
+	[[nodiscard]] bool less(size_t i, size_t j) const
+	{
+		LESS l;
+		if (l(items[i], items[j])) return true;
+		if (l(items[j], items[i])) return false;
+		return seqs[i] < seqs[j];
+	}
+
+	void swapAt(size_t i, size_t j)
+	{
+		std::swap(items[i], items[j]);
+		std::swap(seqs[i], seqs[j]);
+	}
+
+	void siftUp(size_t i)
+	{
+		while (i != 0) {
+			size_t parent = (i - 1) / ARITY;
+			if (!less(i, parent)) break;
+			swapAt(i, parent);
+			i = parent;
+		}
+	}
+
+	void siftDown(size_t i)
+	{
+		size_t n = items.size();
+		while (true) {
+			size_t first = i * ARITY + 1;
+			if (first >= n) break;
+			size_t last = std::min(first + ARITY, n);
+			size_t smallest = first;
+			for (size_t c = first + 1; c < last; ++c) {
+				if (less(c, smallest)) smallest = c;
+			}
+			if (!less(smallest, i)) break;
+			swapAt(i, smallest);
+			i = smallest;
+		}
+	}
+
+	void removeAt(size_t i)
+	{
+		size_t last = items.size() - 1;
+		if (i != last) {
+			swapAt(i, last);
+		}
+		items.pop_back();
+		seqs.pop_back();
+		if (i != last) {
+			siftDown(i);
+			siftUp(i);
+		}
+	}
+
+	[[nodiscard]] size_t findIndex(std::predicate<T> auto p) const
+	{
+		size_t result = NONE;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (p(items[i]) && ((result == NONE) || less(i, result))) {
+				result = i;
+			}
+		}
+		return result;
+	}
+
+private:
+	// Invariant: items.size() == seqs.size()
+	std::vector<T> items;
+	std::vector<uint64_t> seqs; // insertion order, for stable ordering
+	uint64_t nextSeq = 0;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
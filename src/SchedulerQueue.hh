@@ -86,6 +86,14 @@ public:
 		++useBegin;
 	}
 
+	// Returns the first (smallest) element for which the given predicate
+	// returns true, or nullptr if there's no such element.
+	[[nodiscard]] const T* find(std::predicate<T> auto p) const
+	{
+		const T* it = std::find_if(useBegin, useEnd, p);
+		return (it == useEnd) ? nullptr : it;
+	}
+
 	// Remove the first element for which the given predicate returns true.
 	bool remove(std::predicate<T> auto p)
 	{
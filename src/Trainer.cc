@@ -0,0 +1,267 @@
+#include "Trainer.hh"
+#include "CommandException.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMotherBoard.hh"
+#include "TclObject.hh"
+#include "VDP.hh"
+#include "narrow.hh"
+#include "outer.hh"
+#include "ranges.hh"
+#include "serialize.hh"
+#include "serialize_stl.hh"
+#include "view.hh"
+#include "xrange.hh"
+#include <array>
+
+namespace openmsx {
+
+Trainer::Trainer(MSXMotherBoard& motherBoard_)
+	: Schedulable(motherBoard_.getScheduler())
+	, motherBoard(motherBoard_)
+	, command(motherBoard_)
+{
+}
+
+Trainer::~Trainer()
+{
+	removeSyncPoints();
+}
+
+void Trainer::reset()
+{
+	game.clear();
+	cheats.clear();
+	removeSyncPoints();
+}
+
+void Trainer::activate(std::string newGame, std::span<const TclObject> repeat,
+                       std::span<const TclObject> newCheats, EmuTime::param time)
+{
+	auto& interp = command.getInterpreter();
+
+	// first parse everything, only then change the state
+	EmuDuration newInterval;
+	if ((repeat.size() == 1) && (repeat[0] == "frame")) {
+		newInterval = EmuDuration::zero();
+	} else if ((repeat.size() == 2) && (repeat[0] == "time")) {
+		auto seconds = repeat[1].getDouble(interp);
+		if (seconds <= 0.0) {
+			throw CommandException("Repeat interval must be positive");
+		}
+		newInterval = EmuDuration(seconds);
+	} else {
+		throw CommandException("Invalid repeat interval, must be 'frame' or 'time <seconds>'");
+	}
+
+	std::vector<Cheat> parsed;
+	for (const auto& c : newCheats) {
+		if (c.getListLength(interp) != 3) {
+			throw CommandException("Expected {name active pokes}, got: ", c.getString());
+		}
+		auto& cheat = parsed.emplace_back();
+		cheat.name = std::string(c.getListIndex(interp, 0).getString());
+		cheat.active = c.getListIndex(interp, 1).getBoolean(interp);
+		auto pokes = c.getListIndex(interp, 2);
+		for (auto i : xrange(pokes.getListLength(interp))) {
+			auto p = pokes.getListIndex(interp, i);
+			if (p.getListLength(interp) != 3) {
+				throw CommandException("Expected {poke|dpoke address value}, got: ", p.getString());
+			}
+			auto type = p.getListIndex(interp, 0).getString();
+			if (type != "poke" && type != "dpoke") {
+				throw CommandException("Expected poke or dpoke, got: ", type);
+			}
+			auto address = p.getListIndex(interp, 1).getInt(interp);
+			auto value = p.getListIndex(interp, 2).getInt(interp);
+			if ((address < 0) || (address > 0xFFFF)) {
+				throw CommandException("Invalid address: ", address);
+			}
+			if ((value < 0) || (value > 0xFF)) {
+				throw CommandException("Invalid value: ", value);
+			}
+			cheat.pokes.push_back(Poke{narrow<uint16_t>(address), narrow<uint8_t>(value),
+			                           type == "dpoke"});
+		}
+	}
+
+	removeSyncPoints();
+	game = std::move(newGame);
+	cheats = std::move(parsed);
+	interval = newInterval;
+	applyPokes(time);
+	scheduleNext(time);
+}
+
+void Trainer::toggle(std::span<const TclObject> indices, EmuTime::param time)
+{
+	if (game.empty()) {
+		throw CommandException("No trainer active");
+	}
+	auto& interp = command.getInterpreter();
+	std::vector<size_t> toToggle;
+	for (const auto& i : indices) {
+		auto idx = i.getInt(interp);
+		if ((idx < 0) || (size_t(idx) >= cheats.size())) {
+			throw CommandException("Invalid cheat index: ", idx);
+		}
+		toToggle.push_back(size_t(idx));
+	}
+	for (auto idx : toToggle) {
+		cheats[idx].active = !cheats[idx].active;
+	}
+	if (!anyActive()) {
+		removeSyncPoints();
+	} else if (!pendingSyncPoint()) {
+		scheduleNext(time);
+	}
+}
+
+void Trainer::status(TclObject& result) const
+{
+	TclObject list;
+	for (const auto& c : cheats) {
+		list.addListElement(makeTclList(c.name, c.active));
+	}
+	result.addDictKeyValue("game", game);
+	result.addDictKeyValue("cheats", list);
+}
+
+bool Trainer::anyActive() const
+{
+	return ranges::any_of(cheats, &Cheat::active);
+}
+
+void Trainer::applyPokes(EmuTime::param time)
+{
+	if (!motherBoard.getMachineConfig()) return;
+	auto& cpuInterface = motherBoard.getCPUInterface();
+	for (const auto& cheat : cheats) {
+		if (!cheat.active) continue;
+		for (const auto& p : cheat.pokes) {
+			if (p.onlyIfDifferent && (cpuInterface.peekMem(p.address, time) == p.value)) {
+				continue;
+			}
+			cpuInterface.writeMem(p.address, p.value, time);
+		}
+	}
+}
+
+void Trainer::scheduleNext(EmuTime::param time)
+{
+	if (!anyActive()) return;
+	if (interval != EmuDuration::zero()) {
+		setSyncPoint(time + interval);
+	} else if (auto* vdp = dynamic_cast<VDP*>(motherBoard.findDevice("VDP"))) {
+		// at the start of the next VDP frame
+		auto frame = VDP::VDPClock::duration(vdp->getTicksPerFrame());
+		auto next = vdp->getFrameStartTime() + frame;
+		while (next <= time) next += frame;
+		setSyncPoint(next);
+	} else {
+		setSyncPoint(time + EmuDuration::hz(60));
+	}
+}
+
+void Trainer::executeUntil(EmuTime::param time)
+{
+	applyPokes(time);
+	scheduleNext(time);
+}
+
+template<typename Archive>
+void Trainer::Poke::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("address",         address,
+	             "value",           value,
+	             "onlyIfDifferent", onlyIfDifferent);
+}
+
+template<typename Archive>
+void Trainer::Cheat::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("name",   name,
+	             "pokes",  pokes,
+	             "active", active);
+}
+
+template<typename Archive>
+void Trainer::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.template serializeBase<Schedulable>(*this);
+	ar.serialize("game",     game,
+	             "cheats",   cheats,
+	             "interval", interval);
+}
+INSTANTIATE_SERIALIZE_METHODS(Trainer);
+
+
+// class Trainer::Cmd
+
+Trainer::Cmd::Cmd(MSXMotherBoard& motherBoard_)
+	: RecordedCommand(motherBoard_.getCommandController(),
+	                  motherBoard_.getStateChangeDistributor(),
+	                  motherBoard_.getScheduler(),
+	                  "trainer_engine")
+{
+}
+
+void Trainer::Cmd::execute(std::span<const TclObject> tokens, TclObject& result,
+                           EmuTime::param time)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& trainer = OUTER(Trainer, command);
+	executeSubCommand(tokens[1].getString(),
+		"activate", [&]{
+			checkNumArgs(tokens, 5, "game repeat cheats");
+			auto& interp = getInterpreter();
+			auto repeat = to_vector(view::transform(xrange(tokens[3].getListLength(interp)),
+				[&](auto i) { return tokens[3].getListIndex(interp, i); }));
+			auto newCheats = to_vector(view::transform(xrange(tokens[4].getListLength(interp)),
+				[&](auto i) { return tokens[4].getListIndex(interp, i); }));
+			trainer.activate(std::string(tokens[2].getString()), repeat, newCheats, time);
+		},
+		"toggle", [&]{
+			trainer.toggle(tokens.subspan(2), time);
+		},
+		"deactivate", [&]{
+			checkNumArgs(tokens, 2, "");
+			trainer.reset();
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 2, "");
+			trainer.status(result);
+		});
+}
+
+bool Trainer::Cmd::needRecord(std::span<const TclObject> tokens) const
+{
+	return (tokens.size() < 2) || (tokens[1] != "status");
+}
+
+std::string Trainer::Cmd::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Low level trainer engine, normally used via the 'trainer' command.\n"
+	       "trainer_engine activate <game> <repeat> <cheats>\n"
+	       "    Activate the cheats of a trainer. <repeat> is either 'frame' or\n"
+	       "    'time <seconds>'. <cheats> is a list of {name active pokes}, where\n"
+	       "    'pokes' is a list of {poke|dpoke address value}.\n"
+	       "trainer_engine toggle <index> ...\n"
+	       "    Toggle the cheats with the given (0-based) indices on/off.\n"
+	       "trainer_engine deactivate\n"
+	       "    Deactivate the trainer.\n"
+	       "trainer_engine status\n"
+	       "    Returns a dict with the active game and cheats.\n";
+}
+
+void Trainer::Cmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	if (tokens.size() == 2) {
+		static constexpr std::array cmds = {
+			"activate"sv, "toggle"sv, "deactivate"sv, "status"sv,
+		};
+		completeString(tokens, cmds);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,95 @@
+#ifndef TRAINER_HH
+#define TRAINER_HH
+
+#include "RecordedCommand.hh"
+#include "Schedulable.hh"
+#include "EmuDuration.hh"
+#include "serialize_meta.hh"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+
+/** Applies the cheats of a trainer: at regular intervals a list of values is
+  * written to (CPU visible) memory.
+  *
+  * The trainer definitions themselves are still written in Tcl (see
+  * _trainerdefs.tcl). When a trainer is activated, the 'trainer' script
+  * compiles the cheats to lists of pokes and passes them to this class (via
+  * the 'trainer_engine' command). Applying the cheats then no longer needs
+  * to execute any Tcl code.
+  *
+  * This is part of the MSX machine state: it's stored in savestates and
+  * changes are recorded (like 'debug write' used to be).
+  */
+class Trainer final : public Schedulable
+{
+public:
+	struct Poke {
+		uint16_t address;
+		uint8_t value;
+		bool onlyIfDifferent; // 'dpoke': don't write if the value is already there
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+	};
+	struct Cheat {
+		std::string name;
+		std::vector<Poke> pokes;
+		bool active = false;
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned version);
+	};
+
+	explicit Trainer(MSXMotherBoard& motherBoard);
+	~Trainer();
+
+	/** Name of the active trainer, empty if none is active. */
+	[[nodiscard]] const std::string& getGame() const { return game; }
+	[[nodiscard]] std::span<const Cheat> getCheats() const { return cheats; }
+
+	/** Deactivate the trainer (on reset and power up of the MSX). */
+	void reset();
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+private:
+	void activate(std::string newGame, std::span<const TclObject> repeat,
+	              std::span<const TclObject> newCheats, EmuTime::param time);
+	void toggle(std::span<const TclObject> indices, EmuTime::param time);
+	void status(TclObject& result) const;
+
+	void applyPokes(EmuTime::param time);
+	void scheduleNext(EmuTime::param time);
+	[[nodiscard]] bool anyActive() const;
+
+	// Schedulable
+	void executeUntil(EmuTime::param time) override;
+
+private:
+	MSXMotherBoard& motherBoard;
+
+	struct Cmd final : RecordedCommand {
+		explicit Cmd(MSXMotherBoard& motherBoard);
+		void execute(std::span<const TclObject> tokens, TclObject& result,
+		             EmuTime::param time) override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+		[[nodiscard]] bool needRecord(std::span<const TclObject> tokens) const override;
+	} command;
+
+	std::string game;
+	std::vector<Cheat> cheats;
+	EmuDuration interval; // zero means: every VDP frame
+};
+SERIALIZE_CLASS_VERSION(Trainer, 1);
+
+} // namespace openmsx
+
+#endif
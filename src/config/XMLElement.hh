@@ -265,6 +265,9 @@ public:
 
 	// Load/parse an xml file. Requires that the document is still empty.
 	void load(const std::string& filename, std::string_view systemID);
+	// Same as above, but parse an in-memory document. 'name' is only used
+	// in error messages.
+	void load(std::string_view name, std::string_view xml, std::string_view systemID);
 
 	[[nodiscard]] const XMLElement* getRoot() const { return root; }
 	void setRoot(XMLElement* root_) { assert(!root); root = root_; }
@@ -298,6 +301,7 @@ public:
 	void serialize(XmlOutputArchive& ar, unsigned version);
 
 private:
+	void parse(std::string_view name, std::string_view systemID);
 	XMLElement* loadElement(MemInputArchive& ar);
 	XMLElement* clone(const XMLElement& inElem);
 	XMLElement* clone(const OldXMLElement& elem);
@@ -5,12 +5,19 @@
 
 namespace openmsx {
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            const CompiledCondition::Machine* machine) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
+	if (compiled && machine) {
+		if (auto result = compiled->evaluate(*machine)) {
+			return *result;
+		}
+		// fall back to Tcl (e.g. to get the proper error message)
+	}
 	try {
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
@@ -19,14 +26,15 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-bool BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+bool BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     const CompiledCondition::Machine* machine)
 {
 	if (executing) {
 		// no recursive execution
 		return false;
 	}
 	ScopedAssign sa(executing, true);
-	if (isTrue(cliComm, interp)) {
+	if (isTrue(cliComm, interp, machine)) {
 		try {
 			command.executeCommand(interp, true); // compile command
 		} catch (CommandException& e) {
@@ -1,7 +1,9 @@
 #ifndef BREAKPOINTBASE_HH
 #define BREAKPOINTBASE_HH
 
+#include "CompiledCondition.hh"
 #include "TclObject.hh"
+#include <memory>
 #include <string_view>
 
 namespace openmsx {
@@ -20,7 +22,21 @@ public:
 	[[nodiscard]] TclObject getCommandObj()   const { return command; }
 	[[nodiscard]] bool onlyOnce() const { return once; }
 
-	bool checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	/** Evaluate the condition and, if true, execute the command.
+	  * When 'machine' is given and the condition could be compiled, the
+	  * condition is evaluated natively instead of via Tcl.
+	  */
+	bool checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     const CompiledCondition::Machine* machine = nullptr);
+
+	/** Cheap pre-check that doesn't require the Tcl interpreter. Returns
+	  * false only if the condition is known to evaluate to false.
+	  */
+	[[nodiscard]] bool mightBeTrue(const CompiledCondition::Machine& machine) const {
+		if (!compiled) return true;
+		auto result = compiled->evaluate(machine);
+		return !result || *result;
+	}
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
@@ -29,14 +45,17 @@ protected:
 	BreakPointBase(TclObject command_, TclObject condition_, bool once_)
 		: command(std::move(command_))
 		, condition(std::move(condition_))
+		, compiled(CompiledCondition::compile(condition.getString()))
 		, once(once_) {}
 
 private:
-	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
+	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	                          const CompiledCondition::Machine* machine) const;
 
 private:
 	TclObject command;
 	TclObject condition;
+	std::shared_ptr<const CompiledCondition> compiled; // can be nullptr
 	bool once;
 	bool executing = false;
 };
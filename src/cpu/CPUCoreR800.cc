@@ -0,0 +1,11 @@
+// Instantiate CPUCore for the R800. See comments in CPUCore.ii for why this is
+// a separate translation unit.
+
+#include "CPUCore.ii"
+
+namespace openmsx {
+
+template class CPUCore<R800TYPE>;
+INSTANTIATE_SERIALIZE_METHODS(CPUCore<R800TYPE>);
+
+} // namespace openmsx
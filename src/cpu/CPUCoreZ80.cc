@@ -0,0 +1,11 @@
+// Instantiate CPUCore for the Z80. See comments in CPUCore.ii for why this is
+// a separate translation unit.
+
+#include "CPUCore.ii"
+
+namespace openmsx {
+
+template class CPUCore<Z80TYPE>;
+INSTANTIATE_SERIALIZE_METHODS(CPUCore<Z80TYPE>);
+
+} // namespace openmsx
@@ -0,0 +1,554 @@
+#include "CompiledCondition.hh"
+#include "CPURegs.hh"
+#include "StringOp.hh"
+#include "one_of.hh"
+#include "unreachable.hh"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cctype>
+#include <limits>
+
+namespace openmsx {
+
+using Op = CompiledCondition::Op;
+using Instruction = CompiledCondition::Instruction;
+
+// Index of the register in the 'CPU regs' debuggable (same as the 'reg' proc).
+static constexpr int REG_PC = 20;
+
+static std::optional<int> lookupReg8(std::string_view name)
+{
+	static constexpr std::array<std::string_view, 28> names = {
+		"A",   "F",   "B",   "C",   "D",   "E",   "H",   "L",
+		"A2",  "F2",  "B2",  "C2",  "D2",  "E2",  "H2",  "L2",
+		"IXH", "IXL", "IYH", "IYL", "PCH", "PCL", "SPH", "SPL",
+		"I",   "R",   "IM",  "IFF",
+	};
+	for (int i = 0; auto n : names) {
+		if (StringOp::casecmp()(n, name)) return i;
+		++i;
+	}
+	return {};
+}
+
+static std::optional<int> lookupReg16(std::string_view name)
+{
+	static constexpr std::array<std::string_view, 12> names = {
+		"AF",  "BC",  "DE",  "HL",
+		"AF2", "BC2", "DE2", "HL2",
+		"IX",  "IY",  "PC",  "SP",
+	};
+	for (int i = 0; auto n : names) {
+		if (StringOp::casecmp()(n, name)) return 2 * i;
+		++i;
+	}
+	return {};
+}
+
+// Must match MSXCPU::Debuggable::read().
+static byte readReg(const CPURegs& regs, int64_t index)
+{
+	switch (index) {
+	case  0: return regs.getA();
+	case  1: return regs.getF();
+	case  2: return regs.getB();
+	case  3: return regs.getC();
+	case  4: return regs.getD();
+	case  5: return regs.getE();
+	case  6: return regs.getH();
+	case  7: return regs.getL();
+	case  8: return regs.getA2();
+	case  9: return regs.getF2();
+	case 10: return regs.getB2();
+	case 11: return regs.getC2();
+	case 12: return regs.getD2();
+	case 13: return regs.getE2();
+	case 14: return regs.getH2();
+	case 15: return regs.getL2();
+	case 16: return regs.getIXh();
+	case 17: return regs.getIXl();
+	case 18: return regs.getIYh();
+	case 19: return regs.getIYl();
+	case 20: return regs.getPCh();
+	case 21: return regs.getPCl();
+	case 22: return regs.getSPh();
+	case 23: return regs.getSPl();
+	case 24: return regs.getI();
+	case 25: return regs.getR();
+	case 26: return regs.getIM();
+	case 27: return byte(1 *  regs.getIFF1() +
+	                     2 *  regs.getIFF2() +
+	                     4 * (regs.getIFF1() && !regs.prevWasEI()));
+	default: UNREACHABLE; return 0;
+	}
+}
+
+namespace {
+
+// Recursive descent parser for (a subset of) the Tcl 'expr' syntax. The
+// operator precedence follows the Tcl documentation.
+class Parser
+{
+public:
+	explicit Parser(std::string_view input_) : input(input_) {}
+
+	[[nodiscard]] bool parse()
+	{
+		if (!parseTernary()) return false;
+		skipSpace();
+		return (pos == input.size()) && (depth == 1);
+	}
+
+	std::vector<Instruction> code;
+
+private:
+	void emit(Op op, int64_t arg = 0)
+	{
+		code.push_back({op, arg});
+	}
+	[[nodiscard]] bool push(Op op, int64_t arg = 0)
+	{
+		emit(op, arg);
+		++depth;
+		return depth <= CompiledCondition::MAX_STACK;
+	}
+	void pop(Op op, int64_t arg = 0)
+	{
+		emit(op, arg);
+		--depth;
+	}
+
+	void skipSpace()
+	{
+		while ((pos < input.size()) && isspace(static_cast<unsigned char>(input[pos]))) ++pos;
+	}
+	[[nodiscard]] bool atEnd() const { return pos == input.size(); }
+	[[nodiscard]] char peekChar() const { return atEnd() ? '\0' : input[pos]; }
+	[[nodiscard]] bool accept(char c)
+	{
+		skipSpace();
+		if (peekChar() != c) return false;
+		++pos;
+		return true;
+	}
+
+	// Longest matching operator at the current position (not consumed).
+	[[nodiscard]] std::string_view peekOperator()
+	{
+		skipSpace();
+		static constexpr std::array<std::string_view, 18> ops = {
+			"||", "&&", "==", "!=", "<=", ">=", "<<", ">>",
+			"|", "^", "&", "<", ">", "+", "-", "*", "/", "%",
+		};
+		auto rest = input.substr(pos);
+		for (auto op : ops) {
+			if (rest.starts_with(op)) return op;
+		}
+		return {};
+	}
+
+	struct BinOp { std::string_view token; Op op; };
+	template<size_t N>
+	[[nodiscard]] bool parseBinary(const std::array<BinOp, N>& ops, bool (Parser::*next)())
+	{
+		if (!(this->*next)()) return false;
+		while (true) {
+			auto token = peekOperator();
+			auto it = std::find_if(ops.begin(), ops.end(),
+			                       [&](const auto& o) { return o.token == token; });
+			if (it == ops.end()) return true;
+			pos += token.size();
+			if (!(this->*next)()) return false;
+			pop(it->op);
+		}
+	}
+
+	[[nodiscard]] bool parseTernary()
+	{
+		if (!parseLogicalOr()) return false;
+		if (!accept('?')) return true;
+		pop(Op::JUMP_IF_FALSE);
+		auto jumpFalse = code.size() - 1;
+		if (!parseTernary()) return false;
+		emit(Op::JUMP);
+		auto jumpEnd = code.size() - 1;
+		--depth; // only one of both branches gets executed
+		code[jumpFalse].arg = int64_t(code.size());
+		if (!accept(':')) return false;
+		if (!parseTernary()) return false;
+		code[jumpEnd].arg = int64_t(code.size());
+		return true;
+	}
+
+	[[nodiscard]] bool parseShortCircuit(std::string_view token, Op op, bool (Parser::*next)())
+	{
+		if (!(this->*next)()) return false;
+		while (peekOperator() == token) {
+			pos += token.size();
+			pop(op);
+			auto skip = code.size() - 1;
+			if (!(this->*next)()) return false;
+			emit(Op::TO_BOOL);
+			code[skip].arg = int64_t(code.size());
+		}
+		return true;
+	}
+	[[nodiscard]] bool parseLogicalOr()
+	{
+		return parseShortCircuit("||", Op::OR_SKIP, &Parser::parseLogicalAnd);
+	}
+	[[nodiscard]] bool parseLogicalAnd()
+	{
+		return parseShortCircuit("&&", Op::AND_SKIP, &Parser::parseBitOr);
+	}
+
+	[[nodiscard]] bool parseBitOr()
+	{
+		static constexpr std::array ops = {BinOp{"|", Op::BIT_OR}};
+		return parseBinary(ops, &Parser::parseBitXor);
+	}
+	[[nodiscard]] bool parseBitXor()
+	{
+		static constexpr std::array ops = {BinOp{"^", Op::BIT_XOR}};
+		return parseBinary(ops, &Parser::parseBitAnd);
+	}
+	[[nodiscard]] bool parseBitAnd()
+	{
+		static constexpr std::array ops = {BinOp{"&", Op::BIT_AND}};
+		return parseBinary(ops, &Parser::parseEquality);
+	}
+	[[nodiscard]] bool parseEquality()
+	{
+		static constexpr std::array ops = {
+			BinOp{"==", Op::EQ}, BinOp{"!=", Op::NE}};
+		return parseBinary(ops, &Parser::parseRelational);
+	}
+	[[nodiscard]] bool parseRelational()
+	{
+		static constexpr std::array ops = {
+			BinOp{"<", Op::LT}, BinOp{">", Op::GT},
+			BinOp{"<=", Op::LE}, BinOp{">=", Op::GE}};
+		return parseBinary(ops, &Parser::parseShift);
+	}
+	[[nodiscard]] bool parseShift()
+	{
+		static constexpr std::array ops = {
+			BinOp{"<<", Op::SHL}, BinOp{">>", Op::SHR}};
+		return parseBinary(ops, &Parser::parseAdditive);
+	}
+	[[nodiscard]] bool parseAdditive()
+	{
+		static constexpr std::array ops = {
+			BinOp{"+", Op::ADD}, BinOp{"-", Op::SUB}};
+		return parseBinary(ops, &Parser::parseMultiplicative);
+	}
+	[[nodiscard]] bool parseMultiplicative()
+	{
+		static constexpr std::array ops = {
+			BinOp{"*", Op::MUL}, BinOp{"/", Op::DIV}, BinOp{"%", Op::MOD}};
+		return parseBinary(ops, &Parser::parseUnary);
+	}
+
+	[[nodiscard]] bool parseUnary()
+	{
+		skipSpace();
+		switch (peekChar()) {
+		case '-': ++pos; if (!parseUnary()) return false; emit(Op::NEG);     return true;
+		case '+': ++pos; return parseUnary();
+		case '~': ++pos; if (!parseUnary()) return false; emit(Op::BIT_NOT); return true;
+		case '!': ++pos; if (!parseUnary()) return false; emit(Op::LOG_NOT); return true;
+		default:  return parsePrimary();
+		}
+	}
+
+	[[nodiscard]] bool parsePrimary()
+	{
+		skipSpace();
+		if (accept('(')) {
+			return parseTernary() && accept(')');
+		}
+		if (accept('[')) {
+			return parseCommand() && accept(']');
+		}
+		auto value = parseNumber();
+		return value && push(Op::PUSH, *value);
+	}
+
+	// Integer literal. Floating point numbers, octal numbers without '0o'
+	// prefix (Tcl treats e.g. '010' as 8) and bignums are rejected.
+	[[nodiscard]] std::optional<int64_t> parseNumber()
+	{
+		skipSpace();
+		auto word = parseWord();
+		if (word.empty()) return {};
+		unsigned base = 10;
+		if ((word.size() > 2) && (word[0] == '0')) {
+			switch (word[1]) {
+			case 'x': case 'X': base = 16; break;
+			case 'b': case 'B': base = 2; break;
+			case 'o': case 'O': base = 8; break;
+			default: return {};
+			}
+			word.remove_prefix(2);
+		} else if ((word.size() > 1) && (word[0] == '0')) {
+			return {};
+		}
+		uint64_t result = 0;
+		for (char c : word) {
+			unsigned digit = 0;
+			if      ('0' <= c && c <= '9') digit = c - '0';
+			else if ('a' <= c && c <= 'f') digit = c - 'a' + 10;
+			else if ('A' <= c && c <= 'F') digit = c - 'A' + 10;
+			else return {};
+			if (digit >= base) return {};
+			if (result > (uint64_t(std::numeric_limits<int64_t>::max()) - digit) / base) {
+				return {};
+			}
+			result = result * base + digit;
+		}
+		return int64_t(result);
+	}
+
+	[[nodiscard]] std::string_view parseWord()
+	{
+		skipSpace();
+		auto start = pos;
+		while (!atEnd() && (isalnum(static_cast<unsigned char>(input[pos])) || (input[pos] == '_'))) {
+			++pos;
+		}
+		return input.substr(start, pos - start);
+	}
+
+	// Argument of a command: either a literal or a nested command.
+	[[nodiscard]] bool parseArgument()
+	{
+		if (accept('[')) {
+			return parseCommand() && accept(']');
+		}
+		auto value = parseNumber();
+		return value && push(Op::PUSH, *value);
+	}
+	[[nodiscard]] bool parseOptionalMemoryArg()
+	{
+		skipSpace();
+		if (peekChar() == ']') return true;
+		return parseWord() == "memory";
+	}
+	[[nodiscard]] std::optional<int> parseSlot(int max)
+	{
+		auto word = parseWord();
+		if (word == "X") return -1;
+		if ((word.size() == 1) && ('0' <= word[0]) && (word[0] <= '0' + max)) {
+			return word[0] - '0';
+		}
+		return {};
+	}
+
+	[[nodiscard]] bool parsePeek(Op op)
+	{
+		if (!parseArgument()) return false;
+		emit(op);
+		return parseOptionalMemoryArg();
+	}
+
+	[[nodiscard]] bool parseCommand()
+	{
+		auto cmd = parseWord();
+		if (cmd == "reg") {
+			auto name = parseWord();
+			if (auto r8 = lookupReg8(name)) {
+				return push(Op::REG8, *r8);
+			} else if (auto r16 = lookupReg16(name)) {
+				return push(Op::REG16, *r16);
+			}
+			return false;
+		} else if (cmd == one_of("peek", "peek8", "peek_u8")) {
+			return parsePeek(Op::PEEK8);
+		} else if (cmd == "peek_s8") {
+			return parsePeek(Op::PEEK_S8);
+		} else if (cmd == one_of("peek16", "peek16_LE", "peek_u16", "peek_u16LE")) {
+			return parsePeek(Op::PEEK16);
+		} else if (cmd == one_of("peek16_BE", "peek_u16BE")) {
+			return parsePeek(Op::PEEK16_BE);
+		} else if (cmd == one_of("peek_s16", "peek_s16LE")) {
+			return parsePeek(Op::PEEK_S16);
+		} else if (cmd == "debug") {
+			if (parseWord() != "read") return false;
+			if (parseWord() != "memory") return false;
+			if (!parseArgument()) return false;
+			emit(Op::PEEK8);
+			return true;
+		} else if (cmd == "pc_in_slot") {
+			auto ps = parseSlot(3);
+			if (!ps) return false;
+			int ss = -1;
+			skipSpace();
+			if (peekChar() != ']') {
+				auto s = parseSlot(3);
+				if (!s) return false; // also the 'mapper' argument is not supported
+				ss = *s;
+			}
+			if (!push(Op::REG16, REG_PC)) return false;
+			emit(Op::IN_SLOT, ((*ps + 1) << 4) | (ss + 1));
+			return true;
+		}
+		return false;
+	}
+
+private:
+	std::string_view input;
+	size_t pos = 0;
+	unsigned depth = 0;
+};
+
+} // namespace
+
+std::shared_ptr<const CompiledCondition> CompiledCondition::compile(std::string_view expr)
+{
+	Parser parser(expr);
+	if (!parser.parse()) return nullptr;
+	return std::shared_ptr<const CompiledCondition>(
+		new CompiledCondition(std::move(parser.code)));
+}
+
+// Tcl integer division rounds towards negative infinity.
+static std::optional<int64_t> floorDiv(int64_t a, int64_t b)
+{
+	if ((b == 0) || ((a == std::numeric_limits<int64_t>::min()) && (b == -1))) {
+		return {};
+	}
+	auto q = a / b;
+	if (((a % b) != 0) && ((a < 0) != (b < 0))) --q;
+	return q;
+}
+static std::optional<int64_t> floorMod(int64_t a, int64_t b)
+{
+	if (b == 0) return {};
+	if (b == -1) return 0;
+	auto r = a % b;
+	if ((r != 0) && ((r < 0) != (b < 0))) r += b;
+	return r;
+}
+
+std::optional<bool> CompiledCondition::evaluate(const Machine& machine) const
+{
+	std::array<int64_t, MAX_STACK> stack;
+	unsigned sp = 0;
+	auto peek8  = [&](int64_t addr) { return int64_t(machine.peekMem(word(addr))); };
+	auto peek16 = [&](int64_t addr) { return peek8(addr) + 256 * peek8(addr + 1); };
+	auto inRange = [](int64_t addr, int64_t size) { return (addr >= 0) && (addr + size <= 0x10000); };
+
+	size_t pc = 0;
+	while (pc != code.size()) {
+		const auto& ins = code[pc++];
+		int64_t& top = stack[std::max(sp, 1u) - 1]; // meaningless when sp == 0
+		switch (ins.op) {
+		case Op::PUSH:
+			stack[sp++] = ins.arg;
+			break;
+		case Op::REG8:
+			stack[sp++] = readReg(machine.getRegisters(), ins.arg);
+			break;
+		case Op::REG16: {
+			const auto& regs = machine.getRegisters();
+			stack[sp++] = 256 * readReg(regs, ins.arg) + readReg(regs, ins.arg + 1);
+			break;
+		}
+		// The Tcl peek procs throw for an address (or, for the 16-bit
+		// variants, a second byte) outside of [0, 0xFFFF], let the Tcl
+		// fallback produce that error.
+		case Op::PEEK8:     if (!inRange(top, 1)) return {}; top = peek8(top); break;
+		case Op::PEEK_S8:   if (!inRange(top, 1)) return {}; top = int8_t(peek8(top)); break;
+		case Op::PEEK16:    if (!inRange(top, 2)) return {}; top = peek16(top); break;
+		case Op::PEEK16_BE: if (!inRange(top, 2)) return {}; top = 256 * peek8(top) + peek8(top + 1); break;
+		case Op::PEEK_S16:  if (!inRange(top, 2)) return {}; top = int16_t(peek16(top)); break;
+		case Op::IN_SLOT: {
+			if ((top < 0) || (top > 0xFFFF)) return {};
+			int ps = int(ins.arg >> 4) - 1;
+			int ss = int(ins.arg & 15) - 1;
+			auto [selPs, selSs] = machine.getSelectedSlot(int(top >> 14));
+			top = ((ps == -1) || (ps == selPs)) &&
+			      ((ss == -1) || (selSs == -1) || (ss == selSs));
+			break;
+		}
+		case Op::NEG:
+			if (top == std::numeric_limits<int64_t>::min()) return {};
+			top = -top;
+			break;
+		case Op::BIT_NOT: top = ~top; break;
+		case Op::LOG_NOT: top = top == 0; break;
+		case Op::TO_BOOL: top = top != 0; break;
+		case Op::AND_SKIP:
+			if (top == 0) {
+				pc = size_t(ins.arg);
+			} else {
+				--sp;
+			}
+			break;
+		case Op::OR_SKIP:
+			if (top != 0) {
+				top = 1;
+				pc = size_t(ins.arg);
+			} else {
+				--sp;
+			}
+			break;
+		case Op::JUMP_IF_FALSE:
+			--sp;
+			if (top == 0) pc = size_t(ins.arg);
+			break;
+		case Op::JUMP:
+			pc = size_t(ins.arg);
+			break;
+		default: {
+			// binary operators
+			auto b = stack[--sp];
+			auto& a = stack[sp - 1];
+			switch (ins.op) {
+			case Op::MUL: if (__builtin_mul_overflow(a, b, &a)) return {}; break;
+			case Op::ADD: if (__builtin_add_overflow(a, b, &a)) return {}; break;
+			case Op::SUB: if (__builtin_sub_overflow(a, b, &a)) return {}; break;
+			case Op::DIV: {
+				auto q = floorDiv(a, b);
+				if (!q) return {};
+				a = *q;
+				break;
+			}
+			case Op::MOD: {
+				auto r = floorMod(a, b);
+				if (!r) return {};
+				a = *r;
+				break;
+			}
+			case Op::SHL:
+				// Tcl would switch to bignums
+				if ((b < 0) || (b >= 32) || (a < -(int64_t(1) << 31)) || (a >= (int64_t(1) << 31))) {
+					return {};
+				}
+				a = int64_t(uint64_t(a) << b);
+				break;
+			case Op::SHR:
+				if (b < 0) return {};
+				a >>= std::min<int64_t>(b, 63);
+				break;
+			case Op::LT:      a = a <  b; break;
+			case Op::GT:      a = a >  b; break;
+			case Op::LE:      a = a <= b; break;
+			case Op::GE:      a = a >= b; break;
+			case Op::EQ:      a = a == b; break;
+			case Op::NE:      a = a != b; break;
+			case Op::BIT_AND: a &= b; break;
+			case Op::BIT_XOR: a ^= b; break;
+			case Op::BIT_OR:  a |= b; break;
+			default: UNREACHABLE;
+			}
+			break;
+		}
+		}
+	}
+	assert(sp == 1);
+	return stack[0] != 0;
+}
+
+} // namespace openmsx
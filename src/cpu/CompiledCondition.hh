@@ -0,0 +1,92 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include "openmsx.hh"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+class CPURegs;
+
+/** Native evaluator for the most common breakpoint/condition expressions.
+ *
+ * Conditions like
+ *     [reg PC] == 0x4010 && [peek 0xF3AE] > 3
+ * are evaluated after every emulated instruction. Going through the Tcl
+ * interpreter for that is very expensive. This class recognizes a subset
+ * of the Tcl expression syntax (integer constants, arithmetic, comparison,
+ * bitwise and boolean operators, and the 'reg', 'peek', 'peek16', ...,
+ * 'pc_in_slot' and 'debug read memory' commands) and translates it to a
+ * small stack-based bytecode program.
+ *
+ * Expressions outside this subset are rejected by compile(). Those must
+ * (still) be evaluated via Tcl. The same is true when evaluate() detects a
+ * situation where the result could differ from Tcl's (e.g. a division by
+ * zero, which Tcl reports as an error).
+ */
+class CompiledCondition
+{
+public:
+	/** Interface to the machine state that a condition can query. */
+	class Machine
+	{
+	public:
+		[[nodiscard]] virtual const CPURegs& getRegisters() const = 0;
+		[[nodiscard]] virtual byte peekMem(word address) const = 0;
+		/** Returns the selected primary and secondary slot for the
+		  * given page. The secondary slot is -1 for a non-expanded
+		  * primary slot. */
+		[[nodiscard]] virtual std::pair<int, int> getSelectedSlot(int page) const = 0;
+	protected:
+		~Machine() = default;
+	};
+
+	/** Try to compile the given expression.
+	  * @return nullptr if the expression is not in the supported subset.
+	  */
+	[[nodiscard]] static std::shared_ptr<const CompiledCondition> compile(std::string_view expr);
+
+	/** Evaluate this condition.
+	  * @return The boolean result, or std::nullopt when the result must be
+	  *         obtained via Tcl instead.
+	  */
+	[[nodiscard]] std::optional<bool> evaluate(const Machine& machine) const;
+
+	enum class Op : uint8_t {
+		PUSH,                  // push constant
+		REG8, REG16,           // push register ('CPU regs' debuggable index)
+		PEEK8, PEEK_S8,        // pop address, push memory content
+		PEEK16, PEEK16_BE, PEEK_S16,
+		IN_SLOT,               // pop address, push 'address_in_slot'
+		NEG, BIT_NOT, LOG_NOT, // unary
+		MUL, DIV, MOD, ADD, SUB, SHL, SHR, // binary
+		LT, GT, LE, GE, EQ, NE,
+		BIT_AND, BIT_XOR, BIT_OR,
+		AND_SKIP,              // pop, if false: push 0 and jump
+		OR_SKIP,               // pop, if true: push 1 and jump
+		TO_BOOL,               // replace top with 0 or 1
+		JUMP_IF_FALSE,         // pop, if false: jump
+		JUMP,
+	};
+	struct Instruction {
+		Op op;
+		int64_t arg = 0; // constant, register index, jump target or slot
+	};
+
+	static constexpr unsigned MAX_STACK = 16;
+
+private:
+	explicit CompiledCondition(std::vector<Instruction> code_)
+		: code(std::move(code_)) {}
+
+	std::vector<Instruction> code;
+};
+
+} // namespace openmsx
+
+#endif
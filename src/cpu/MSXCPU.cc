@@ -194,6 +194,20 @@ void MSXCPU::invalidateAllSlotsRWCache(word start, unsigned size)
 	}
 }
 
+void MSXCPU::invalidateAllSlotsWCache(word start, unsigned size)
+{
+	if (interface) interface->tick(CacheLineCounters::InvalidateAllSlots);
+	auto cpuWriteLines = (z80Active ? z80->getCacheLines() : r800->getCacheLines()).write;
+
+	unsigned first = start / CacheLine::SIZE;
+	unsigned num = (size + CacheLine::SIZE - 1) / CacheLine::SIZE;
+	ranges::fill(subspan(cpuWriteLines, first, num), nullptr);
+
+	for (auto i : xrange(16)) {
+		ranges::fill(subspan(slotWriteLines[i], first, num), nullptr);
+	}
+}
+
 template<bool READ, bool WRITE, bool SUB_START>
 void MSXCPU::setRWCache(unsigned start, unsigned size, const byte* rData, byte* wData, int ps, int ss,
                         std::span<const byte, 256> disallowRead,
@@ -55,6 +55,11 @@ public:
 	  * method when a 'memory switch' occurs. */
 	void invalidateAllSlotsRWCache(word start, unsigned size);
 
+	/** Similar to the method above, but only invalidates the write cache.
+	  * For example CheckedRam uses this to see the first write to a page
+	  * after it marked that page clean. */
+	void invalidateAllSlotsWCache(word start, unsigned size);
+
 	/** Similar to the method above, but only invalidates one specific slot.
 	  * One small tweak: lines that are in 'disallowRead/Write' are
 	  * immediately marked as 'non-cacheable' instead of (first) as
@@ -7,6 +7,7 @@
 #include "RealTime.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCPU.hh"
+#include "CPURegs.hh"
 #include "VDPIODelay.hh"
 #include "MSXCliComm.hh"
 #include "MSXMultiIODevice.hh"
@@ -786,6 +787,7 @@ void MSXCPUInterface::writeSlottedMem(unsigned address, byte value,
 void MSXCPUInterface::insertBreakPoint(BreakPoint bp)
 {
 	cliComm.update(CliComm::DEBUG_UPDT, tmpStrCat("bp#", bp.getId()), "add");
+	breakPointAddresses.set(bp.getAddress());
 	auto it = ranges::upper_bound(breakPoints, bp.getAddress(), {}, &BreakPoint::getAddress);
 	breakPoints.insert(it, std::move(bp));
 }
@@ -793,9 +795,11 @@ void MSXCPUInterface::insertBreakPoint(BreakPoint bp)
 void MSXCPUInterface::removeBreakPoint(const BreakPoint& bp)
 {
 	cliComm.update(CliComm::DEBUG_UPDT, tmpStrCat("bp#", bp.getId()), "remove");
-	auto [first, last] = ranges::equal_range(breakPoints, bp.getAddress(), {}, &BreakPoint::getAddress);
+	auto address = bp.getAddress();
+	auto [first, last] = ranges::equal_range(breakPoints, address, {}, &BreakPoint::getAddress);
 	breakPoints.erase(find_unguarded(first, last, &bp,
 	                                 [](const BreakPoint& i) { return &i; }));
+	updateBreakPointAddress(address);
 }
 void MSXCPUInterface::removeBreakPoint(unsigned id)
 {
@@ -803,14 +807,59 @@ void MSXCPUInterface::removeBreakPoint(unsigned id)
 	    // could be ==end for a breakpoint that removes itself AND has the -once flag set
 	    it != breakPoints.end()) {
 		cliComm.update(CliComm::DEBUG_UPDT, tmpStrCat("bp#", it->getId()), "remove");
+		auto address = it->getAddress();
 		breakPoints.erase(it);
+		updateBreakPointAddress(address);
 	}
 }
 
+void MSXCPUInterface::updateBreakPointAddress(word address)
+{
+	auto [first, last] = ranges::equal_range(breakPoints, address, {}, &BreakPoint::getAddress);
+	breakPointAddresses[address] = first != last;
+}
+
+namespace {
+// Gives compiled breakpoint conditions direct access to the machine state.
+class ConditionMachine final : public CompiledCondition::Machine
+{
+public:
+	ConditionMachine(const MSXCPUInterface& interface_, const CPURegs& regs_,
+	                 EmuTime::param time_)
+		: interface(interface_), regs(regs_), time(time_) {}
+
+	[[nodiscard]] const CPURegs& getRegisters() const override {
+		return regs;
+	}
+	[[nodiscard]] byte peekMem(word address) const override {
+		return interface.peekMem(address, time);
+	}
+	[[nodiscard]] std::pair<int, int> getSelectedSlot(int page) const override {
+		int ps = interface.getPrimarySlot(page);
+		int ss = interface.isExpanded(ps) ? interface.getSecondarySlot(page) : -1;
+		return {ps, ss};
+	}
+
+private:
+	const MSXCPUInterface& interface;
+	const CPURegs& regs;
+	EmuTime time;
+};
+} // namespace
+
 void MSXCPUInterface::checkBreakPoints(
 	std::pair<BreakPoints::const_iterator,
 	          BreakPoints::const_iterator> range)
 {
+	ConditionMachine machine(*this, msxcpu.getRegisters(), motherBoard.getCurrentTime());
+	// Most of the time none of the conditions are true. If all of them
+	// could be compiled, we can detect this without involving Tcl and
+	// without making copies.
+	if ((range.first == range.second) &&
+	    ranges::none_of(conditions, [&](auto& c) { return c.mightBeTrue(machine); })) {
+		return;
+	}
+
 	// create copy for the case that breakpoint/condition removes itself
 	//  - keeps object alive by holding a shared_ptr to it
 	//  - avoids iterating over a changing collection
@@ -818,14 +867,14 @@ void MSXCPUInterface::checkBreakPoints(
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	for (auto& p : bpCopy) {
-		bool remove = p.checkAndExecute(globalCliComm, interp);
+		bool remove = p.checkAndExecute(globalCliComm, interp, &machine);
 		if (remove) {
 			removeBreakPoint(p.getId());
 		}
 	}
 	auto condCopy = conditions;
 	for (auto& c : condCopy) {
-		bool remove = c.checkAndExecute(globalCliComm, interp);
+		bool remove = c.checkAndExecute(globalCliComm, interp, &machine);
 		if (remove) {
 			removeCondition(c.getId());
 		}
@@ -1054,6 +1103,7 @@ void MSXCPUInterface::cleanup()
 	// TODO it would be nicer if breakpoints and conditions were not
 	//      global objects.
 	breakPoints.clear();
+	breakPointAddresses.reset();
 	conditions.clear();
 }
 
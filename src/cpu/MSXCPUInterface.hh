@@ -274,12 +274,12 @@ public:
 	}
 	[[nodiscard]] bool checkBreakPoints(unsigned pc)
 	{
-		auto range = ranges::equal_range(breakPoints, pc, {}, &BreakPoint::getAddress);
-		if (conditions.empty() && (range.first == range.second)) {
+		if (conditions.empty() && !breakPointAddresses[pc]) [[likely]] {
 			return false;
 		}
 
 		// slow path non-inlined
+		auto range = ranges::equal_range(breakPoints, pc, {}, &BreakPoint::getAddress);
 		checkBreakPoints(range);
 		return isBreaked();
 	}
@@ -317,6 +317,7 @@ private:
 
 	void checkBreakPoints(std::pair<BreakPoints::const_iterator,
 	                                BreakPoints::const_iterator> range);
+	static void updateBreakPointAddress(word address);
 
 	void removeAllWatchPoints();
 	void updateMemWatch(WatchPoint::Type type);
@@ -427,6 +428,9 @@ private:
 
 	//  All CPUs (Z80 and R800) of all MSX machines share this state.
 	static inline BreakPoints breakPoints; // sorted on address
+	// For each address: is there at least one breakpoint. This turns the
+	// per-instruction check into a single bit test.
+	static inline std::bitset<0x10000> breakPointAddresses;
 	WatchPoints watchPoints; // ordered in creation order,  TODO must also be static
 	static inline Conditions conditions; // ordered in creation order
 	static inline bool breaked = false;
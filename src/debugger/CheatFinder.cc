@@ -0,0 +1,238 @@
+#include "CheatFinder.hh"
+#include "Debuggable.hh"
+#include "MSXException.hh"
+#include "narrow.hh"
+#include "view.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+static constexpr unsigned BITS = 64; // number of addresses per candidates word
+
+void CheatFinder::start(Debuggable& debuggable, std::string name, Width width_)
+{
+	size = debuggable.getSize();
+	width = width_;
+	numAddresses = (width == Width::WORD) ? std::max(size, 1u) - 1 : size;
+
+	for (auto& s : snapshots) s.resize(size + 1);
+	debuggable.readBlock(0, std::span{snapshots[0].data(), size});
+	snapshots[0][size] = 0;
+	memcpy(snapshots[1].data(), snapshots[0].data(), size + 1);
+	current = 0;
+
+	candidates.assign((numAddresses + BITS - 1) / BITS, ~uint64_t(0));
+	if (auto rest = numAddresses % BITS) {
+		candidates.back() = (uint64_t(1) << rest) - 1;
+	}
+	debuggableName = std::move(name);
+}
+
+void CheatFinder::clear()
+{
+	debuggableName.clear();
+	size = numAddresses = 0;
+	for (auto& s : snapshots) s.clear();
+	candidates.clear();
+}
+
+unsigned CheatFinder::valueAt(std::span<const uint8_t> data, unsigned address) const
+{
+	// note: reading data[address + 1] is fine, the buffers have an extra byte
+	return (width == Width::BYTE)
+	     ? data[address]
+	     : data[address] | (data.data()[address + 1] << 8);
+}
+
+bool CheatFinder::check(unsigned address, const Condition& condition) const
+{
+	int64_t n = valueAt(newData(), address);
+	int64_t r = condition.value ? int64_t(*condition.value)
+	                            : int64_t(valueAt(oldData(), address)) + condition.delta;
+	switch (condition.op) {
+		case Op::EQ: return n == r;
+		case Op::NE: return n != r;
+		case Op::LT: return n <  r;
+		case Op::LE: return n <= r;
+		case Op::GT: return n >  r;
+		case Op::GE: return n >= r;
+	}
+	return false;
+}
+
+#ifdef __SSE2__
+// Compare the signed values in 'n' and 'r' (16 or 32 bit elements), the
+// result has all bits set in the elements for which the comparison holds.
+template<typename CmpEq, typename CmpLt, typename CmpGt>
+[[nodiscard]] static inline __m128i compare(CheatFinder::Op op, __m128i n, __m128i r,
+                                            CmpEq cmpEq, CmpLt cmpLt, CmpGt cmpGt)
+{
+	auto ones = _mm_set1_epi32(-1);
+	using Op = CheatFinder::Op;
+	switch (op) {
+		case Op::EQ: return cmpEq(n, r);
+		case Op::NE: return _mm_xor_si128(cmpEq(n, r), ones);
+		case Op::LT: return cmpLt(n, r);
+		case Op::LE: return _mm_xor_si128(cmpGt(n, r), ones);
+		case Op::GT: return cmpGt(n, r);
+		case Op::GE: return _mm_xor_si128(cmpLt(n, r), ones);
+	}
+	return _mm_setzero_si128();
+}
+
+[[nodiscard]] static inline __m128i compare16(CheatFinder::Op op, __m128i n, __m128i r)
+{
+	return compare(op, n, r,
+	               [](__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); },
+	               [](__m128i a, __m128i b) { return _mm_cmplt_epi16(a, b); },
+	               [](__m128i a, __m128i b) { return _mm_cmpgt_epi16(a, b); });
+}
+
+[[nodiscard]] static inline __m128i compare32(CheatFinder::Op op, __m128i n, __m128i r)
+{
+	return compare(op, n, r,
+	               [](__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); },
+	               [](__m128i a, __m128i b) { return _mm_cmplt_epi32(a, b); },
+	               [](__m128i a, __m128i b) { return _mm_cmpgt_epi32(a, b); });
+}
+#endif
+
+// Check the 16 addresses starting at 'address', bit 'i' of the result is set
+// when 'address + i' satisfies the condition.
+uint16_t CheatFinder::check16(unsigned address, const Condition& condition) const
+{
+#ifdef __SSE2__
+	// Both the byte and the word variant widen the values (to 16 or 32
+	// bit) before comparing. So 'old + delta' can't wrap around and the
+	// (signed) SSE2 compare instructions can be used. The reference value
+	// and delta are clamped, that doesn't change the outcome.
+	const auto* n = newData().data() + address;
+	const auto* o = oldData().data() + address;
+	auto zero = _mm_setzero_si128();
+	if (width == Width::BYTE) {
+		auto nv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n));
+		auto nLo = _mm_unpacklo_epi8(nv, zero);
+		auto nHi = _mm_unpackhi_epi8(nv, zero);
+		__m128i rLo, rHi;
+		if (condition.value) {
+			rLo = rHi = _mm_set1_epi16(narrow_cast<int16_t>(std::clamp(*condition.value, -1, 256)));
+		} else {
+			auto d = _mm_set1_epi16(narrow_cast<int16_t>(std::clamp(condition.delta, -256, 256)));
+			auto ov = _mm_loadu_si128(reinterpret_cast<const __m128i*>(o));
+			rLo = _mm_add_epi16(_mm_unpacklo_epi8(ov, zero), d);
+			rHi = _mm_add_epi16(_mm_unpackhi_epi8(ov, zero), d);
+		}
+		auto res = _mm_packs_epi16(compare16(condition.op, nLo, rLo),
+		                           compare16(condition.op, nHi, rHi));
+		return narrow_cast<uint16_t>(_mm_movemask_epi8(res));
+	} else {
+		// The words at the even addresses come from an aligned-to-'address'
+		// load, the ones at the odd addresses from a load one byte further.
+		// Each comparison result occupies two bits in the movemask, keep
+		// the low bit for the even and the high bit for the odd addresses.
+		auto words = [&](int offset) {
+			auto nv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(n + offset));
+			auto nLo = _mm_unpacklo_epi16(nv, zero);
+			auto nHi = _mm_unpackhi_epi16(nv, zero);
+			__m128i rLo, rHi;
+			if (condition.value) {
+				rLo = rHi = _mm_set1_epi32(std::clamp(*condition.value, -1, 0x10000));
+			} else {
+				auto d = _mm_set1_epi32(std::clamp(condition.delta, -0x10000, 0x10000));
+				auto ov = _mm_loadu_si128(reinterpret_cast<const __m128i*>(o + offset));
+				rLo = _mm_add_epi32(_mm_unpacklo_epi16(ov, zero), d);
+				rHi = _mm_add_epi32(_mm_unpackhi_epi16(ov, zero), d);
+			}
+			auto res = _mm_packs_epi32(compare32(condition.op, nLo, rLo),
+			                           compare32(condition.op, nHi, rHi));
+			return unsigned(_mm_movemask_epi8(res));
+		};
+		return narrow_cast<uint16_t>((words(0) & 0x5555) | (words(1) & 0xAAAA));
+	}
+#else
+	uint16_t result = 0;
+	for (auto i : xrange(16)) {
+		if (check(address + i, condition)) result |= 1 << i;
+	}
+	return result;
+#endif
+}
+
+void CheatFinder::search(Debuggable& debuggable, const Condition& condition)
+{
+	assert(isActive());
+	if (debuggable.getSize() != size) {
+		throw MSXException("Size of debuggable '", debuggableName,
+		                   "' changed, please restart the search.");
+	}
+	current = 1 - current;
+	debuggable.readBlock(0, std::span{snapshots[current].data(), size});
+
+	// Blocks of 16 addresses may read up to 16 bytes past their start
+	// address (the word variant), that's fine up to the extra byte.
+	auto lastFullBlock = (size >= 16) ? (size - 16) : 0;
+	for (auto w : xrange(candidates.size())) {
+		auto& bits = candidates[w];
+		if (bits == 0) continue;
+		auto base = narrow<unsigned>(w * BITS);
+		uint64_t keep = 0;
+		for (unsigned sub = 0; sub < BITS; sub += 16) {
+			auto address = base + sub;
+			if (((bits >> sub) & 0xFFFF) == 0) continue;
+			if ((size >= 16) && (address <= lastFullBlock)) {
+				keep |= uint64_t(check16(address, condition)) << sub;
+			} else {
+				for (auto i : xrange(16u)) {
+					auto a = address + i;
+					if (a >= numAddresses) break;
+					if (check(a, condition)) keep |= uint64_t(1) << (sub + i);
+				}
+			}
+		}
+		bits &= keep;
+	}
+}
+
+void CheatFinder::retain(std::span<const unsigned> addresses)
+{
+	std::vector<uint64_t> selected(candidates.size(), 0);
+	for (auto a : addresses) {
+		if (a >= numAddresses) continue;
+		selected[a / BITS] |= uint64_t(1) << (a % BITS);
+	}
+	for (auto [c, s] : view::zip_equal(candidates, selected)) {
+		c &= s;
+	}
+}
+
+size_t CheatFinder::count() const
+{
+	size_t result = 0;
+	for (auto bits : candidates) result += std::popcount(bits);
+	return result;
+}
+
+std::vector<CheatFinder::Result> CheatFinder::getResults(size_t max) const
+{
+	std::vector<Result> result;
+	for (auto w : xrange(candidates.size())) {
+		auto bits = candidates[w];
+		while (bits) {
+			if (result.size() == max) return result;
+			auto address = narrow<unsigned>(w * BITS + std::countr_zero(bits));
+			result.push_back({address, valueAt(oldData(), address), valueAt(newData(), address)});
+			bits &= bits - 1;
+		}
+	}
+	return result;
+}
+
+} // namespace openmsx
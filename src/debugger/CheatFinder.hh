@@ -0,0 +1,103 @@
+#ifndef CHEATFINDER_HH
+#define CHEATFINDER_HH
+
+#include "MemBuffer.hh"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Debuggable;
+
+/** Search engine for the cheat finder.
+  *
+  * A search starts by taking a snapshot of (the full content of) a
+  * debuggable, initially every address is a candidate. Each following
+  * search pass takes a new snapshot and only keeps the candidates for which
+  * the new value satisfies a comparison. The candidates are stored as a
+  * bitmap, the comparisons are done 16 addresses at a time (on SSE2 capable
+  * CPUs). So even multi-megabyte debuggables can be searched quickly.
+  *
+  * Values are either single bytes or (little endian) 16-bit words starting
+  * at each address.
+  */
+class CheatFinder
+{
+public:
+	enum class Width : uint8_t { BYTE, WORD };
+	enum class Op : uint8_t { EQ, NE, LT, LE, GT, GE };
+
+	/** A search condition: 'new <op> reference', where 'reference' is
+	  * either a constant or the old value plus a (possibly zero) delta.
+	  */
+	struct Condition {
+		Op op = Op::EQ;
+		std::optional<int> value; // nullopt -> compare with old value
+		int delta = 0;            // only used when comparing with old value
+	};
+
+	struct Result {
+		unsigned address;
+		unsigned oldValue;
+		unsigned newValue;
+	};
+
+	/** (Re)start a search on the given debuggable, all addresses become
+	  * candidates. */
+	void start(Debuggable& debuggable, std::string debuggableName, Width width);
+
+	/** Take a new snapshot of the debuggable and only keep the candidates
+	  * that satisfy the condition. The debuggable must be the same as the
+	  * one passed to start().
+	  * @throws MSXException when the size of the debuggable changed. */
+	void search(Debuggable& debuggable, const Condition& condition);
+
+	/** Only keep the candidates that are also in the given list. Can be
+	  * used to implement search conditions that can't be expressed with
+	  * 'Condition' (the values are not re-read). */
+	void retain(std::span<const unsigned> addresses);
+
+	/** Abandon the current search (releases the snapshots). */
+	void clear();
+
+	[[nodiscard]] bool isActive() const { return !debuggableName.empty(); }
+	[[nodiscard]] const std::string& getDebuggableName() const { return debuggableName; }
+	[[nodiscard]] Width getWidth() const { return width; }
+
+	/** Number of remaining candidates. */
+	[[nodiscard]] size_t count() const;
+
+	/** The first (at most) 'max' candidates, in increasing address order,
+	  * with their values in the previous and the latest snapshot. */
+	[[nodiscard]] std::vector<Result> getResults(size_t max) const;
+
+private:
+	[[nodiscard]] unsigned valueAt(std::span<const uint8_t> data, unsigned address) const;
+	[[nodiscard]] bool check(unsigned address, const Condition& condition) const;
+	[[nodiscard]] uint16_t check16(unsigned address, const Condition& condition) const;
+
+	[[nodiscard]] std::span<const uint8_t> oldData() const { return {snapshots[1 - current].data(), size}; }
+	[[nodiscard]] std::span<const uint8_t> newData() const { return {snapshots[current].data(), size}; }
+
+private:
+	std::string debuggableName; // empty when no search is active
+	Width width = Width::BYTE;
+	unsigned size = 0; // size of the debuggable
+	unsigned numAddresses = 0; // number of addresses that can hold a value
+
+	// Two snapshots (previous and latest), they're swapped on each search.
+	// Each buffer has one extra (zero) byte, so that reading a word at
+	// the last address stays within the buffer.
+	MemBuffer<uint8_t> snapshots[2];
+	unsigned current = 0;
+
+	// Bit 'i' is set when address 'i' is still a candidate.
+	std::vector<uint64_t> candidates;
+};
+
+} // namespace openmsx
+
+#endif
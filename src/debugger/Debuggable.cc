@@ -0,0 +1,23 @@
+#include "Debuggable.hh"
+#include "xrange.hh"
+#include <cassert>
+
+namespace openmsx {
+
+void Debuggable::readBlock(unsigned address, std::span<byte> output)
+{
+	assert((address + output.size()) <= getSize());
+	for (auto i : xrange(output.size())) {
+		output[i] = read(unsigned(address + i));
+	}
+}
+
+void Debuggable::writeBlock(unsigned address, std::span<const byte> input)
+{
+	assert((address + input.size()) <= getSize());
+	for (auto i : xrange(input.size())) {
+		write(unsigned(address + i), input[i]);
+	}
+}
+
+} // namespace openmsx
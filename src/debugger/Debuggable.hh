@@ -2,6 +2,7 @@
 #define DEBUGGABLE_HH
 
 #include "openmsx.hh"
+#include <span>
 #include <string_view>
 
 namespace openmsx {
@@ -17,6 +18,14 @@ public:
 	[[nodiscard]] virtual byte read(unsigned address) = 0;
 	virtual void write(unsigned address, byte value) = 0;
 
+	/** Read/write a block of consecutive bytes, starting at 'address'.
+	  * The block must completely fit in this debuggable. This is
+	  * equivalent to calling read()/write() for each byte, but subclasses
+	  * can override it with a faster implementation.
+	  */
+	virtual void readBlock(unsigned address, std::span<byte> output);
+	virtual void writeBlock(unsigned address, std::span<const byte> input);
+
 protected:
 	Debuggable() = default;
 	~Debuggable() = default;
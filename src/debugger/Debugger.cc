@@ -1,5 +1,7 @@
 #include "Debugger.hh"
 #include "Debuggable.hh"
+#include "Base64.hh"
+#include "CheatFinder.hh"
 #include "MSXCliComm.hh"
 #include "ProbeBreakPoint.hh"
 #include "MSXMotherBoard.hh"
@@ -167,6 +169,11 @@ unsigned Debugger::setWatchPoint(TclObject command, TclObject condition,
 	return wp->getId();
 }
 
+CheatFinder& Debugger::getCheatFinder()
+{
+	return motherBoard.getReactor().getCheatFinder();
+}
+
 void Debugger::transfer(Debugger& other)
 {
 	// Copy watchpoints to new machine.
@@ -250,7 +257,8 @@ void Debugger::Cmd::execute(
 		"remove_condition",  [&]{ removeCondition(tokens, result); },
 		"list_conditions",   [&]{ listConditions(tokens, result); },
 		"probe",             [&]{ probe(tokens, result); },
-		"symbols",           [&]{ symbols(tokens, result); });
+		"symbols",           [&]{ symbols(tokens, result); },
+		"cheat_finder",      [&]{ cheatFinder(tokens, result); });
 }
 
 void Debugger::Cmd::list(TclObject& result)
@@ -285,24 +293,32 @@ void Debugger::Cmd::read(std::span<const TclObject> tokens, TclObject& result)
 
 void Debugger::Cmd::readBlock(std::span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, 5, Prefix{2}, "debuggable address size");
+	checkNumArgs(tokens, Between{5, 6}, Prefix{2}, "?-base64? debuggable address size");
 	auto& interp = getInterpreter();
-	Debuggable& device = debugger().getDebuggable(tokens[2].getString());
+	bool base64 = false;
+	std::array info = {flagArg("-base64", base64)};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (arguments.size() != 3) throw SyntaxError();
+
+	Debuggable& device = debugger().getDebuggable(arguments[0].getString());
 	unsigned devSize = device.getSize();
-	unsigned addr = tokens[3].getInt(interp);
+	unsigned addr = arguments[1].getInt(interp);
 	if (addr >= devSize) {
 		throw CommandException("Invalid address");
 	}
-	unsigned num = tokens[4].getInt(interp);
+	unsigned num = arguments[2].getInt(interp);
 	if (num > (devSize - addr)) {
 		throw CommandException("Invalid size");
 	}
 
 	MemBuffer<byte> buf(num);
-	for (auto i : xrange(num)) {
-		buf[i] = device.read(addr + i);
+	std::span<byte> block{buf.data(), num};
+	device.readBlock(addr, block);
+	if (base64) {
+		result = Base64::encode(block);
+	} else {
+		result = block;
 	}
-	result = std::span<byte>{buf.data(), num};
 }
 
 void Debugger::Cmd::write(std::span<const TclObject> tokens, TclObject& /*result*/)
@@ -324,21 +340,33 @@ void Debugger::Cmd::write(std::span<const TclObject> tokens, TclObject& /*result
 
 void Debugger::Cmd::writeBlock(std::span<const TclObject> tokens, TclObject& /*result*/)
 {
-	checkNumArgs(tokens, 5, Prefix{2}, "debuggable address values");
-	Debuggable& device = debugger().getDebuggable(tokens[2].getString());
+	checkNumArgs(tokens, Between{5, 6}, Prefix{2}, "?-base64? debuggable address values");
+	auto& interp = getInterpreter();
+	bool base64 = false;
+	std::array info = {flagArg("-base64", base64)};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (arguments.size() != 3) throw SyntaxError();
+
+	Debuggable& device = debugger().getDebuggable(arguments[0].getString());
 	unsigned devSize = device.getSize();
-	unsigned addr = tokens[3].getInt(getInterpreter());
+	unsigned addr = arguments[1].getInt(interp);
 	if (addr >= devSize) {
 		throw CommandException("Invalid address");
 	}
-	auto buf = tokens[4].getBinary();
+	std::span<const byte> buf;
+	MemBuffer<byte> decoded;
+	if (base64) {
+		size_t size;
+		std::tie(decoded, size) = Base64::decode(arguments[2].getString());
+		buf = std::span{decoded.data(), size};
+	} else {
+		buf = arguments[2].getBinary();
+	}
 	if ((buf.size() + addr) > devSize) {
 		throw CommandException("Invalid size");
 	}
 
-	for (auto i : xrange(buf.size())) {
-		device.write(unsigned(addr + i), buf[i]);
-	}
+	device.writeBlock(addr, buf);
 }
 
 void Debugger::Cmd::setBreakPoint(std::span<const TclObject> tokens, TclObject& result)
@@ -773,6 +801,96 @@ void Debugger::Cmd::symbolsLookup(std::span<const TclObject> tokens, TclObject&
 	}
 }
 
+void Debugger::Cmd::cheatFinder(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	executeSubCommand(tokens[2].getString(),
+		"start",   [&]{ cheatFinderStart(tokens, result); },
+		"search",  [&]{ cheatFinderSearch(tokens, result); },
+		"retain",  [&]{ cheatFinderRetain(tokens, result); },
+		"results", [&]{ cheatFinderResults(tokens, result); },
+		"count",   [&]{
+			checkNumArgs(tokens, 3, "");
+			result = narrow<int>(debugger().getCheatFinder().count());
+		},
+		"active",  [&]{
+			checkNumArgs(tokens, 3, "");
+			result = debugger().getCheatFinder().isActive();
+		},
+		"stop",    [&]{
+			checkNumArgs(tokens, 3, "");
+			debugger().getCheatFinder().clear();
+		});
+}
+void Debugger::Cmd::cheatFinderStart(std::span<const TclObject> tokens, TclObject& result)
+{
+	bool wordSize = false;
+	std::array info = {flagArg("-word", wordSize)};
+	auto args = parseTclArgs(getInterpreter(), tokens.subspan(3), info);
+	if (args.size() > 1) throw SyntaxError();
+	auto name = args.empty() ? std::string("memory") : std::string(args[0].getString());
+
+	auto& finder = debugger().getCheatFinder();
+	finder.start(debugger().getDebuggable(name), name,
+	             wordSize ? CheatFinder::Width::WORD : CheatFinder::Width::BYTE);
+	result = narrow<int>(finder.count());
+}
+void Debugger::Cmd::cheatFinderSearch(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{4}, "op ?-value <value>? ?-delta <delta>?");
+	auto& finder = debugger().getCheatFinder();
+	if (!finder.isActive()) {
+		throw CommandException("No cheat finder search active, use 'start' first.");
+	}
+	auto opStr = tokens[3].getString();
+	using Op = CheatFinder::Op;
+	CheatFinder::Condition cond;
+	if      (opStr == one_of("eq", "==")) cond.op = Op::EQ;
+	else if (opStr == one_of("ne", "!=")) cond.op = Op::NE;
+	else if (opStr == one_of("lt", "<" )) cond.op = Op::LT;
+	else if (opStr == one_of("le", "<=")) cond.op = Op::LE;
+	else if (opStr == one_of("gt", ">" )) cond.op = Op::GT;
+	else if (opStr == one_of("ge", ">=")) cond.op = Op::GE;
+	else throw CommandException("Invalid comparison operator: ", opStr);
+
+	std::optional<int> delta;
+	std::array info = {valueArg("-value", cond.value),
+	                   valueArg("-delta", delta)};
+	auto args = parseTclArgs(getInterpreter(), tokens.subspan(4), info);
+	if (!args.empty() || (cond.value && delta)) throw SyntaxError();
+	cond.delta = delta.value_or(0);
+
+	try {
+		finder.search(debugger().getDebuggable(finder.getDebuggableName()), cond);
+	} catch (MSXException& e) {
+		throw CommandException(e.getMessage());
+	}
+	result = narrow<int>(finder.count());
+}
+void Debugger::Cmd::cheatFinderRetain(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 4, "addresses");
+	auto& interp = getInterpreter();
+	auto addresses = to_vector(view::transform(xrange(tokens[3].getListLength(interp)),
+		[&](auto i) { return unsigned(tokens[3].getListIndex(interp, i).getInt(interp)); }));
+	auto& finder = debugger().getCheatFinder();
+	finder.retain(addresses);
+	result = narrow<int>(finder.count());
+}
+void Debugger::Cmd::cheatFinderResults(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{3, 4}, "?max?");
+	size_t max = size_t(-1);
+	if (tokens.size() == 4) {
+		auto m = tokens[3].getInt(getInterpreter());
+		if (m < 0) throw CommandException("Invalid maximum: ", m);
+		max = size_t(m);
+	}
+	for (const auto& r : debugger().getCheatFinder().getResults(max)) {
+		result.addListElement(makeTclList(r.address, r.oldValue, r.newValue));
+	}
+}
+
 string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 {
 	auto generalHelp =
@@ -801,6 +919,7 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"    breaked           query CPU breaked status\n"
 		"    disasm            disassemble instructions\n"
 		"    symbols           manage debug symbols\n"
+		"    cheat_finder      search for memory locations with changing values\n"
 		"  The arguments are specific for each subcommand.\n"
 		"  Type 'help debug <subcommand>' for help about a specific subcommand.\n";
 
@@ -829,19 +948,23 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"  The offset must be smaller than the value returned from the "
 		"'size' subcommand\n";
 	auto readBlockHelp =
-		"debug read_block <name> <addr> <size>\n"
+		"debug read_block [-base64] <name> <addr> <size>\n"
 		"  Read a whole block at once. This is equivalent with repeated "
 		"invocations of the 'read' subcommand, but using this subcommand "
 		"may be faster. The result is a Tcl binary string (see Tcl manual).\n"
+		"  With the -base64 option the result is base64 encoded instead, "
+		"this is convenient for external tools connected via the "
+		"control connection.\n"
 		"  The block is specified as size/offset in the debuggable. The "
 		"complete block must fit in the debuggable (see the 'size' "
 		"subcommand).\n";
 	auto writeBlockHelp =
-		"debug write_block <name> <addr> <values>\n"
+		"debug write_block [-base64] <name> <addr> <values>\n"
 		"  Write a whole block at once. This is equivalent with repeated "
 		"invocations of the 'write' subcommand, but using this subcommand "
 		"may be faster. The <values> argument must be a Tcl binary string "
-		"(see Tcl manual).\n"
+		"(see Tcl manual), or a base64 encoded string when the -base64 "
+		"option is given.\n"
 		"  The block has a size and an offset in the debuggable. The "
 		"complete block must fit in the debuggable (see the 'size' "
 		"subcommand).\n";
@@ -974,6 +1097,32 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"           and/or with an optionally given value\n"
 		"  Note: an easier syntax to lookup a symbol value based on the name is:\n"
 		"        $sym(<name>)\n";
+	auto cheatFinderHelp =
+		"debug cheat_finder <subcommand> [<arguments>]\n"
+		"  Search for the location of e.g. the number of lives of a game. "
+		"A search starts with a snapshot of a debuggable, each following "
+		"search step compares a new snapshot with the previous one and only "
+		"keeps the locations for which the comparison holds.\n"
+		"  Possible subcommands are:\n"
+		"    start [-word] [<debuggable>]  start a new search (default debuggable\n"
+		"                                  is 'memory'), with -word search for\n"
+		"                                  16-bit instead of 8-bit values\n"
+		"    search <op> [-value <value>] [-delta <delta>]\n"
+		"           keep the locations where 'new <op> old + delta' or\n"
+		"           'new <op> value' holds, <op> is one of eq ne lt le gt ge\n"
+		"           (or == != < <= > >=)\n"
+		"    retain <addresses>            only keep the given locations\n"
+		"    results [<max>]               returns a list of {address old new}\n"
+		"    count                         returns the number of remaining locations\n"
+		"    active                        returns whether a search was started\n"
+		"    stop                          end the search\n"
+		"  The start, search and retain subcommands return the number of "
+		"remaining locations.\n"
+		"  The search is kept when the machine state changes (reverse, "
+		"loadstate), or when switching machines. Searching in a debuggable "
+		"with a different size gives an error.\n"
+		"  Note that openMSX comes with a 'findcheat' Tcl script that is "
+		"more convenient to use than this subcommand.\n";
 	auto unknownHelp =
 		"Unknown subcommand, use 'help debug' to see a list of valid "
 		"subcommands.\n";
@@ -1026,6 +1175,8 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		return disasmHelp;
 	} else if (tokens[1] == "symbols") {
 		return symbolsHelp;
+	} else if (tokens[1] == "cheat_finder") {
+		return cheatFinderHelp;
 	} else {
 		return unknownHelp;
 	}
@@ -1064,7 +1215,7 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 	static constexpr std::array otherCmds = {
 		"disasm"sv, "set_bp"sv, "remove_bp"sv, "set_watchpoint"sv,
 		"remove_watchpoint"sv, "set_condition"sv, "remove_condition"sv,
-		"probe"sv, "symbols"sv,
+		"probe"sv, "symbols"sv, "cheat_finder"sv,
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -1104,6 +1255,12 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 					"files"sv, "lookup"sv,
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "cheat_finder") {
+				static constexpr std::array subCmds = {
+					"start"sv, "search"sv, "retain"sv,
+					"results"sv, "count"sv, "active"sv, "stop"sv,
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
@@ -14,6 +14,7 @@
 namespace openmsx {
 
 class MSXMotherBoard;
+class CheatFinder;
 class Debuggable;
 class ProbeBase;
 class ProbeBreakPoint;
@@ -49,6 +50,7 @@ public:
 	void transfer(Debugger& other);
 
 	[[nodiscard]] MSXMotherBoard& getMotherBoard() { return motherBoard; }
+	[[nodiscard]] CheatFinder& getCheatFinder();
 
 private:
 	[[nodiscard]] Debuggable& getDebuggable(std::string_view name);
@@ -108,6 +110,11 @@ private:
 		void symbolsRemove(std::span<const TclObject> tokens, TclObject& result);
 		void symbolsFiles(std::span<const TclObject> tokens, TclObject& result);
 		void symbolsLookup(std::span<const TclObject> tokens, TclObject& result);
+		void cheatFinder(std::span<const TclObject> tokens, TclObject& result);
+		void cheatFinderStart(std::span<const TclObject> tokens, TclObject& result);
+		void cheatFinderSearch(std::span<const TclObject> tokens, TclObject& result);
+		void cheatFinderRetain(std::span<const TclObject> tokens, TclObject& result);
+		void cheatFinderResults(std::span<const TclObject> tokens, TclObject& result);
 	} cmd;
 
 	struct NameFromProbe {
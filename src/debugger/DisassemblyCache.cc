@@ -0,0 +1,63 @@
+#include "DisassemblyCache.hh"
+#include "Dasm.hh"
+#include "MSXCPUInterface.hh"
+#include "SymbolManager.hh"
+#include "narrow.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include <cassert>
+
+namespace openmsx {
+
+DisassemblyCache::DisassemblyCache(SymbolManager& symbolManager_)
+	: symbolManager(symbolManager_)
+	, entries(NUM_ENTRIES)
+{
+}
+
+const DisassemblyCache::Line& DisassemblyCache::get(
+	const MSXCPUInterface& cpuInterface, uint16_t addr, EmuTime::param time)
+{
+	auto& entry = entries[addr % NUM_ENTRIES];
+	bool valid = (entry.tag == addr) &&
+	             (entry.symbolGeneration == symbolManager.getGeneration());
+	if (valid) {
+		const auto& line = entry.line;
+		for (auto i : xrange(line.len)) {
+			if (cpuInterface.peekMem(narrow_cast<uint16_t>(addr + i), time) != line.opcodes[i]) {
+				valid = false;
+				break;
+			}
+		}
+	}
+	if (!valid) decode(cpuInterface, addr, time, entry);
+	return entry.line;
+}
+
+void DisassemblyCache::decode(const MSXCPUInterface& cpuInterface, uint16_t addr,
+                              EmuTime::param time, Entry& entry)
+{
+	auto& line = entry.line;
+	line.mnemonic.clear();
+	line.mnemonicAddr.reset();
+	line.mnemonicLabel = false;
+	line.len = narrow<uint8_t>(dasm(cpuInterface, addr, line.opcodes, line.mnemonic, time,
+		[&](std::string& output, uint16_t a) {
+			line.mnemonicAddr = a;
+			if (auto labels = symbolManager.lookupValue(a); !labels.empty()) {
+				strAppend(output, labels.front()->name); // TODO cycle
+				line.mnemonicLabel = true;
+			} else {
+				appendAddrAsHex(output, a);
+			}
+		}));
+	assert(line.len >= 1);
+
+	auto addrLabels = symbolManager.lookupValue(addr);
+	line.addrLabel = addrLabels.empty() ? std::string{} : addrLabels.front()->name; // TODO cycle
+
+	entry.tag = addr;
+	entry.symbolGeneration = symbolManager.getGeneration();
+}
+
+} // namespace openmsx
@@ -0,0 +1,72 @@
+#ifndef DISASSEMBLYCACHE_HH
+#define DISASSEMBLYCACHE_HH
+
+#include "EmuTime.hh"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class MSXCPUInterface;
+class SymbolManager;
+
+/** Caches the disassembly of the instructions shown in a debugger view.
+  *
+  * A disassembly view is redrawn many times per second, while (usually)
+  * only very few of the shown instructions change. Disassembling an
+  * instruction (including the lookup of the symbols for its address and
+  * operand) is relatively expensive, this class avoids redoing that work
+  * for instructions whose opcode bytes didn't change.
+  *
+  * Memory can be changed in ways that can't be (cheaply) detected, e.g. by
+  * the CPU itself, or via a debuggable that doesn't go through
+  * MSXCPUInterface. So on each lookup the opcode bytes are still peeked and
+  * compared with the cached ones (that's cheap). The label of the address and
+  * the operand are re-resolved when the set of symbols changed. Because the
+  * opcode bytes are always verified, nothing needs to be invalidated when
+  * e.g. switching machines.
+  */
+class DisassemblyCache
+{
+public:
+	struct Line {
+		std::array<uint8_t, 4> opcodes;
+		uint8_t len = 0; // length in bytes of the instruction
+		std::string mnemonic; // operand addresses are replaced by labels
+		std::optional<uint16_t> mnemonicAddr; // address used in the operand
+		bool mnemonicLabel = false; // was 'mnemonicAddr' replaced by a label?
+		std::string addrLabel; // label of the address itself, empty if none
+	};
+
+	explicit DisassemblyCache(SymbolManager& symbolManager);
+
+	/** The disassembled instruction starting at the given address. The
+	  * returned reference remains valid until the next call to get(). */
+	[[nodiscard]] const Line& get(const MSXCPUInterface& cpuInterface, uint16_t addr,
+	                              EmuTime::param time);
+
+private:
+	struct Entry {
+		unsigned tag = unsigned(-1); // address of the instruction, -1 if unused
+		unsigned symbolGeneration = 0;
+		Line line;
+	};
+
+	void decode(const MSXCPUInterface& cpuInterface, uint16_t addr,
+	            EmuTime::param time, Entry& entry);
+
+private:
+	SymbolManager& symbolManager;
+
+	// Direct mapped on the lower address bits. A view only shows a small
+	// range of consecutive instructions, so these don't collide.
+	static constexpr unsigned NUM_ENTRIES = 1024;
+	std::vector<Entry> entries;
+};
+
+} // namespace openmsx
+
+#endif
@@ -378,6 +378,7 @@ void SymbolManager::refresh()
 		}
 	}
 
+	++generation;
 	if (observer) observer->notifySymbolsChanged();
 }
 
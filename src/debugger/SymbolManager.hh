@@ -78,6 +78,9 @@ public:
 	[[nodiscard]] std::span<Symbol const * const> lookupValue(uint16_t value);
 	[[nodiscard]] std::optional<uint16_t> parseSymbolOrValue(std::string_view s) const;
 
+	/** Incremented each time the set of symbols changes. */
+	[[nodiscard]] unsigned getGeneration() const { return generation; }
+
 	[[nodiscard]] static std::string getFileFilters();
 	[[nodiscard]] static SymbolFile::Type getTypeForFilter(std::string_view filter);
 
@@ -106,6 +109,7 @@ private:
 private:
 	CommandController& commandController;
 	SymbolObserver* observer = nullptr; // only one for now, could become a vector later
+	unsigned generation = 0;
 	std::vector<SymbolFile> files;
 	hash_map<uint16_t, std::vector<const Symbol*>> lookupValueCache; // calculated from 'files'
 };
@@ -54,6 +54,7 @@
 #include <array>
 #include <sstream>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <stdexcept>
 #include <cassert>
@@ -175,6 +176,16 @@ int unlink(zstring_view path)
 #endif
 }
 
+int rename(zstring_view oldPath, zstring_view newPath)
+{
+#ifdef _WIN32
+	return MoveFileExW(utf8to16(oldPath).c_str(), utf8to16(newPath).c_str(),
+	                   MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+	return ::rename(oldPath.c_str(), newPath.c_str());
+#endif
+}
+
 int rmdir(zstring_view path)
 {
 #ifdef _WIN32
@@ -64,6 +64,12 @@ namespace openmsx::FileOperations {
 	 */
 	int unlink(zstring_view path);
 
+	/**
+	 * Rename a file, replace 'newPath' if it already exists. Like the
+	 * POSIX rename() function (also on windows).
+	 */
+	int rename(zstring_view oldPath, zstring_view newPath);
+
 	/**
 	 * Call rmdir() in a platform-independent manner
 	 */
@@ -7,12 +7,20 @@
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
 #include "Display.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
 #include "GlobalSettings.hh"
 #include "MSXException.hh"
 #include "Timer.hh"
 #include "narrow.hh"
+#include "outer.hh"
+#include "ranges.hh"
 #include "serialize.hh"
+#include "strCat.hh"
 #include "tiger.hh"
+#include "xrange.hh"
+#include "xxhash.hh"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <memory>
@@ -29,6 +37,7 @@ std::shared_ptr<HD::HDInUse> HD::getDrivesInUse(MSXMotherBoard& motherBoard)
 HD::HD(const DeviceConfig& config)
 	: motherBoard(config.getMotherBoard())
 	, name("hdX")
+	, syncFlush(motherBoard.getScheduler())
 {
 	hdInUse = getDrivesInUse(motherBoard);
 
@@ -63,7 +72,9 @@ HD::HD(const DeviceConfig& config)
 		file.truncate(size_t(config.getChildDataAsInt("size", 0)) * 1024 * 1024);
 		filesize = file.getSize();
 	}
+	mapImage();
 	tigerTree.emplace(*this, filesize, filename.getResolved());
+	loadTigerTreeCache();
 
 	(*hdInUse)[id] = true;
 	hdCommand.emplace(
@@ -79,6 +90,14 @@ HD::HD(const DeviceConfig& config)
 
 HD::~HD()
 {
+	try {
+		flushDirtyPages();
+	} catch (MSXException& e) {
+		motherBoard.getMSXCliComm().printWarning(
+			"Couldn't write back changes to hard disk image ",
+			filename.getResolved(), ": ", e.getMessage());
+	}
+	saveTigerTreeCache();
 	motherBoard.unregisterMediaInfo(*this);
 	motherBoard.getMSXCliComm().update(CliComm::HARDWARE, name, "remove");
 
@@ -95,10 +114,14 @@ void HD::getMediaInfo(TclObject& result)
 
 void HD::switchImage(const Filename& newFilename)
 {
+	unmapImage();
+	saveTigerTreeCache();
 	file = File(newFilename);
 	filename = newFilename;
 	filesize = file.getSize();
+	mapImage();
 	tigerTree.emplace(*this, filesize, filename.getResolved());
+	loadTigerTreeCache();
 	motherBoard.getMSXCliComm().update(CliComm::MEDIA, getName(),
 	                                   filename.getResolved());
 }
@@ -108,19 +131,111 @@ size_t HD::getNbSectorsImpl() const
 	return filesize / sizeof(SectorBuffer);
 }
 
+void HD::mapImage()
+{
+	assert(mappedImage.empty() && dirtyList.empty());
+	try {
+		auto data = file.mmap();
+		// File::mmap() returns a private (copy-on-write) mapping, so
+		// it's fine to modify it. Those changes only end up in the
+		// file when we explicitly write them back.
+		mappedImage = {const_cast<uint8_t*>(data.data()), data.size()};
+	} catch (FileException&) {
+		// e.g. image too large for the address space, use plain
+		// file reads/writes instead
+		mappedImage = {};
+	}
+	dirtyPages.assign((mappedImage.size() + DIRTY_PAGE_SIZE - 1) / DIRTY_PAGE_SIZE, false);
+}
+
+void HD::unmapImage()
+{
+	flushDirtyPages();
+	mappedImage = {};
+	dirtyPages.clear();
+	if (file.is_open()) file.munmap();
+}
+
+void HD::flushDirtyPages()
+{
+	if (dirtyList.empty()) return;
+
+	ranges::sort(dirtyList);
+	// write back runs of consecutive pages with a single write
+	size_t i = 0;
+	while (i < dirtyList.size()) {
+		size_t first = dirtyList[i];
+		size_t last = first;
+		while ((++i < dirtyList.size()) && (dirtyList[i] == (last + 1))) {
+			last = dirtyList[i];
+		}
+		size_t begin = first * DIRTY_PAGE_SIZE;
+		size_t end = std::min((last + 1) * DIRTY_PAGE_SIZE, mappedImage.size());
+		file.seek(begin);
+		file.write(mappedImage.subspan(begin, end - begin));
+		for (auto page : xrange(first, last + 1)) dirtyPages[page] = false;
+	}
+	dirtyList.clear();
+	file.flush();
+	// the cached hash is still valid, but the file got a new timestamp
+	tigerTree->notifyChange(0, 0, file.getModificationDate());
+
+	// The written back pages are still private (anonymous) copies in the
+	// mapping, so the memory usage would keep growing with the amount of
+	// data written by the MSX. Map the file again to release them (the
+	// file now has the same content).
+	mappedImage = {};
+	file.munmap();
+	mapImage();
+}
+
+void HD::SyncFlush::executeUntil(EmuTime::param /*time*/)
+{
+	auto& hd = OUTER(HD, syncFlush);
+	try {
+		hd.flushDirtyPages();
+	} catch (MSXException& e) {
+		hd.motherBoard.getMSXCliComm().printWarning(
+			"Couldn't write back changes to hard disk image ",
+			hd.filename.getResolved(), ": ", e.getMessage());
+	}
+}
+
 void HD::readSectorsImpl(
 	std::span<SectorBuffer> buffers, size_t startSector)
 {
-	file.seek(startSector * sizeof(SectorBuffer));
+	size_t offset = startSector * sizeof(SectorBuffer);
+	if (!mappedImage.empty() && ((offset + buffers.size_bytes()) <= mappedImage.size())) {
+		ranges::copy(mappedImage.subspan(offset, buffers.size_bytes()),
+		             std::span{buffers.data()->raw.data(), buffers.size_bytes()});
+		return;
+	}
+	file.seek(offset);
 	file.read(buffers);
 }
 
 void HD::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 {
-	file.seek(sector * sizeof(buf));
+	size_t offset = sector * sizeof(buf);
+	if (!mappedImage.empty() && ((offset + sizeof(buf)) <= mappedImage.size())) {
+		ranges::copy(buf.raw, &mappedImage[offset]);
+		auto page = offset / DIRTY_PAGE_SIZE;
+		if (!dirtyPages[page]) {
+			dirtyPages[page] = true;
+			dirtyList.push_back(page);
+			if (!syncFlush.pendingSyncPoint()) {
+				syncFlush.setSyncPoint(syncFlush.getCurrentTime() + FLUSH_DELAY);
+			}
+		}
+		tigerTree->notifyChange(offset, sizeof(buf), file.getModificationDate());
+		if (dirtyList.size() >= MAX_DIRTY_PAGES) flushDirtyPages();
+		return;
+	}
+	file.seek(offset);
 	file.write(buf.raw);
-	tigerTree->notifyChange(sector * sizeof(buf), sizeof(buf),
-	                        file.getModificationDate());
+	// flush first, so that we record the time of our own write
+	file.flush();
+	tigerTree->notifyChange(offset, sizeof(buf), file.getModificationDate());
 }
 
 bool HD::isWriteProtectedImpl() const
@@ -133,6 +248,7 @@ Sha1Sum HD::getSha1SumImpl(FilePool& filePool)
 	if (hasPatches()) {
 		return SectorAccessibleDisk::getSha1SumImpl(filePool);
 	}
+	flushDirtyPages(); // the file pool reads the file itself
 	return filePool.getSha1Sum(file);
 }
 
@@ -163,6 +279,55 @@ std::string HD::getTigerTreeHash()
 	return tigerTree->calcHash(callback).toString(); // calls HD::getData()
 }
 
+// The (upper levels of the) tiger-tree of an image are stored in a file in the
+// user data directory, so that the next session (typically) doesn't need to
+// recalculate the hash of the full image. TigerTree::loadCache() checks that
+// the cached tree matches the name, size and modification time of the image.
+static std::string getTigerTreeCacheFile(std::string_view imageName)
+{
+	return FileOperations::join(FileOperations::getUserDataDir(), "tthcache",
+	                            strCat(hex_string<8>(xxhash(imageName)), ".tth"));
+}
+
+void HD::loadTigerTreeCache()
+{
+	if (filesize == 0) return;
+	try {
+		auto cacheName = getTigerTreeCacheFile(filename.getResolved());
+		if (!FileOperations::isRegularFile(cacheName)) return;
+		File cacheFile(cacheName);
+		(void)tigerTree->loadCache(cacheFile.mmap());
+	} catch (MSXException&) {
+		// ignore, then we simply recalculate the hash
+	}
+}
+
+void HD::saveTigerTreeCache()
+{
+	// the hash includes IPS patches, that's not what we want to cache
+	if (!file.is_open() || hasPatches()) return;
+	// don't claim the tree matches the file when writing back failed
+	if (!dirtyList.empty()) return;
+	// All our writes are flushed, and each time the tree got the new
+	// modification time. If the file has a different time now, it was
+	// changed by another program, then the tree doesn't match the file.
+	try {
+		if (file.getModificationDate() != tigerTree->getTime()) return;
+	} catch (MSXException&) {
+		return;
+	}
+	auto buf = tigerTree->saveCache();
+	if (buf.empty()) return;
+	try {
+		auto cacheName = getTigerTreeCacheFile(filename.getResolved());
+		FileOperations::mkdirp(std::string(FileOperations::getDirName(cacheName)));
+		File cacheFile(cacheName, File::TRUNCATE);
+		cacheFile.write(buf);
+	} catch (MSXException&) {
+		// ignore, it's only a cache
+	}
+}
+
 uint8_t* HD::getData(size_t offset, size_t size)
 {
 	assert(size <= TigerTree::BLOCK_SIZE);
@@ -178,7 +343,12 @@ uint8_t* HD::getData(size_t offset, size_t size)
 
 	size_t sector = offset / sizeof(SectorBuffer);
 	size_t num    = size   / sizeof(SectorBuffer);
-	readSectors(std::span{work.bufs.data(), num}, sector); // This possibly applies IPS patches.
+	// This copies from the mapped image (when possible) and possibly
+	// applies IPS patches. We can't directly return a pointer into the
+	// mapping: TigerTree temporarily modifies the byte in front of the
+	// returned block, that would turn (nearly) all pages of the mapping
+	// into private copies.
+	readSectors(std::span{work.bufs.data(), num}, sector);
 	return work.bufs[0].raw.data();
 }
 
@@ -240,6 +410,7 @@ void HD::serialize(Archive& ar, unsigned version)
 			//  - So to get in the same state as the initial
 			//    savestate we again close the file. Otherwise the
 			//    checksum-check code below goes wrong.
+			unmapImage();
 			file.close();
 		} else {
 			tmp.updateAfterLoadState();
@@ -249,6 +420,12 @@ void HD::serialize(Archive& ar, unsigned version)
 	}
 
 	// store/check checksum
+	if constexpr (!Archive::IS_LOADER) {
+		// Keep the image file in sync with the savestate. Not needed
+		// for reverse snapshots, the hash below also includes the
+		// changes that are not yet written back.
+		if (!ar.isReverseSnapshot()) flushDirtyPages();
+	}
 	if (file.is_open()) {
 		bool mismatch = false;
 
@@ -7,11 +7,14 @@
 #include "HDCommand.hh"
 #include "SectorAccessibleDisk.hh"
 #include "MSXMotherBoard.hh"
+#include "Schedulable.hh"
 #include "TigerTree.hh"
 #include "serialize_meta.hh"
 #include <bitset>
+#include <span>
 #include <string>
 #include <optional>
+#include <vector>
 
 namespace openmsx {
 
@@ -64,7 +67,23 @@ private:
 
 	void showProgress(size_t position, size_t maxPosition);
 
+	void mapImage();
+	void unmapImage();
+	void flushDirtyPages();
+	void loadTigerTreeCache();
+	void saveTigerTreeCache();
+
 private:
+	/** Granularity (in bytes) in which modified data is written back to
+	  * the image file. */
+	static constexpr size_t DIRTY_PAGE_SIZE = 4096;
+	/** Write back when this many pages are modified ... */
+	static constexpr size_t MAX_DIRTY_PAGES = 256;
+	/** ... or at the latest this long (emulated time) after the first
+	  * modification. This limits the amount of (already acknowledged)
+	  * writes that get lost when openMSX crashes. */
+	static constexpr auto FLUSH_DELAY = EmuDuration::sec(1);
+
 	MSXMotherBoard& motherBoard;
 	std::string name;
 	std::optional<HDCommand> hdCommand; // delayed init
@@ -74,6 +93,24 @@ private:
 	Filename filename;
 	size_t filesize;
 
+	/** The image file mapped in memory, or empty when it couldn't be
+	  * mapped (then we fall back to plain file reads/writes). This is a
+	  * private mapping: sector writes first go to this memory block, the
+	  * modified pages are later written back to the file, see
+	  * flushDirtyPages().
+	  */
+	std::span<uint8_t> mappedImage;
+	std::vector<bool> dirtyPages; // indexed by page number
+	std::vector<size_t> dirtyList; // numbers of the dirty pages, unsorted
+
+	// Not serialized: only triggers flushDirtyPages(), that's not
+	// visible in the emulated machine.
+	struct SyncFlush final : Schedulable {
+		friend class HD;
+		explicit SyncFlush(Scheduler& s) : Schedulable(s) {}
+		void executeUntil(EmuTime::param /*time*/) override;
+	} syncFlush;
+
 	std::shared_ptr<HDInUse> hdInUse;
 
 	uint64_t lastProgressTime;
@@ -8,6 +8,7 @@
 #include "endian.hh"
 #include "narrow.hh"
 #include "one_of.hh"
+#include "ranges.hh"
 #include "serialize.hh"
 #include "xrange.hh"
 #include <algorithm>
@@ -108,8 +109,12 @@ unsigned IDECDROM::readBlockStart(AlignedBuffer& buf, unsigned count)
 	assert(readSectorData);
 	if (file.is_open()) {
 		//fprintf(stderr, "read sector data at %08X\n", transferOffset);
-		file.seek(transferOffset);
-		file.read(std::span{buf.data(), count});
+		if ((size_t(transferOffset) + count) <= mappedImage.size()) {
+			ranges::copy(mappedImage.subspan(transferOffset, count), buf.data());
+		} else {
+			file.seek(transferOffset);
+			file.read(std::span{buf.data(), count});
+		}
 		transferOffset += count;
 		return count;
 	} else {
@@ -306,6 +311,7 @@ void IDECDROM::executePacketCommand(AlignedBuffer& packet)
 
 void IDECDROM::eject()
 {
+	mappedImage = {};
 	file.close();
 	mediaChanged = true;
 	senseKey = 0x06 << 16; // unit attention (medium changed)
@@ -314,7 +320,13 @@ void IDECDROM::eject()
 
 void IDECDROM::insert(const string& filename)
 {
+	mappedImage = {};
 	file = File(filename);
+	try {
+		mappedImage = file.mmap();
+	} catch (FileException&) {
+		// fall back to plain file reads
+	}
 	mediaChanged = true;
 	senseKey = 0x06 << 16; // unit attention (medium changed)
 	getMotherBoard().getMSXCliComm().update(CliComm::MEDIA, name, filename);
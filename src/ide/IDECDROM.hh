@@ -8,6 +8,7 @@
 #include <bitset>
 #include <memory>
 #include <optional>
+#include <span>
 
 namespace openmsx {
 
@@ -80,6 +81,7 @@ private:
 	std::string name;
 	std::optional<CDXCommand> cdxCommand; // delayed init
 	File file;
+	std::span<const uint8_t> mappedImage; // empty if 'file' couldn't be mapped
 	unsigned byteCountLimit;
 	unsigned transferOffset;
 
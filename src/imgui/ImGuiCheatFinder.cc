@@ -4,27 +4,38 @@
 #include "ImGuiManager.hh"
 #include "ImGuiUtils.hh"
 
+#include "CheatFinder.hh"
+#include "Debugger.hh"
+#include "MSXException.hh"
+#include "MSXMotherBoard.hh"
+
+#include "StringOp.hh"
 #include "narrow.hh"
+#include "ranges.hh"
 #include "stl.hh"
 #include "view.hh"
 
+#include <optional>
+
 namespace openmsx {
 
 using namespace std::literals;
 
-void ImGuiCheatFinder::paint(MSXMotherBoard* /*motherBoard*/)
+void ImGuiCheatFinder::paint(MSXMotherBoard* motherBoard)
 {
-	if (!show) return;
+	if (!show || !motherBoard) return;
 
+	auto& debugger = motherBoard->getDebugger();
+	auto& finder = debugger.getCheatFinder();
 	bool start = false;
-	std::string searchExpr;
+	std::optional<CheatFinder::Condition> condition;
 
 	ImGui::SetNextWindowSize(gl::vec2{35, 0} * ImGui::GetFontSize(), ImGuiCond_FirstUseEver);
 	im::Window("Cheat Finder", &show, [&]{
 		const auto& style = ImGui::GetStyle();
 		auto tSize = ImGui::CalcTextSize("=="sv).x + 2.0f * style.FramePadding.x;
 		auto bSpacing = 2.0f;
-		auto height = 12.5f * ImGui::GetTextLineHeightWithSpacing();
+		auto height = 17.0f * ImGui::GetTextLineHeightWithSpacing();
 		auto sWidth = 2.0f * (style.WindowBorderSize + style.WindowPadding.x)
 		              + style.IndentSpacing + 6 * tSize + 5 * bSpacing;
 		im::Child("search", {sWidth, height}, true, [&]{
@@ -33,45 +44,70 @@ void ImGuiCheatFinder::paint(MSXMotherBoard* /*motherBoard*/)
 			           "  openMSX tutorial: Working with the Cheat Finder\n"
 			           "  http://www.youtube.com/watch?v=F11ltfkCtKo\n"
 			           "The UI has changed, but the ideas remain the same.");
-			im::Disabled(searchResults.empty(), [&]{
+			ImGui::SetNextItemWidth(-FLT_MIN);
+			im::Combo("##debuggable", debuggableName.c_str(), [&]{
+				auto names = to_vector<std::string>(view::keys(debugger.getDebuggables()));
+				ranges::sort(names, StringOp::caseless{});
+				for (const auto& name : names) {
+					if (ImGui::Selectable(name.c_str(), name == debuggableName)) {
+						debuggableName = name;
+					}
+				}
+			});
+			simpleToolTip("Search in this debuggable, e.g. use 'Main RAM' to also search "
+			              "the memory mapper pages that are not visible for the CPU.");
+			ImGui::Checkbox("16-bit values", &wordSearch);
+			simpleToolTip("Search for (little endian) 16-bit instead of 8-bit values");
+			ImGui::Separator();
+			im::Disabled(!finder.isActive(), [&]{
 				ImGui::TextUnformatted("Compare"sv);
 				im::Indent([&]{
+					using Op = CheatFinder::Op;
 					auto bSize = ImVec2{tSize, 0.0f};
-					if (ImGui::Button("<",  bSize)) searchExpr = "$new < $old";
-					simpleToolTip("Search for memory locations with strictly decreased value");
+					auto button = [&](const char* label, Op op, const char* tip) {
+						if (ImGui::Button(label, bSize)) condition = CheatFinder::Condition{op, {}, 0};
+						simpleToolTip(tip);
+					};
+					button("<",  Op::LT, "Search for memory locations with strictly decreased value");
 					ImGui::SameLine(0.0f, bSpacing);
-					if (ImGui::Button("<=", bSize)) searchExpr = "$new <= $old";
-					simpleToolTip("Search for memory locations with decreased value");
+					button("<=", Op::LE, "Search for memory locations with decreased value");
 					ImGui::SameLine(0.0f, bSpacing);
-					if (ImGui::Button("!=", bSize)) searchExpr = "$new != $old";
-					simpleToolTip("Search for memory locations with changed value");
+					button("!=", Op::NE, "Search for memory locations with changed value");
 					ImGui::SameLine(0.0f, bSpacing);
-					if (ImGui::Button("==", bSize)) searchExpr = "$new == $old";
-					simpleToolTip("Search for memory locations with unchanged value");
+					button("==", Op::EQ, "Search for memory locations with unchanged value");
 					ImGui::SameLine(0.0f, bSpacing);
-					if (ImGui::Button(">=", bSize)) searchExpr = "$new >= $old";
-					simpleToolTip("Search for memory locations with increased value");
+					button(">=", Op::GE, "Search for memory locations with increased value");
 					ImGui::SameLine(0.0f, bSpacing);
-					if (ImGui::Button(">",  bSize)) searchExpr = "$new > $old";
-					simpleToolTip("Search for memory locations with strictly increased value");
+					button(">",  Op::GT, "Search for memory locations with strictly increased value");
 				});
 				ImGui::TextUnformatted("Specific value"sv);
 				im::Indent([&]{
-					ImGui::SetNextItemWidth(3 * ImGui::GetFontSize());
-					ImGui::InputScalar("##value", ImGuiDataType_U8, &searchValue);
+					ImGui::SetNextItemWidth(4 * ImGui::GetFontSize());
+					ImGui::InputScalar("##value", ImGuiDataType_U16, &searchValue);
 					ImGui::SameLine();
 					if (ImGui::Button("Go")) {
-						searchExpr = strCat("$new == ", searchValue);
+						condition = CheatFinder::Condition{CheatFinder::Op::EQ, int(searchValue), 0};
 					}
 					simpleToolTip("Search for memory locations with a specific value");
 				});
+				ImGui::TextUnformatted("Changed by"sv);
+				im::Indent([&]{
+					ImGui::SetNextItemWidth(4 * ImGui::GetFontSize());
+					ImGui::InputScalar("##delta", ImGuiDataType_S16, &searchDelta);
+					ImGui::SameLine();
+					if (ImGui::Button("Go##delta")) {
+						condition = CheatFinder::Condition{CheatFinder::Op::EQ, {}, searchDelta};
+					}
+					simpleToolTip("Search for memory locations whose value changed by exactly this amount "
+					              "(e.g. -1 when the number of lives decreased by one)");
+				});
 			});
 			start = ImGui::Button("Restart search");
 		});
 
 		ImGui::SameLine();
 		im::Child("result", {0.0f, height}, true, [&]{
-			auto num = searchResults.size();
+			auto num = finder.count();
 			if (num == 0) {
 				ImGui::TextUnformatted("Results: no remaining locations"sv);
 				start = ImGui::Button("Start a new search");
@@ -81,6 +117,13 @@ void ImGuiCheatFinder::paint(MSXMotherBoard* /*motherBoard*/)
 				} else {
 					ImGui::Text("Results: %d remaining locations", narrow<int>(num));
 				}
+				// only show the first locations, that's only a problem at
+				// the start of a search (then the list isn't useful anyway)
+				auto results = finder.getResults(MAX_RESULTS);
+				if (num > results.size()) {
+					ImGui::SameLine();
+					ImGui::Text("(showing the first %d)", narrow<int>(results.size()));
+				}
 				int flags = ImGuiTableFlags_RowBg |
 				            ImGuiTableFlags_BordersV |
 				            ImGuiTableFlags_BordersOuter |
@@ -92,7 +135,8 @@ void ImGuiCheatFinder::paint(MSXMotherBoard* /*motherBoard*/)
 					ImGui::TableSetupColumn("New value");
 					ImGui::TableHeadersRow();
 
-					for (const auto& row : searchResults) {
+					im::ListClipper(results.size(), [&](int i) {
+						const auto& row = results[i];
 						if (ImGui::TableNextColumn()) { // addr
 							ImGui::Text("0x%04x", row.address);
 						}
@@ -102,27 +146,33 @@ void ImGuiCheatFinder::paint(MSXMotherBoard* /*motherBoard*/)
 						if (ImGui::TableNextColumn()) { // new
 							ImGui::Text("%d", row.newValue);
 						}
-					}
+					});
 				});
 			}
 		});
 	});
 
-	if (start) {
-		manager.execute(TclObject("cheat_finder::start"));
-		searchExpr = "1"; // could be optimized, but good enough
-	}
-	if (!searchExpr.empty()) {
-		auto result = manager.execute(makeTclList("cheat_finder::search", searchExpr)).value_or(TclObject{});
-		searchResults = to_vector(view::transform(xrange(result.size()), [&](size_t i) {
-			auto line = result.getListIndexUnchecked(i);
-			auto addr     = line.getListIndexUnchecked(0).getOptionalInt().value_or(0);
-			auto oldValue = line.getListIndexUnchecked(1).getOptionalInt().value_or(0);
-			auto newValue = line.getListIndexUnchecked(2).getOptionalInt().value_or(0);
-			return SearchResult{narrow_cast<uint16_t>(addr),
-			                    narrow_cast<uint8_t>(oldValue),
-			                    narrow_cast<uint8_t>(newValue)};
-		}));
+	try {
+		if (start) {
+			auto* debuggable = debugger.findDebuggable(debuggableName);
+			if (!debuggable) {
+				debuggableName = "memory";
+				debuggable = debugger.findDebuggable(debuggableName);
+			}
+			if (debuggable) {
+				finder.start(*debuggable, debuggableName,
+				             wordSearch ? CheatFinder::Width::WORD : CheatFinder::Width::BYTE);
+			}
+		} else if (condition && finder.isActive()) {
+			if (auto* debuggable = debugger.findDebuggable(finder.getDebuggableName())) {
+				finder.search(*debuggable, *condition);
+			} else {
+				finder.clear();
+			}
+		}
+	} catch (MSXException& e) {
+		manager.printError(e.getMessage());
+		finder.clear();
 	}
 }
 
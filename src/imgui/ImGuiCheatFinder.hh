@@ -4,7 +4,7 @@
 #include "ImGuiPart.hh"
 
 #include <cstdint>
-#include <vector>
+#include <string>
 
 namespace openmsx {
 
@@ -24,13 +24,11 @@ public:
 private:
 	ImGuiManager& manager;
 
-	struct SearchResult {
-		uint16_t address;
-		uint8_t oldValue;
-		uint8_t newValue;
-	};
-	std::vector<SearchResult> searchResults;
-	uint8_t searchValue = 0;
+	static constexpr size_t MAX_RESULTS = 1000; // max number of shown results
+	std::string debuggableName = "memory";
+	bool wordSearch = false;
+	uint16_t searchValue = 0;
+	int16_t searchDelta = 0;
 };
 
 } // namespace openmsx
@@ -36,6 +36,7 @@ namespace openmsx {
 ImGuiDebugger::ImGuiDebugger(ImGuiManager& manager_)
 	: manager(manager_)
 	, symbolManager(manager.getReactor().getSymbolManager())
+	, dasmCache(symbolManager)
 {
 }
 
@@ -345,9 +346,7 @@ void ImGuiDebugger::drawDisassembly(CPURegs& regs, MSXCPUInterface& cpuInterface
 			auto bpEt = breakPoints.end();
 			auto textSize = ImGui::GetTextLineHeight();
 
-			std::string mnemonic;
 			std::string opcodesStr;
-			std::array<uint8_t, 4> opcodes;
 			ImGuiListClipper clipper; // only draw the actually visible rows
 			clipper.Begin(0x10000);
 			if (gotoTarget) {
@@ -406,20 +405,8 @@ void ImGuiDebugger::drawDisassembly(CPURegs& regs, MSXCPUInterface& cpuInterface
 							}
 						}
 
-						mnemonic.clear();
-						std::optional<uint16_t> mnemonicAddr;
-						bool mnemonicLabel = false;
-						auto len = dasm(cpuInterface, addr, opcodes, mnemonic, time,
-							[&](std::string& output, uint16_t a) {
-								mnemonicAddr = a;
-								if (auto labels = symbolManager.lookupValue(a); !labels.empty()) {
-									strAppend(output, labels.front()->name); // TODO cycle
-									mnemonicLabel = true;
-								} else {
-									appendAddrAsHex(output, a);
-								}
-							});
-						assert(len >= 1);
+						const auto& line = dasmCache.get(cpuInterface, narrow<uint16_t>(addr), time);
+						auto len = line.len;
 
 						if (ImGui::TableNextColumn()) { // addr
 							// do the full-row-selectable stuff in a column that cannot be hidden
@@ -459,12 +446,12 @@ void ImGuiDebugger::drawDisassembly(CPURegs& regs, MSXCPUInterface& cpuInterface
 								});
 							});
 
-							auto addrLabels = symbolManager.lookupValue(addr);
-							std::string_view displayAddr = addrLabels.empty() ? std::string_view(addrStr)
-							                                                  : std::string_view(addrLabels.front()->name); // TODO cycle
+							bool hasLabel = !line.addrLabel.empty();
+							std::string_view displayAddr = hasLabel ? std::string_view(line.addrLabel)
+							                                        : std::string_view(addrStr);
 							ImGui::SetCursorPos(pos);
 							ImGui::TextUnformatted(displayAddr);
-							if (!addrLabels.empty()) {
+							if (hasLabel) {
 								simpleToolTip(addrStr);
 							}
 						}
@@ -472,20 +459,20 @@ void ImGuiDebugger::drawDisassembly(CPURegs& regs, MSXCPUInterface& cpuInterface
 						if (ImGui::TableNextColumn()) { // opcode
 							opcodesStr.clear();
 							for (auto i : xrange(len)) {
-								strAppend(opcodesStr, hex_string<2>(opcodes[i]), ' ');
+								strAppend(opcodesStr, hex_string<2>(line.opcodes[i]), ' ');
 							}
 							ImGui::TextUnformatted(opcodesStr.data(), opcodesStr.data() + 3 * len - 1);
 						}
 
 						if (ImGui::TableNextColumn()) { // mnemonic
 							auto pos = ImGui::GetCursorPos();
-							ImGui::TextUnformatted(mnemonic);
-							if (mnemonicAddr) {
+							ImGui::TextUnformatted(line.mnemonic);
+							if (auto mnemonicAddr = line.mnemonicAddr) {
 								ImGui::SetCursorPos(pos);
 								if (ImGui::InvisibleButton("##mnemonicButton", {-FLT_MIN, textSize})) {
 									nextGotoTarget = *mnemonicAddr;
 								}
-								if (mnemonicLabel) {
+								if (line.mnemonicLabel) {
 									simpleToolTip([&]{ return strCat('#', hex_string<4>(*mnemonicAddr)); });
 								}
 							}
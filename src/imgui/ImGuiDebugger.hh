@@ -4,6 +4,7 @@
 #include "ImGuiPart.hh"
 
 #include "Debuggable.hh"
+#include "DisassemblyCache.hh"
 #include "EmuTime.hh"
 
 #include <imgui_memory_editor.h>
@@ -84,6 +85,7 @@ private:
 private:
 	ImGuiManager& manager;
 	SymbolManager& symbolManager;
+	DisassemblyCache dasmCache;
 
 	struct EditorInfo {
 		explicit EditorInfo(const std::string& name_)
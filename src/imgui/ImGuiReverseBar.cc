@@ -352,6 +352,14 @@ void ImGuiReverseBar::paint(MSXMotherBoard* motherBoard)
 			auto timeOffset = totalLength * double(ratio);
 			im::Tooltip([&] {
 				ImGui::TextUnformatted(formatTime(timeOffset));
+				auto toMB = [](size_t bytes) { return double(bytes) / (1024 * 1024); };
+				auto budget = reverseManager.getMemoryBudget();
+				ImGui::TextDisabled("%d snapshots, %.1fMB", int(snapshots.size()),
+				                    toMB(reverseManager.getMemoryUsage()));
+				if (budget) {
+					ImGui::SameLine(0.0f, 0.0f);
+					ImGui::TextDisabled(" (limit %.0fMB)", toMB(budget));
+				}
 			});
 			if (ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
 				manager.executeDelayed(makeTclList("reverse", "goto", b + timeOffset));
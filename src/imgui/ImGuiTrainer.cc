@@ -5,12 +5,17 @@
 #include "ImGuiManager.hh"
 #include "ImGuiUtils.hh"
 
+#include "MSXMotherBoard.hh"
+#include "Trainer.hh"
+
 #include "StringOp.hh"
+#include "narrow.hh"
 #include "xrange.hh"
 
 #include <imgui_stdlib.h>
 
-#include <algorithm>
+#include <span>
+#include <string_view>
 
 namespace openmsx {
 
@@ -26,7 +31,7 @@ void ImGuiTrainer::loadLine(std::string_view name, zstring_view value)
 	loadOnePersistent(name, value, *this, persistentElements);
 }
 
-void ImGuiTrainer::paint(MSXMotherBoard* /*motherBoard*/)
+void ImGuiTrainer::paint(MSXMotherBoard* motherBoard)
 {
 	if (!show) return;
 
@@ -39,8 +44,13 @@ void ImGuiTrainer::paint(MSXMotherBoard* /*motherBoard*/)
 		}));
 		ranges::sort(gameNames, StringOp::caseless{});
 	}
-	auto activeGame = manager.execute(makeTclList("set", "trainer::active_trainer")).value_or(TclObject{});
-	auto activeList = manager.execute(makeTclList("set", "trainer::items_active")).value_or(TclObject{});
+	std::string_view activeGame;
+	std::span<const Trainer::Cheat> cheats;
+	if (motherBoard) {
+		const auto& trainer = motherBoard->getTrainer();
+		activeGame = trainer.getGame();
+		cheats = trainer.getCheats();
+	}
 
 	std::optional<std::string> newGame;
 	std::optional<int> toggleItem;
@@ -50,8 +60,7 @@ void ImGuiTrainer::paint(MSXMotherBoard* /*motherBoard*/)
 	ImGui::SetNextWindowSize(gl::vec2{28, 26} * ImGui::GetFontSize(), ImGuiCond_FirstUseEver);
 	im::Window("Trainer Selector", &show, ImGuiWindowFlags_HorizontalScrollbar, [&]{
 		ImGui::TextUnformatted("Select Game:"sv);
-		zstring_view displayName = activeGame.getString();
-		if (displayName.empty()) displayName = "none";
+		std::string displayName = activeGame.empty() ? "none" : std::string(activeGame);
 		bool useFilter = im::TreeNode("filter", [&]{
 			ImGui::InputText(ICON_IGFD_SEARCH, &filterString);
 			HelpMarker("A list of substrings that must be part of the game name.\n"
@@ -87,7 +96,7 @@ void ImGuiTrainer::paint(MSXMotherBoard* /*motherBoard*/)
 		}
 		ImGui::Separator();
 
-		im::Disabled(activeGame.getString().empty(), [&]{
+		im::Disabled(activeGame.empty(), [&]{
 			ImGui::AlignTextToFramePadding();
 			ImGui::TextUnformatted("Select Cheats:"sv);
 			ImGui::SameLine();
@@ -95,14 +104,10 @@ void ImGuiTrainer::paint(MSXMotherBoard* /*motherBoard*/)
 			ImGui::SameLine();
 			none = ImGui::Button("None");
 
-			TclObject items = trainers->getOptionalDictValue(activeGame).value_or(TclObject{})
-				.getOptionalDictValue(TclObject("items")).value_or(TclObject{});
-			auto numItems = std::min(activeList.size(), items.size() / 2);
-			for (auto i : xrange(numItems)) {
-				bool active = activeList.getListIndexUnchecked(i).getOptionalBool().value_or(false);
-				auto name = items.getListIndexUnchecked(2 * i + 0).getString();
-				if (ImGui::Checkbox(name.c_str(), &active)) {
-					toggleItem = i;
+			for (auto i : xrange(cheats.size())) {
+				bool active = cheats[i].active;
+				if (ImGui::Checkbox(cheats[i].name.c_str(), &active)) {
+					toggleItem = narrow<int>(i);
 				}
 			}
 		});
@@ -114,9 +119,9 @@ void ImGuiTrainer::paint(MSXMotherBoard* /*motherBoard*/)
 		manager.execute(makeTclList("trainer", activeGame, *toggleItem + 1));
 	} else if (all || none) {
 		auto cmd = makeTclList("trainer", activeGame);
-		for (auto i : xrange(activeList.size())) {
-			if (activeList.getListIndexUnchecked(i).getOptionalBool().value_or(false) == none) {
-				cmd.addListElement(i + 1);
+		for (auto i : xrange(cheats.size())) {
+			if (cheats[i].active == none) {
+				cmd.addListElement(narrow<int>(i + 1));
 			}
 		}
 		manager.execute(cmd);
@@ -5,6 +5,8 @@
 #include "GlobalSettings.hh"
 #include "StringSetting.hh"
 #include "narrow.hh"
+#include "ranges.hh"
+#include "serialize.hh"
 #include "xrange.hh"
 #include <cassert>
 
@@ -12,10 +14,14 @@ namespace openmsx {
 
 CheckedRam::CheckedRam(const DeviceConfig& config, const std::string& name,
                        static_string_view description, size_t size)
-	: ram(config, name, description, size)
+	: dirtyPages((size + PAGE_SIZE - 1) / PAGE_SIZE, true)
+	, ram(config, name, description, size)
 	, msxcpu(config.getMotherBoard().getCPU())
 	, umrCallback(config.getGlobalSettings().getUMRCallBackSetting())
 {
+	ram.setDebugWriteCallback([this](size_t addr, size_t sz) {
+		markDirty(addr, sz);
+	});
 	umrCallback.getSetting().attach(*this);
 	init();
 }
@@ -44,8 +50,13 @@ const byte* CheckedRam::getReadCacheLine(size_t addr) const
 
 byte* CheckedRam::getWriteCacheLine(size_t addr) const
 {
-	return (completely_initialized_cacheline[addr >> CacheLine::BITS])
-	     ? const_cast<byte*>(&ram[addr]) : nullptr;
+	if (!completely_initialized_cacheline[addr >> CacheLine::BITS]) {
+		return nullptr;
+	}
+	// We can't see the writes via this cache line, so assume the
+	// page gets written.
+	markDirty(addr, CacheLine::SIZE);
+	return const_cast<byte*>(&ram[addr]);
 }
 
 byte* CheckedRam::getRWCacheLines(size_t addr, size_t size) const
@@ -58,6 +69,7 @@ byte* CheckedRam::getRWCacheLines(size_t addr, size_t size) const
 			return nullptr;
 		}
 	}
+	markDirty(addr, size); // see getWriteCacheLine()
 	return const_cast<byte*>(&ram[addr]);
 }
 
@@ -79,15 +91,29 @@ void CheckedRam::write(size_t addr, const byte value)
 			msxcpu.invalidateAllSlotsRWCache(0, 0x10000);
 		}
 	}
+	dirtyPages[addr / PAGE_SIZE] = true;
 	ram[addr] = value;
 }
 
 void CheckedRam::clear()
 {
+	markAllDirty();
 	ram.clear();
 	init();
 }
 
+void CheckedRam::markDirty(size_t addr, size_t size) const
+{
+	for (auto page : xrange(addr / PAGE_SIZE, (addr + size - 1) / PAGE_SIZE + 1)) {
+		dirtyPages[page] = true;
+	}
+}
+
+void CheckedRam::markAllDirty() const
+{
+	dirtyPages.assign(dirtyPages.size(), true);
+}
+
 void CheckedRam::init()
 {
 	auto lines = ram.size() / CacheLine::SIZE;
@@ -114,4 +140,27 @@ void CheckedRam::update(const Setting& setting) noexcept
 	init();
 }
 
+template<typename Archive>
+void CheckedRam::serialize(Archive& ar, unsigned /*version*/)
+{
+	// ar.serialize_blob_pages("ram", std::span{ram}, ...); // TODO error with clang-15/libc++
+	ar.serialize_blob_pages("ram", std::span{ram.begin(), ram.end()}, PAGE_SIZE, dirtyPages);
+	if constexpr (Archive::IS_LOADER) {
+		markAllDirty();
+	} else {
+		if (ar.isReverseSnapshot() && trackDirtyPages &&
+		    ranges::any_of(dirtyPages, std::identity{})) {
+			dirtyPages.assign(dirtyPages.size(), false);
+			// Write pointers to the (previously dirty) pages may still
+			// be present in the CPU cache. Drop those, so that the next
+			// write to such a page again goes via getWriteCacheLine().
+			// A clean page can't have such pointers: handing one out
+			// marks the page dirty. So when nothing was dirty there's
+			// nothing to invalidate.
+			msxcpu.invalidateAllSlotsWCache(0, 0x10000);
+		}
+	}
+}
+INSTANTIATE_SERIALIZE_METHODS(CheckedRam);
+
 } // namespace openmsx
@@ -23,10 +23,19 @@ class Setting;
  * the turboR, only the normal memory mapper runs via CheckedRam. The RAM
  * accessed in DRAM mode or via the ROM mapper are unchecked! Note that there
  * is basically no overhead for using CheckedRam over Ram, thanks to Wouter.
+ *
+ * This class also keeps track of which pages (of PAGE_SIZE bytes) have been
+ * written to since the last reverse snapshot. Writes via the CPU cache are not
+ * seen individually, instead a page is marked dirty when a write cache line
+ * for it is handed out. After a reverse snapshot all pages are marked clean
+ * again and the CPU write cache is invalidated. Writes via the debuggable of
+ * the underlying Ram also mark the page dirty.
  */
 class CheckedRam final : private Observer<Setting>
 {
 public:
+	static constexpr size_t PAGE_SIZE = 0x4000;
+
 	CheckedRam(const DeviceConfig& config, const std::string& name,
 	           static_string_view description, size_t size);
 	~CheckedRam();
@@ -47,15 +56,23 @@ public:
 	 * will just be no checking done! Keep in mind that you should use this
 	 * consistently, so that the initialized-administration will be always
 	 * up to date!
+	 * Writes via this Ram cannot be tracked, so (from now on) all pages
+	 * are considered dirty for reverse snapshots.
 	 */
-	[[nodiscard]] Ram& getUncheckedRam() { return ram; }
+	[[nodiscard]] Ram& getUncheckedRam() {
+		trackDirtyPages = false;
+		markAllDirty();
+		return ram;
+	}
 
-	// TODO
-	//template<typename Archive>
-	//void serialize(Archive& ar, unsigned version);
+	// Note: Uses the exact same serialization format as the Ram class.
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
 
 private:
 	void init();
+	void markDirty(size_t addr, size_t size) const;
+	void markAllDirty() const;
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
@@ -63,6 +80,10 @@ private:
 private:
 	std::vector<bool> completely_initialized_cacheline;
 	std::vector<std::bitset<CacheLine::SIZE>> uninitialized;
+	// Pages written since the last reverse snapshot. Mutable because it's
+	// updated from getWriteCacheLine() and getRWCacheLines().
+	mutable std::vector<bool> dirtyPages;
+	bool trackDirtyPages = true;
 	Ram ram;
 	MSXCPU& msxcpu;
 	TclCallback umrCallback;
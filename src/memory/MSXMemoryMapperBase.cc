@@ -134,8 +134,7 @@ void MSXMemoryMapperBase::serialize(Archive& ar, unsigned version)
 	if (ar.versionAtLeast(version, 2)) {
 		ar.serialize("registers", registers);
 	}
-	// TODO ar.serialize("checkedRam", checkedRam);
-	ar.serialize("ram", checkedRam.getUncheckedRam());
+	ar.serialize("ram", checkedRam);
 }
 INSTANTIATE_SERIALIZE_METHODS(MSXMemoryMapperBase);
 //REGISTER_MSXDEVICE(MSXMemoryMapperBase, "MemoryMapper");
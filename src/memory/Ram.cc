@@ -6,9 +6,11 @@
 #include "MSXException.hh"
 #include "narrow.hh"
 #include "one_of.hh"
+#include "ranges.hh"
 #include "serialize.hh"
 #include <zlib.h>
 #include <algorithm>
+#include <cassert>
 #include <memory>
 
 namespace openmsx {
@@ -96,6 +98,21 @@ byte RamDebuggable::read(unsigned address)
 void RamDebuggable::write(unsigned address, byte value)
 {
 	ram[address] = value;
+	ram.debugWritten(address, 1);
+}
+
+void RamDebuggable::readBlock(unsigned address, std::span<byte> output)
+{
+	assert((address + output.size()) <= ram.size());
+	ranges::copy(std::span{&ram[address], output.size()}, output);
+}
+
+void RamDebuggable::writeBlock(unsigned address, std::span<const byte> input)
+{
+	assert((address + input.size()) <= ram.size());
+	if (input.empty()) return;
+	ranges::copy(input, &ram[address]);
+	ram.debugWritten(address, input.size());
 }
 
 
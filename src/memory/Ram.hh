@@ -5,6 +5,7 @@
 #include "MemBuffer.hh"
 #include "openmsx.hh"
 #include "static_string_view.hh"
+#include <functional>
 #include <optional>
 #include <string>
 
@@ -21,6 +22,8 @@ public:
 	              static_string_view description, Ram& ram);
 	byte read(unsigned address) override;
 	void write(unsigned address, byte value) override;
+	void readBlock(unsigned address, std::span<byte> output) override;
+	void writeBlock(unsigned address, std::span<const byte> input) override;
 private:
 	Ram& ram;
 };
@@ -52,6 +55,17 @@ public:
 	[[nodiscard]] const std::string& getName() const;
 	void clear(byte c = 0xff);
 
+	/** Install a callback that's invoked after the content got changed
+	  * via the debuggable. Such writes bypass the owner of this object
+	  * (e.g. CheckedRam or TrackedRam), this allows it to still see them.
+	  */
+	void setDebugWriteCallback(std::function<void(size_t addr, size_t size)> callback) {
+		debugWriteCallback = std::move(callback);
+	}
+	void debugWritten(size_t addr, size_t size) const {
+		if (debugWriteCallback) debugWriteCallback(addr, size);
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -59,6 +73,7 @@ private:
 	const XMLElement& xml;
 	MemBuffer<byte> ram;
 	size_t sz; // must come before debuggable
+	std::function<void(size_t, size_t)> debugWriteCallback;
 	const std::optional<RamDebuggable> debuggable; // can be nullopt
 };
 
@@ -41,6 +41,8 @@ public:
 	[[nodiscard]] std::string_view getDescription() const override;
 	[[nodiscard]] byte read(unsigned address) override;
 	void write(unsigned address, byte value) override;
+	void readBlock(unsigned address, std::span<byte> output) override;
+	void writeBlock(unsigned address, std::span<const byte> input) override;
 	void moved(Rom& r);
 private:
 	Debugger& debugger;
@@ -417,6 +419,17 @@ void RomDebuggable::write(unsigned /*address*/, byte /*value*/)
 	// ignore
 }
 
+void RomDebuggable::readBlock(unsigned address, std::span<byte> output)
+{
+	assert((address + output.size()) <= getSize());
+	ranges::copy(std::span{&(*rom)[address], output.size()}, output);
+}
+
+void RomDebuggable::writeBlock(unsigned /*address*/, std::span<const byte> /*input*/)
+{
+	// ignore
+}
+
 void RomDebuggable::moved(Rom& r)
 {
 	rom = &r;
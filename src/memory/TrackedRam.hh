@@ -2,20 +2,34 @@
 #define TRACKED_RAM_HH
 
 #include "Ram.hh"
+#include "xrange.hh"
+#include <vector>
 
 namespace openmsx {
 
-// Ram with dirty tracking
+// Ram with dirty tracking, per page of PAGE_SIZE bytes
 class TrackedRam
 {
 public:
+	static constexpr size_t PAGE_SIZE = 0x4000;
+
 	// Most methods simply delegate to the internal 'ram' object.
 	TrackedRam(const DeviceConfig& config, const std::string& name,
 	           static_string_view description, size_t size)
-		: ram(config, name, description, size) {}
+		: ram(config, name, description, size)
+		, dirtyPages(numPages(size), true)
+	{
+		// writes via the debuggable also make a page dirty
+		ram.setDebugWriteCallback([this](size_t addr, size_t sz) {
+			for (auto page : xrange(addr / PAGE_SIZE, (addr + sz - 1) / PAGE_SIZE + 1)) {
+				dirtyPages[page] = true;
+			}
+		});
+	}
 
 	TrackedRam(const XMLElement& xml, size_t size)
-		: ram(xml, size) {}
+		: ram(xml, size)
+		, dirtyPages(numPages(size), true) {}
 
 	[[nodiscard]] size_t size() const {
 		return ram.size();
@@ -39,12 +53,12 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(size_t addr, byte value) {
-		writeSinceLastReverseSnapshot = true;
+		dirtyPages[addr / PAGE_SIZE] = true;
 		ram[addr] = value;
 	}
 
 	void clear(byte c = 0xff) {
-		writeSinceLastReverseSnapshot = true;
+		markAllDirty();
 		ram.clear(c);
 	}
 
@@ -53,16 +67,24 @@ public:
 	// invocation, so the resulting pointer (although the same each time)
 	// should not be reused for multiple (distinct) bulk write operations.
 	[[nodiscard]] std::span<byte> getWriteBackdoor() {
-		writeSinceLastReverseSnapshot = true;
+		markAllDirty();
 		return {ram.data(), size()};
 	}
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
+private:
+	[[nodiscard]] static size_t numPages(size_t size) {
+		return (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	}
+	void markAllDirty() {
+		dirtyPages.assign(dirtyPages.size(), true);
+	}
+
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	std::vector<bool> dirtyPages; // written since last reverse snapshot?
 };
 
 } // namespace openmsx
@@ -15,6 +15,7 @@
 #include "stl.hh"
 #include "build-info.hh"
 #include "cstdiop.hh" // for dup()
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
@@ -230,6 +231,23 @@ void MemOutputArchive::serialize_blob(const char* /*tag*/, std::span<const uint8
 	}
 }
 
+void MemOutputArchive::serialize_blob_pages(
+	const char* tag, std::span<const uint8_t> data,
+	size_t pageSize, const std::vector<bool>& dirtyPages)
+{
+	// Each page becomes a separate blob (with its own delta-compression
+	// history). Clean pages are identical to the previous snapshot, so
+	// for those we can reuse the previous DeltaBlock. That's only
+	// correct for reverse snapshots, for other memory archives the dirty
+	// pages were not tracked relative to this archive.
+	assert(((data.size() + pageSize - 1) / pageSize) == dirtyPages.size());
+	for (size_t i = 0; !data.empty(); ++i) {
+		auto page = data.first(std::min(pageSize, data.size()));
+		serialize_blob(tag, page, dirtyPages[i] || !reverseSnapshot);
+		data = data.subspan(page.size());
+	}
+}
+
 void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> data,
                                      bool /*diff*/)
 {
@@ -250,6 +268,18 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> dat
 	}
 }
 
+void MemInputArchive::serialize_blob_pages(
+	const char* tag, std::span<uint8_t> data,
+	size_t pageSize, const std::vector<bool>& /*dirtyPages*/)
+{
+	// same page layout as in MemOutputArchive
+	while (!data.empty()) {
+		auto page = data.first(std::min(pageSize, data.size()));
+		serialize_blob(tag, page);
+		data = data.subspan(page.size());
+	}
+}
+
 ////
 
 XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
@@ -269,7 +299,18 @@ XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
 		// on scope-exit 'f' is closed, and 'file'
 		// uses the dup()'ed file descriptor.
 	}
+	writeHeader();
+}
 
+XmlOutputArchive::XmlOutputArchive(std::string& buffer_)
+	: buffer(&buffer_)
+	, writer(*this)
+{
+	writeHeader();
+}
+
+void XmlOutputArchive::writeHeader()
+{
 	static constexpr std::string_view header =
 		"<?xml version=\"1.0\" ?>\n"
 		"<!DOCTYPE openmsx-serialize SYSTEM 'openmsx-serialize.dtd'>\n";
@@ -283,9 +324,13 @@ XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
 
 void XmlOutputArchive::close()
 {
-	if (!file) return; // already closed
+	if (!file && !buffer) return; // already closed
 
 	writer.end("serial");
+	if (buffer) {
+		buffer = nullptr;
+		return;
+	}
 
 	if (gzclose(file) != Z_OK) {
 		error();
@@ -304,6 +349,10 @@ XmlOutputArchive::~XmlOutputArchive()
 
 void XmlOutputArchive::write(std::span<const char> buf)
 {
+	if (buffer) {
+		buffer->append(buf.data(), buf.size());
+		return;
+	}
 	if ((gzwrite(file, buf.data(), unsigned(buf.size())) == 0) && !buf.empty()) {
 		error();
 	}
@@ -311,6 +360,10 @@ void XmlOutputArchive::write(std::span<const char> buf)
 
 void XmlOutputArchive::write1(char c)
 {
+	if (buffer) {
+		*buffer += c;
+		return;
+	}
 	if (gzputc(file, c) == -1) {
 		error();
 	}
@@ -398,6 +451,13 @@ XmlInputArchive::XmlInputArchive(const string& filename)
 	elems.emplace_back(root, root->getFirstChild());
 }
 
+XmlInputArchive::XmlInputArchive(std::string_view name, std::string_view xml)
+{
+	xmlDoc.load(name, xml, "openmsx-serialize.dtd");
+	const auto* root = xmlDoc.getRoot();
+	elems.emplace_back(root, root->getFirstChild());
+}
+
 string_view XmlInputArchive::loadStr()
 {
 	if (currentElement()->hasChildren()) {
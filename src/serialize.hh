@@ -148,6 +148,17 @@ public:
 	//   cannot know whether a byte-array should be serialized as a blob
 	//   or as a collection of bytes (IOW we cannot decide it based on the
 	//   type).
+	//
+	//
+	// void serialize_blob_pages(const char* tag, std::span<uint8_t> data,
+	//                           size_t pageSize, const std::vector<bool>& dirtyPages)
+	//
+	//   Like serialize_blob(), but the blob is divided in pages of
+	//   'pageSize' bytes (the last page may be smaller). The caller keeps
+	//   track of which pages were written since the previous reverse
+	//   snapshot. Memory archives only delta-compress the dirty pages, the
+	//   other pages are not even read. Other archives store the whole blob
+	//   (so in the same format as serialize_blob()).
 
 	template<typename T>
 	void serialize_blob(const char* tag, std::span<T> data, bool diff = true)
@@ -477,6 +488,11 @@ public:
 	// the resulting string. But memory archives will memcpy the blob.
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, std::span<const uint8_t> data,
+	                          size_t /*pageSize*/, const std::vector<bool>& /*dirtyPages*/)
+	{
+		this->self().serialize_blob(tag, data);
+	}
 
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
@@ -572,6 +588,11 @@ public:
 	}
 	void serialize_blob(const char* tag, std::span<uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, std::span<uint8_t> data,
+	                          size_t /*pageSize*/, const std::vector<bool>& /*dirtyPages*/)
+	{
+		this->self().serialize_blob(tag, data);
+	}
 
 	template<typename T>
 	void serialize(const char* tag, T& t)
@@ -683,6 +704,8 @@ public:
 	void save(std::string_view s);
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, std::span<const uint8_t> data,
+	                          size_t pageSize, const std::vector<bool>& dirtyPages);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -795,6 +818,8 @@ public:
 	[[nodiscard]] std::string_view loadStr();
 	void serialize_blob(const char* tag, std::span<uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob_pages(const char* tag, std::span<uint8_t> data,
+	                          size_t pageSize, const std::vector<bool>& dirtyPages);
 
 	using InputArchiveBase<MemInputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -858,6 +883,9 @@ class XmlOutputArchive final : public OutputArchiveBase<XmlOutputArchive>
 {
 public:
 	explicit XmlOutputArchive(zstring_view filename);
+	// Write the (uncompressed) xml document to the given string instead
+	// of to a file. The document is complete after close().
+	explicit XmlOutputArchive(std::string& buffer);
 	void close();
 	~XmlOutputArchive();
 
@@ -923,9 +951,13 @@ public:
 	void check(bool condition) const;
 	void error();
 
+private:
+	void writeHeader();
+
 private:
 	zstring_view filename;
 	gzFile file = nullptr;
+	std::string* buffer = nullptr;
 	XMLOutputStream<XmlOutputArchive> writer;
 };
 
@@ -933,6 +965,8 @@ class XmlInputArchive final : public InputArchiveBase<XmlInputArchive>
 {
 public:
 	explicit XmlInputArchive(const std::string& filename);
+	// Parse an in-memory xml document, 'name' is only used in error messages.
+	XmlInputArchive(std::string_view name, std::string_view xml);
 
 	[[nodiscard]] inline bool versionAtLeast(unsigned actual, unsigned required) const
 	{
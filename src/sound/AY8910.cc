@@ -15,6 +15,7 @@
 #include "MSXException.hh"
 #include "Math.hh"
 #include "StringOp.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 #include "cstd.hh"
 #include "narrow.hh"
@@ -490,6 +491,7 @@ AY8910::AY8910(const std::string& name_, AY8910Periphery& periphery_,
 
 	// make valgrind happy
 	ranges::fill(regs, 0);
+	ranges::fill(soundRegs, 0);
 
 	reset(time);
 	registerSound(config);
@@ -509,6 +511,7 @@ AY8910::~AY8910()
 
 void AY8910::reset(EmuTime::param time)
 {
+	flushDeferredWrites();
 	// Reset generators and envelope.
 	for (auto& t : tone) t.reset();
 	noise.reset();
@@ -567,13 +570,24 @@ uint8_t AY8910::peekRegister(unsigned reg, EmuTime::param time) const
 void AY8910::writeRegister(unsigned reg, uint8_t value, EmuTime::param time)
 {
 	if (reg >= 16) return;
+	if (vgmRecorder && (reg < AY_PORTA)) [[unlikely]] {
+		vgmRecorder->write(VGMChip::AY8910, uint8_t(reg), value, time);
+	}
 	if ((reg < AY_PORTA) && (reg == AY_ESHAPE || regs[reg] != value)) {
+		if (deferWritesEnabled()) {
+			// Only update 'regs' now, the sound generation state is
+			// updated later, see applyDeferredWrite().
+			wrtReg(reg, value, time, false);
+			deferWrite(reg, regs[reg], time);
+			return;
+		}
 		// Update the output buffer before changing the register.
 		updateStream(time);
+		flushDeferredWrites(); // in case the setting was just turned off
 	}
 	wrtReg(reg, value, time);
 }
-void AY8910::wrtReg(unsigned reg, uint8_t value, EmuTime::param time)
+void AY8910::wrtReg(unsigned reg, uint8_t value, EmuTime::param time, bool updateSound)
 {
 	// Warn/force port directions
 	if (reg == AY_ENABLE) {
@@ -592,40 +606,11 @@ void AY8910::wrtReg(unsigned reg, uint8_t value, EmuTime::param time)
 	uint8_t diff = regs[reg] ^ value;
 	regs[reg] = value;
 
+	if ((reg < AY_PORTA) && updateSound) {
+		wrtSoundReg(reg, value);
+	}
+
 	switch (reg) {
-	case AY_AFINE:
-	case AY_ACOARSE:
-	case AY_BFINE:
-	case AY_BCOARSE:
-	case AY_CFINE:
-	case AY_CCOARSE:
-		tone[reg / 2].setPeriod(regs[reg & ~1] + 256 * (regs[reg | 1] & 0x0F));
-		break;
-	case AY_NOISEPER:
-		// Half the frequency of tone generation.
-		//
-		// Verified on turboR GT: value=0 and value=1 sound the same.
-		//
-		// Likely in real AY8910 this is implemented by driving the
-		// noise generator at halve the frequency instead of
-		// multiplying the value by 2 (hence the correction for value=0
-		// here). But the effect is the same(?).
-		noise.setPeriod(2 * std::max(1, value & 0x1F));
-		break;
-	case AY_AVOL:
-	case AY_BVOL:
-	case AY_CVOL:
-		amplitude.setChannelVolume(reg - AY_AVOL, value);
-		break;
-	case AY_EFINE:
-	case AY_ECOARSE:
-		// also half the frequency of tone generation, but handled
-		// inside Envelope::setPeriod()
-		envelope.setPeriod(regs[AY_EFINE] + 256 * regs[AY_ECOARSE]);
-		break;
-	case AY_ESHAPE:
-		envelope.setShape(value);
-		break;
 	case AY_ENABLE:
 		if (diff & PORT_A_DIRECTION) {
 			// port A changed
@@ -660,6 +645,51 @@ void AY8910::wrtReg(unsigned reg, uint8_t value, EmuTime::param time)
 		break;
 	}
 }
+void AY8910::wrtSoundReg(unsigned reg, uint8_t value)
+{
+	soundRegs[reg] = value;
+
+	switch (reg) {
+	case AY_AFINE:
+	case AY_ACOARSE:
+	case AY_BFINE:
+	case AY_BCOARSE:
+	case AY_CFINE:
+	case AY_CCOARSE:
+		tone[reg / 2].setPeriod(soundRegs[reg & ~1] + 256 * (soundRegs[reg | 1] & 0x0F));
+		break;
+	case AY_NOISEPER:
+		// Half the frequency of tone generation.
+		//
+		// Verified on turboR GT: value=0 and value=1 sound the same.
+		//
+		// Likely in real AY8910 this is implemented by driving the
+		// noise generator at halve the frequency instead of
+		// multiplying the value by 2 (hence the correction for value=0
+		// here). But the effect is the same(?).
+		noise.setPeriod(2 * std::max(1, value & 0x1F));
+		break;
+	case AY_AVOL:
+	case AY_BVOL:
+	case AY_CVOL:
+		amplitude.setChannelVolume(reg - AY_AVOL, value);
+		break;
+	case AY_EFINE:
+	case AY_ECOARSE:
+		// also half the frequency of tone generation, but handled
+		// inside Envelope::setPeriod()
+		envelope.setPeriod(soundRegs[AY_EFINE] + 256 * soundRegs[AY_ECOARSE]);
+		break;
+	case AY_ESHAPE:
+		envelope.setShape(value);
+		break;
+	}
+}
+
+void AY8910::applyDeferredWrite(unsigned reg, uint8_t value)
+{
+	wrtSoundReg(reg, value);
+}
 
 [[nodiscard]] static inline float calc(bool b, float f)
 {
@@ -677,7 +707,7 @@ void AY8910::generateChannels(std::span<float*> bufs, unsigned num)
 {
 	// Disable channels with volume 0: since the sample value doesn't matter,
 	// we can use the fastest path.
-	unsigned chanEnable = regs[AY_ENABLE];
+	unsigned chanEnable = soundRegs[AY_ENABLE];
 	for (auto chan : xrange(3)) {
 		if ((!amplitude.followsEnvelope(chan) &&
 		     (amplitude.getVolume(chan) == 0.0f)) ||
@@ -964,6 +994,11 @@ float AY8910::getAmplificationFactorImpl() const
 	return 1.0f;
 }
 
+VGMChip AY8910::getVGMChip() const
+{
+	return VGMChip::AY8910;
+}
+
 void AY8910::update(const Setting& setting) noexcept
 {
 	if (&setting == one_of(&vibratoPercent, &detunePercent)) {
@@ -1002,6 +1037,9 @@ void AY8910::Debuggable::write(unsigned address, uint8_t value, EmuTime::param t
 template<typename Archive>
 void AY8910::serialize(Archive& ar, unsigned /*version*/)
 {
+	if constexpr (!Archive::IS_LOADER) {
+		flushDeferredWrites();
+	}
 	ar.serialize("toneGenerators", tone,
 	             "noiseGenerator", noise,
 	             "envelope",       envelope,
@@ -1009,6 +1047,7 @@ void AY8910::serialize(Archive& ar, unsigned /*version*/)
 
 	// amplitude
 	if constexpr (Archive::IS_LOADER) {
+		soundRegs = regs;
 		for (auto i : xrange(3)) {
 			amplitude.setChannelVolume(i, regs[i + AY_AVOL]);
 		}
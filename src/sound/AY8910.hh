@@ -163,11 +163,16 @@ private:
 	// SoundDevice
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
-	void wrtReg(unsigned reg, uint8_t value, EmuTime::param time);
+	// ResampledSoundDevice
+	void applyDeferredWrite(unsigned reg, uint8_t value) override;
+
+	void wrtReg(unsigned reg, uint8_t value, EmuTime::param time, bool updateSound = true);
+	void wrtSoundReg(unsigned reg, uint8_t value);
 
 private:
 	AY8910Periphery& periphery;
@@ -188,6 +193,8 @@ private:
 	Amplitude amplitude;
 	Envelope envelope;
 	std::array<uint8_t, 16> regs;
+	std::array<uint8_t, 16> soundRegs; // same as 'regs', except for not
+	                                   // yet applied deferred writes
 	const bool isAY8910;
 	const bool ignorePortDirections;
 	bool doDetune;
@@ -14,6 +14,7 @@
 #include "Filename.hh"
 #include "FileOperations.hh"
 #include "MSXCliComm.hh"
+#include "WorkerPool.hh"
 #include "stl.hh"
 #include "aligned.hh"
 #include "enumerate.hh"
@@ -47,6 +48,7 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	, throttleManager(globalSettings.getThrottleManager())
 	, prevTime(getCurrentTime(), 44100)
 	, soundDeviceInfo(commandController.getMachineInfoCommand())
+	, vgmRecorder(motherBoard, *this)
 {
 	hostSampleRate = 44100;
 	fragmentSize = 0;
@@ -117,12 +119,14 @@ void MSXMixer::registerSound(SoundDevice& device, float volume,
 	device.setOutputRate(getSampleRate(), speedManager.getSpeed());
 	auto& i = infos.emplace_back(std::move(info));
 	updateVolumeParams(i);
+	vgmRecorder.deviceAdded(device);
 
 	commandController.getCliComm().update(CliComm::SOUND_DEVICE, device.getName(), "add");
 }
 
 void MSXMixer::unregisterSound(SoundDevice& device)
 {
+	vgmRecorder.deviceRemoved(device);
 	auto it = rfind_unguarded(infos, &device, &SoundDeviceInfo::device);
 	it->volumeSetting->detach(*this);
 	it->balanceSetting->detach(*this);
@@ -471,14 +475,30 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 	std::span tmpBufStereo = tmpBufExtra   .subspan(0, samples); // StereoFloat
 	std::span tmpBufMono   = std::span{tmpBufPtr, samples};      // float
 
+	// Either generate the output of each device right before it's mixed,
+	// or (possibly in parallel) all devices upfront. In the latter case the
+	// output gets copied to the same buffer as it would otherwise be
+	// generated in, so that the mixing below is exactly the same.
+	bool parallel = generateParallel(samples, time);
+	auto updateBuffer = [&](size_t i, float* buffer) {
+		auto& device = *infos[i].device;
+		if (!parallel) {
+			return device.updateBuffer(samples, buffer, time);
+		}
+		if (!deviceHasOutput[i]) return false;
+		auto num = samples * (device.isStereo() ? 2 : 1);
+		ranges::copy(std::span{deviceBuffers[i].data(), num}, buffer);
+		return true;
+	};
+
 	constexpr unsigned HAS_MONO_FLAG = 1;
 	constexpr unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
-		SoundDevice& device = *info.device;
+	for (auto [i, info] : enumerate(infos)) {
+		const SoundDevice& device = *info.device;
 		auto l1 = info.left1;
 		auto r1 = info.right1;
 		if (!device.isStereo()) {
@@ -488,14 +508,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
 					// generate in 'monoBuf' (because it was still empty)
 					// then multiply in-place
-					if (device.updateBuffer(samples, monoBufPtr, time)) {
+					if (updateBuffer(i, monoBufPtr)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, l1);
 					}
 				} else {
 					// generate in 'tmpBuf' (as mono data)
 					// then multiply-accumulate into 'monoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(i, tmpBufPtr)) {
 						mulAcc(monoBuf, tmpBufMono, l1);
 					}
 				}
@@ -504,14 +524,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// 'stereoBuf' (which is still empty) is first filled with mono-data,
 					// then in-place expanded to stereo-data
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (updateBuffer(i, stereoBufPtr)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, l1, r1);
 					}
 				} else {
 					// 'tmpBuf' is first filled with mono-data,
 					// then expanded to stereo and mul-acc into 'stereoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(i, tmpBufPtr)) {
 						mulExpandAcc(stereoBuf, tmpBufMono, l1, r1);
 					}
 				}
@@ -527,14 +547,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// generate in 'stereoBuf' (because it was still empty)
 					// then multiply in-place
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (updateBuffer(i, stereoBufPtr)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, l1);
 					}
 				} else {
 					// generate in 'tmpBuf' (as stereo data)
 					// then multiply-accumulate into 'stereoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(i, tmpBufPtr)) {
 						mulAcc(stereoBuf, tmpBufStereo, l1);
 					}
 				}
@@ -544,14 +564,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// generate in 'stereoBuf' (because it was still empty)
 					// then mix in-place
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (updateBuffer(i, stereoBufPtr)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, l1, l2, r1, r2);
 					}
 				} else {
 					// 'tmpBuf' is first filled with stereo-data,
 					// then mixed into stereoBuf
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(i, tmpBufPtr)) {
 						mulMix2Acc(stereoBuf, tmpBufStereo, l1, l2, r1, r2);
 					}
 				}
@@ -598,6 +618,41 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 	}
 }
 
+bool MSXMixer::generateParallel(size_t samples, EmuTime::param time)
+{
+	// For small fragments (e.g. the synchronous updates triggered by
+	// writes to sound chip registers) waking up the worker threads costs
+	// more than it gains.
+	static constexpr size_t MIN_PARALLEL_SAMPLES = 64;
+
+	auto numThreads = unsigned(mixer.getSoundThreadsSetting().getInt());
+	if ((numThreads <= 1) || (infos.size() <= 1) || (samples < MIN_PARALLEL_SAMPLES)) {
+		return false;
+	}
+	if (!workerPool || (workerPool->getNumWorkers() != (numThreads - 1))) {
+		workerPool.reset(); // first stop the old threads
+		workerPool = std::make_unique<WorkerPool>(numThreads - 1); // +1 for this thread
+	}
+
+	// room for stereo output, +3 see generate()
+	auto size = 2 * (samples + 3);
+	if ((deviceBuffers.size() < infos.size()) || (deviceBufferSize < size)) {
+		deviceBufferSize = std::max(deviceBufferSize, size);
+		deviceBuffers.resize(infos.size());
+		for (auto& buf : deviceBuffers) buf.resize(deviceBufferSize);
+	}
+	deviceHasOutput.resize(infos.size());
+
+	// Sound devices only touch their own state while generating sound
+	// (shared scratch buffers are thread_local), so they can run in
+	// parallel. Any order gives the same result.
+	workerPool->run(infos.size(), [&](size_t i) {
+		deviceHasOutput[i] = infos[i].device->updateBuffer(
+			samples, deviceBuffers[i].data(), time);
+	});
+	return true;
+}
+
 bool MSXMixer::needStereoRecording() const
 {
 	return ranges::any_of(infos, [](auto& info) {
@@ -7,7 +7,11 @@
 #include "Mixer.hh"
 #include "Observer.hh"
 #include "Schedulable.hh"
+#include "VGMRecorder.hh"
+#include "MemBuffer.hh"
+#include "aligned.hh"
 #include "dynarray.hh"
+#include <cstdint>
 #include <memory>
 #include <span>
 #include <vector>
@@ -26,6 +30,7 @@ class StringSetting;
 class BooleanSetting;
 class Setting;
 class AviRecorder;
+class WorkerPool;
 
 class MSXMixer final : private Schedulable, private Observer<Setting>
                      , private Observer<SpeedManager>
@@ -145,6 +150,7 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(std::span<StereoFloat> output, EmuTime::param time);
+	[[nodiscard]] bool generateParallel(size_t samples, EmuTime::param time);
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
@@ -184,9 +190,17 @@ private:
 		void tabCompletion(std::vector<std::string>& tokens) const override;
 	} soundDeviceInfo;
 
+	// See generateParallel()
+	std::unique_ptr<WorkerPool> workerPool;
+	std::vector<MemBuffer<float, SSE_ALIGNMENT>> deviceBuffers;
+	size_t deviceBufferSize = 0; // in floats, for each buffer
+	std::vector<uint8_t> deviceHasOutput; // not vector<bool>, written concurrently
+
 	AviRecorder* recorder = nullptr;
 	unsigned synchronousCounter = 0;
 
+	VGMRecorder vgmRecorder;
+
 	unsigned muteCount;
 	float tl0, tr0; // internal DC-filter state
 };
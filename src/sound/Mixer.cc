@@ -46,6 +46,11 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultSamples, 64, 8192)
+	, soundThreadsSetting(
+		commandController, "sound_threads",
+		"number of threads used to generate the sound of the sound "
+		"chips, 1 means all sound is generated in the emulation thread",
+		1, 1, 16)
 {
 	muteSetting       .attach(*this);
 	frequencySetting  .attach(*this);
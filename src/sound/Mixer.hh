@@ -52,6 +52,7 @@ public:
 
 	[[nodiscard]] IntegerSetting& getMasterVolume() { return masterVolume; }
 	[[nodiscard]] BooleanSetting& getMuteSetting() { return muteSetting; }
+	[[nodiscard]] IntegerSetting& getSoundThreadsSetting() { return soundThreadsSetting; }
 
 private:
 	void reloadDriver();
@@ -72,6 +73,7 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	IntegerSetting soundThreadsSetting;
 
 	int muteCount = 0;
 };
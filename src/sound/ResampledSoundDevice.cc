@@ -7,20 +7,29 @@
 #include "Reactor.hh"
 #include "GlobalSettings.hh"
 #include "EnumSetting.hh"
+#include "BooleanSetting.hh"
+#include "aligned.hh"
+#include "narrow.hh"
+#include "ranges.hh"
 #include "unreachable.hh"
+#include "vla.hh"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
 namespace openmsx {
 
 ResampledSoundDevice::ResampledSoundDevice(
-		MSXMotherBoard& motherBoard, std::string_view name_,
+		MSXMotherBoard& motherBoard_, std::string_view name_,
 		static_string_view description_, unsigned channels,
 		unsigned inputSampleRate_, bool stereo_)
-	: SoundDevice(motherBoard.getMSXMixer(), name_, description_,
+	: SoundDevice(motherBoard_.getMSXMixer(), name_, description_,
 	              channels, inputSampleRate_, stereo_)
+	, motherBoard(motherBoard_)
 	, resampleSetting(motherBoard.getReactor().getGlobalSettings().getResampleSetting())
+	, deferWritesSetting(motherBoard.getReactor().getGlobalSettings().getDeferSoundWritesSetting())
 	, emuClock(EmuTime::zero())
+	, inputClock(EmuTime::zero())
 {
 	resampleSetting.attach(*this);
 }
@@ -44,7 +53,92 @@ bool ResampledSoundDevice::updateBuffer(size_t length, float* buffer,
 
 bool ResampledSoundDevice::generateInput(float* buffer, size_t num)
 {
-	return mixChannels(buffer, num);
+	if (deferredWrites.empty()) [[likely]] {
+		inputClock += narrow<unsigned>(num);
+		return mixChannels(buffer, num);
+	}
+
+	// Generate in pieces, apply the pending writes in between.
+	auto channels = size_t(isStereo() ? 2 : 1);
+	auto ticksTill = [&](EmuTime::param time) -> size_t {
+		return (time <= inputClock.getTime()) ? 0 : inputClock.getTicksTill(time);
+	};
+	bool result = false;
+	size_t done = 0;
+	while (true) {
+		applyDeferredWrites();
+		if (done == num) break;
+		size_t len = num - done;
+		if (!deferredWrites.empty()) {
+			len = std::min(len, ticksTill(deferredWrites.front().time));
+		}
+		assert(len > 0);
+
+		auto out = std::span{buffer + done * channels, len * channels};
+		bool nonZero;
+		if (done == 0) {
+			// can directly use the (aligned) output buffer
+			nonZero = mixChannels(buffer, len);
+		} else {
+			VLA_SSE_ALIGNED(float, tmp, len * channels + 3);
+			nonZero = mixChannels(tmp.data(), len);
+			if (nonZero) ranges::copy(tmp.subspan(0, len * channels), out.data());
+		}
+		if (!nonZero) ranges::fill(out, 0.0f);
+		result |= nonZero;
+		inputClock += narrow<unsigned>(len);
+		done += len;
+	}
+	return result;
+}
+
+bool ResampledSoundDevice::deferWritesEnabled() const
+{
+	return deferWritesSetting.getBoolean();
+}
+
+void ResampledSoundDevice::deferWrite(unsigned reg, uint8_t value, EmuTime::param time)
+{
+	if (deferredWrites.full()) [[unlikely]] {
+		flushDeferredWrites();
+	}
+	deferredWrites.push_back(DeferredWrite{time, reg, value});
+}
+
+void ResampledSoundDevice::flushDeferredWrites()
+{
+	if (deferredWrites.empty()) return;
+	// Generating all sound up to now consumes (most of) the pending
+	// writes, apply the remaining ones immediately.
+	updateStream(motherBoard.getCurrentTime());
+	applyAllDeferredWrites();
+}
+
+void ResampledSoundDevice::applyDeferredWrites()
+{
+	// Apply all writes that happen before the next sample.
+	while (!deferredWrites.empty()) {
+		const auto& w = deferredWrites.front();
+		if ((w.time > inputClock.getTime()) &&
+		    (inputClock.getTicksTill(w.time) > 0)) break;
+		applyDeferredWrite(w.reg, w.value);
+		deferredWrites.pop_front();
+	}
+}
+
+void ResampledSoundDevice::applyAllDeferredWrites()
+{
+	while (!deferredWrites.empty()) {
+		const auto& w = deferredWrites.front();
+		applyDeferredWrite(w.reg, w.value);
+		deferredWrites.pop_front();
+	}
+}
+
+void ResampledSoundDevice::applyDeferredWrite(unsigned /*reg*/, uint8_t /*value*/)
+{
+	// Only called for devices that call deferWrite()
+	UNREACHABLE;
 }
 
 
@@ -62,6 +156,10 @@ void ResampledSoundDevice::createResampler()
 	EmuDuration inputPeriod(getEffectiveSpeed() / double(getInputRate()));
 	emuClock.reset(hostClock.getTime());
 	emuClock.setPeriod(inputPeriod);
+	// the input sample positions change, pending writes can't be mapped
+	// to the new positions
+	applyAllDeferredWrites();
+	inputClock = emuClock;
 
 	if (outputPeriod == inputPeriod) {
 		algo = std::make_unique<ResampleTrivial>(*this);
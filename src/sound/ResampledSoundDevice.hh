@@ -3,12 +3,16 @@
 
 #include "SoundDevice.hh"
 #include "DynamicClock.hh"
+#include "EmuTime.hh"
 #include "EnumSetting.hh"
 #include "Observer.hh"
+#include "circular_buffer.hh"
+#include <cstdint>
 #include <memory>
 
 namespace openmsx {
 
+class BooleanSetting;
 class MSXMotherBoard;
 class ResampleAlgo;
 class Setting;
@@ -42,11 +46,53 @@ protected:
 
 	void createResampler();
 
+	/** Deferred register writes.
+	  * Normally a sound chip calls updateStream() before each register
+	  * write that influences the sound: all sound devices generate
+	  * (and the mixer mixes) the samples up to the time of the write.
+	  * For a burst of writes (e.g. sample playback via the PSG) that
+	  * results in many tiny generateChannels() calls. When the
+	  * 'sound_deferred_writes' setting is enabled, a chip can instead
+	  * log the write with deferWrite(). Later, while generating sound,
+	  * the write is applied via applyDeferredWrite() right before the
+	  * first sample after the time of the write, so the result is the
+	  * same, but generated in a few long calls.
+	  * applyDeferredWrite() can be called from a sound generation thread
+	  * (see MSXMixer::generateParallel()), so it may only change state
+	  * that is private to sound generation.
+	  */
+	[[nodiscard]] bool deferWritesEnabled() const;
+	void deferWrite(unsigned reg, uint8_t value, EmuTime::param time);
+	/** Generate sound up to now and apply all pending writes. Must be
+	  * called before state that is changed by applyDeferredWrite() is
+	  * accessed in another way (e.g. when saving a snapshot).
+	  */
+	void flushDeferredWrites();
+	virtual void applyDeferredWrite(unsigned reg, uint8_t value);
+
 private:
+	void applyDeferredWrites();
+	void applyAllDeferredWrites();
+
+private:
+	MSXMotherBoard& motherBoard;
 	EnumSetting<ResampleType>& resampleSetting;
+	BooleanSetting& deferWritesSetting;
 	std::unique_ptr<ResampleAlgo> algo;
 	DynamicClock emuClock; // time of the last produced emu-sample,
 	                       //    ticks once per emu-sample
+
+	struct DeferredWrite {
+		EmuTime time;
+		unsigned reg;
+		uint8_t value;
+	};
+	static constexpr size_t MAX_DEFERRED_WRITES = 4096;
+	circular_buffer<DeferredWrite> deferredWrites{MAX_DEFERRED_WRITES};
+	// Time of the last sample produced by generateInput(). This is not
+	// always the same as 'emuClock' (some resamplers first advance
+	// 'emuClock' and then call generateInput()).
+	DynamicClock inputClock;
 };
 
 } // namespace openmsx
@@ -98,6 +98,7 @@
 
 #include "SCC.hh"
 #include "DeviceConfig.hh"
+#include "VGMRecorder.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
 #include "outer.hh"
@@ -285,6 +286,7 @@ uint8_t SCC::getFreqVol(unsigned address) const
 void SCC::writeMem(uint8_t address, uint8_t value, EmuTime::param time)
 {
 	updateStream(time);
+	if (vgmRecorder) [[unlikely]] recordVGM(address, value, time);
 
 	switch (currentChipMode) {
 	case SCC_Real:
@@ -341,6 +343,63 @@ float SCC::getAmplificationFactorImpl() const
 	return 1.0f / 128.0f;
 }
 
+VGMChip SCC::getVGMChip() const
+{
+	return VGMChip::SCC;
+}
+
+void SCC::recordVGM(uint8_t address, uint8_t value, EmuTime::param time)
+{
+	// VGM file 'ports' of the SCC:
+	//  0: waveform (SCC),  1: frequency,  2: volume,  3: key on/off,
+	//  4: waveform (SCC+), 5: test (deformation) register
+	auto write = [&](uint8_t port, uint8_t reg) {
+		vgmRecorder->write(VGMChip::SCC, port, reg, value, time);
+	};
+	auto writeFreqVol = [&](uint8_t offset) {
+		offset &= 0x0F; // 0x90..0x9F mirrors 0x80..0x8F
+		if (offset < 0x0A) {
+			write(1, offset);
+		} else if (offset < 0x0F) {
+			write(2, uint8_t(offset - 0x0A));
+		} else {
+			write(3, 0);
+		}
+	};
+
+	switch (currentChipMode) {
+	case SCC_Real:
+		if (address < 0x80) {
+			write(0, address);
+		} else if (address < 0xA0) {
+			writeFreqVol(address);
+		} else if (address >= 0xE0) {
+			write(5, 0);
+		}
+		break;
+	case SCC_Compatible:
+		if (address < 0x80) {
+			write(0, address);
+		} else if (address < 0xA0) {
+			writeFreqVol(address);
+		} else if ((0xC0 <= address) && (address < 0xE0)) {
+			write(5, 0);
+		}
+		break;
+	case SCC_plusmode:
+		if (address < 0xA0) {
+			write(4, address);
+		} else if (address < 0xC0) {
+			writeFreqVol(address);
+		} else if (address < 0xE0) {
+			write(5, 0);
+		}
+		break;
+	default:
+		UNREACHABLE;
+	}
+}
+
 static constexpr float adjust(int8_t wav, uint8_t vol)
 {
 	// The result is an integer value, but we store it as a float because
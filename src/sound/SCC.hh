@@ -34,7 +34,9 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
+	void recordVGM(uint8_t address, uint8_t value, EmuTime::param time);
 	[[nodiscard]] uint8_t readWave(unsigned channel, unsigned address, EmuTime::param time) const;
 	void writeWave(unsigned channel, unsigned address, uint8_t value);
 	void setDeformReg(uint8_t value, EmuTime::param time);
@@ -19,8 +19,9 @@
 
 namespace openmsx {
 
-static MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
-static size_t mixBufferSize = 0;
+// thread_local: MSXMixer may generate the sound of several devices in parallel
+static thread_local MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
+static thread_local size_t mixBufferSize = 0;
 
 static void allocateMixBuffer(size_t size)
 {
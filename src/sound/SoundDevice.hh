@@ -5,6 +5,7 @@
 #include "WavWriter.hh"
 #include "static_string_view.hh"
 #include <array>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -15,6 +16,8 @@ class DeviceConfig;
 class DynamicClock;
 class Filename;
 class MSXMixer;
+class VGMRecorder;
+enum class VGMChip : uint8_t;
 
 class SoundDevice
 {
@@ -76,6 +79,14 @@ public:
 	void recordChannel(unsigned channel, const Filename& filename);
 	void muteChannel  (unsigned channel, bool muted);
 
+	/** The type of this sound chip in a VGM file, VGMChip::NONE (the
+	  * default) when it can't be recorded. See VGMRecorder.
+	  */
+	[[nodiscard]] virtual VGMChip getVGMChip() const { return {}; }
+
+	/** Set by VGMRecorder while this chip is being recorded. */
+	void setVGMRecorder(VGMRecorder* recorder) { vgmRecorder = recorder; }
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -192,6 +203,12 @@ protected:
 	[[nodiscard]] const DynamicClock& getHostSampleClock() const;
 	[[nodiscard]] double getEffectiveSpeed() const;
 
+protected:
+	/** Non-null while this chip is being recorded, then all register
+	  * writes should be passed to VGMRecorder::write().
+	  */
+	VGMRecorder* vgmRecorder = nullptr;
+
 private:
 	MSXMixer& mixer;
 	const std::string name;
@@ -0,0 +1,412 @@
+#include "VGMRecorder.hh"
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "MSXCliComm.hh"
+#include "MSXException.hh"
+#include "MSXMixer.hh"
+#include "MSXMotherBoard.hh"
+#include "SoundDevice.hh"
+#include "StringOp.hh"
+#include "TclObject.hh"
+#include "endian.hh"
+#include "narrow.hh"
+#include "outer.hh"
+#include "ranges.hh"
+#include "unreachable.hh"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace openmsx {
+
+using namespace std::literals;
+
+static constexpr unsigned VGM_SAMPLE_RATE = 44100;
+static constexpr size_t HEADER_SIZE = 0x100;
+
+struct ChipName {
+	std::string_view name;
+	VGMChip chip1;
+	VGMChip chip2;
+};
+static constexpr std::array chipNames = {
+	ChipName{"PSG"sv,       VGMChip::AY8910,    VGMChip::NONE},
+	ChipName{"MSX-Music"sv, VGMChip::YM2413,    VGMChip::NONE},
+	ChipName{"MSX-Audio"sv, VGMChip::Y8950,     VGMChip::NONE},
+	ChipName{"MoonSound"sv, VGMChip::YMF278_FM, VGMChip::YMF278_WAVE},
+	ChipName{"SCC"sv,       VGMChip::SCC,       VGMChip::NONE},
+	ChipName{"SFG"sv,       VGMChip::YM2151,    VGMChip::NONE},
+};
+
+VGMRecorder::VGMRecorder(MSXMotherBoard& motherBoard_, MSXMixer& mixer_)
+	: motherBoard(motherBoard_)
+	, mixer(mixer_)
+	, vgmCommand(motherBoard.getCommandController())
+{
+}
+
+VGMRecorder::~VGMRecorder()
+{
+	if (!isRecording()) return;
+	try {
+		TclObject dummy;
+		stop(dummy);
+	} catch (MSXException& e) {
+		motherBoard.getMSXCliComm().printWarning(
+			"Couldn't finish VGM recording: ", e.getMessage());
+	}
+}
+
+void VGMRecorder::deviceAdded(SoundDevice& device)
+{
+	if (!isRecording()) return;
+	auto chip = device.getVGMChip();
+	auto c = size_t(chip);
+	if ((chip == VGMChip::NONE) || !selected[c] || devices[c]) return;
+	devices[c] = &device;
+	device.setVGMRecorder(this);
+}
+
+void VGMRecorder::deviceRemoved(SoundDevice& device)
+{
+	for (auto& d : devices) {
+		if (d == &device) {
+			device.setVGMRecorder(nullptr);
+			d = nullptr;
+		}
+	}
+}
+
+void VGMRecorder::detachDevices()
+{
+	for (auto& d : devices) {
+		if (d) d->setVGMRecorder(nullptr);
+		d = nullptr;
+	}
+}
+
+void VGMRecorder::start(std::string filename_, std::span<const TclObject> names, TclObject& result)
+{
+	if (isRecording()) {
+		throw CommandException("Already recording.");
+	}
+	selected = {};
+	for (const auto& n : names) {
+		auto name = n.getString();
+		auto it = ranges::find_if(chipNames, [&](const auto& c) {
+			return StringOp::casecmp()(c.name, name);
+		});
+		if (it == chipNames.end()) {
+			throw CommandException("Unknown sound chip: ", name);
+		}
+		selected[size_t(it->chip1)] = true;
+		selected[size_t(it->chip2)] = true;
+	}
+	selected[size_t(VGMChip::NONE)] = false;
+
+	file = File(filename_, File::TRUNCATE);
+	filename = std::move(filename_);
+	started = false;
+	sccPlusUsed = false;
+	samples = 0;
+	totalSize = 0;
+	buffer.clear();
+	buffer.reserve(BUFFER_SIZE + 64);
+	// placeholder for the header, it's written when recording stops
+	buffer.resize(HEADER_SIZE);
+
+	writeQueue.clear();
+	writeError.clear();
+	exitWriter = false;
+	writeThread = std::thread([this]() { writeLoop(); });
+
+	for (const auto& info : mixer.getDeviceInfos()) {
+		deviceAdded(*info.device);
+	}
+	for (const auto* d : devices) {
+		if (d) result.addListElement(d->getName());
+	}
+}
+
+void VGMRecorder::stop(TclObject& result)
+{
+	if (!isRecording()) {
+		throw CommandException("Not recording.");
+	}
+	detachDevices();
+	if (started) updateTime(motherBoard.getCurrentTime());
+	append({0x66}); // end of sound data
+	stopWriter();
+
+	std::string error = std::exchange(writeError, {});
+	if (error.empty()) {
+		try {
+			writeHeader();
+		} catch (MSXException& e) {
+			error = e.getMessage();
+		}
+	}
+	file.close();
+	if (!error.empty()) {
+		throw CommandException("Error while writing ", filename, ": ", error);
+	}
+	result = filename;
+}
+
+void VGMRecorder::abort()
+{
+	if (!isRecording()) {
+		throw CommandException("Not recording.");
+	}
+	detachDevices();
+	stopWriter();
+	writeError.clear();
+	file.close();
+	FileOperations::unlink(filename);
+}
+
+void VGMRecorder::insert(std::span<const uint8_t> data)
+{
+	if (!isRecording()) {
+		throw CommandException("Not recording.");
+	}
+	buffer.insert(buffer.end(), data.begin(), data.end());
+	totalSize += data.size();
+	if (buffer.size() >= BUFFER_SIZE) queueBuffer();
+}
+
+void VGMRecorder::status(TclObject& result) const
+{
+	result.addDictKeyValues("recording", isRecording());
+	if (!isRecording()) return;
+	result.addDictKeyValues("filename", filename,
+	                        "size", narrow<int>(HEADER_SIZE + totalSize));
+	if (started) {
+		result.addDictKeyValues("start_time", (startTime - EmuTime::zero()).toDouble(),
+		                        "last_write_time", (lastTime - EmuTime::zero()).toDouble());
+	}
+	TclObject chips;
+	for (const auto* d : devices) {
+		if (d) chips.addListElement(d->getName());
+	}
+	result.addDictKeyValue("devices", chips);
+}
+
+void VGMRecorder::write(VGMChip chip, uint8_t reg, uint8_t value, EmuTime::param time)
+{
+	static constexpr std::array<uint8_t, NUM_CHIPS> commands = {
+		0x00, // NONE
+		0xA0, // AY8910
+		0x51, // YM2413
+		0x54, // YM2151
+		0x5C, // Y8950
+	};
+	assert(commands[size_t(chip)] != 0);
+	updateTime(time);
+	append({commands[size_t(chip)], reg, value});
+}
+
+void VGMRecorder::write(VGMChip chip, uint8_t port, uint8_t reg, uint8_t value, EmuTime::param time)
+{
+	uint8_t command = [&] {
+		switch (chip) {
+		case VGMChip::YMF278_FM:
+		case VGMChip::YMF278_WAVE:
+			return uint8_t(0xD0);
+		case VGMChip::SCC:
+			if (port == 4) sccPlusUsed = true; // SCC+ waveform
+			return uint8_t(0xD2);
+		default:
+			UNREACHABLE;
+		}
+	}();
+	updateTime(time);
+	append({command, port, reg, value});
+}
+
+void VGMRecorder::updateTime(EmuTime::param time_)
+{
+	if (!started) {
+		started = true;
+		startTime = time_;
+		lastTime = time_;
+		motherBoard.getMSXCliComm().printInfo(
+			"VGM recording started, data was written to one of the "
+			"recorded sound chips.");
+	}
+	// should not happen, but don't let the time go backwards
+	auto time = std::max(time_, lastTime);
+	lastTime = time;
+
+	auto newSamples = (time - startTime).length() * VGM_SAMPLE_RATE / MAIN_FREQ;
+	while (samples < newSamples) {
+		auto n = newSamples - samples;
+		if (n <= 16) {
+			append({uint8_t(0x70 + n - 1)});
+		} else if (n == 735) {
+			append({0x62}); // 1/60s
+		} else if (n == 882) {
+			append({0x63}); // 1/50s
+		} else {
+			n = std::min<uint64_t>(n, 0xFFFF);
+			append({0x61, uint8_t(n & 0xFF), uint8_t(n >> 8)});
+		}
+		samples += n;
+	}
+}
+
+void VGMRecorder::append(std::initializer_list<uint8_t> bytes)
+{
+	buffer.insert(buffer.end(), bytes);
+	totalSize += bytes.size();
+	if (buffer.size() >= BUFFER_SIZE) [[unlikely]] queueBuffer();
+}
+
+void VGMRecorder::queueBuffer()
+{
+	std::vector<uint8_t> next;
+	{
+		std::scoped_lock lock(writeMutex);
+		writeQueue.push_back(std::move(buffer));
+		if (!freeBuffers.empty()) {
+			next = std::move(freeBuffers.back());
+			freeBuffers.pop_back();
+		}
+	}
+	writeCond.notify_one();
+	next.clear();
+	next.reserve(BUFFER_SIZE + 64);
+	buffer = std::move(next);
+}
+
+void VGMRecorder::stopWriter()
+{
+	if (!buffer.empty()) queueBuffer();
+	{
+		std::scoped_lock lock(writeMutex);
+		exitWriter = true;
+	}
+	writeCond.notify_one();
+	writeThread.join();
+	writeQueue.clear();
+	freeBuffers.clear();
+	buffer.clear();
+}
+
+void VGMRecorder::writeLoop()
+{
+	std::unique_lock lock(writeMutex);
+	while (true) {
+		writeCond.wait(lock, [&] { return exitWriter || !writeQueue.empty(); });
+		// On exit, first write the buffers that are still queued.
+		if (writeQueue.empty()) return;
+
+		auto data = std::move(writeQueue.front());
+		writeQueue.pop_front();
+		if (writeError.empty()) {
+			lock.unlock();
+			std::string error;
+			try {
+				file.write(data);
+			} catch (MSXException& e) {
+				error = e.getMessage();
+			}
+			lock.lock();
+			if (!error.empty()) writeError = std::move(error);
+		}
+		freeBuffers.push_back(std::move(data));
+	}
+}
+
+void VGMRecorder::writeHeader()
+{
+	// See https://vgmrips.net/wiki/VGM_Specification for the layout.
+	std::array<uint8_t, HEADER_SIZE> header = {};
+	auto set32 = [&](size_t offset, uint32_t value) {
+		Endian::write_UA_L32(&header[offset], value);
+	};
+	auto clock = [&](size_t offset, VGMChip chip, uint32_t freq) {
+		if (selected[size_t(chip)]) set32(offset, freq);
+	};
+	ranges::copy("Vgm "sv, header.begin());
+	set32(0x04, narrow<uint32_t>(HEADER_SIZE + totalSize - 4)); // EOF offset
+	set32(0x08, 0x161); // version 1.61
+	clock(0x10, VGMChip::YM2413, 3579545);
+	set32(0x18, narrow<uint32_t>(samples));
+	clock(0x30, VGMChip::YM2151, 3579545);
+	set32(0x34, HEADER_SIZE - 0x34); // offset of the VGM data
+	clock(0x58, VGMChip::Y8950, 3579545);
+	clock(0x60, VGMChip::YMF278_FM, 33868800);
+	clock(0x74, VGMChip::AY8910, 1789773);
+	// bit 31 indicates SCC+ (instead of SCC)
+	clock(0x9C, VGMChip::SCC, 1789773 | (sccPlusUsed ? 0x8000'0000 : 0));
+
+	file.seek(0);
+	file.write(header);
+}
+
+
+// class VGMRecorder::Cmd
+
+VGMRecorder::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "vgm_recorder")
+{
+}
+
+void VGMRecorder::Cmd::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() < 2) {
+		throw CommandException("Missing argument");
+	}
+	auto& recorder = OUTER(VGMRecorder, vgmCommand);
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, AtLeast{4}, "filename chip ?chip ...?");
+			recorder.start(std::string(tokens[2].getString()), tokens.subspan(3), result); },
+		"stop", [&]{
+			checkNumArgs(tokens, 2, "");
+			recorder.stop(result); },
+		"abort", [&]{
+			checkNumArgs(tokens, 2, "");
+			recorder.abort(); },
+		"insert", [&]{
+			checkNumArgs(tokens, 3, "data");
+			recorder.insert(tokens[2].getBinary()); },
+		"status", [&]{
+			checkNumArgs(tokens, 2, "");
+			recorder.status(result); });
+}
+
+std::string VGMRecorder::Cmd::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Record the register writes to the sound chips in a VGM file. This is "
+	       "the low level command used by the 'vgm_rec' script.\n"
+	       "vgm_recorder start <filename> <chip> ...  Start recording the given "
+	       "chips: PSG, MSX-Music, MSX-Audio, MoonSound, SCC and/or SFG\n"
+	       "vgm_recorder stop           Stop recording and write the file\n"
+	       "vgm_recorder abort          Stop recording and remove the file\n"
+	       "vgm_recorder insert <data>  Insert raw VGM data (e.g. a data block)\n"
+	       "vgm_recorder status         Query the recording state\n";
+}
+
+void VGMRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr std::array cmds = {
+			"start"sv, "stop"sv, "abort"sv, "insert"sv, "status"sv,
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() == 3) && (tokens[1] == "start")) {
+		completeFileName(tokens, userFileContext());
+	} else if ((tokens.size() >= 4) && (tokens[1] == "start")) {
+		static constexpr auto names = [] {
+			std::array<std::string_view, chipNames.size()> result;
+			for (size_t i = 0; i < chipNames.size(); ++i) result[i] = chipNames[i].name;
+			return result;
+		}();
+		completeString(tokens, names, false); // case insensitive
+	}
+}
+
+} // namespace openmsx
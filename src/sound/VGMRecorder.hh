@@ -0,0 +1,111 @@
+#ifndef VGMRECORDER_HH
+#define VGMRECORDER_HH
+
+#include "Command.hh"
+#include "EmuTime.hh"
+#include "File.hh"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+class MSXMixer;
+class MSXMotherBoard;
+class SoundDevice;
+class TclObject;
+
+/** The sound chips that can be recorded in a VGM file. The MoonSound consists
+  * of two sound devices, in a VGM file both are a single YMF278B chip.
+  */
+enum class VGMChip : uint8_t {
+	NONE, AY8910, YM2413, YM2151, Y8950, YMF278_FM, YMF278_WAVE, SCC,
+	NUM
+};
+
+/** Records the register writes to the sound chips in a VGM file.
+  *
+  * While recording, the selected sound chips call write() for each register
+  * write. That only appends a few bytes to a buffer, full buffers are written
+  * to the file by a background thread. So recording has (almost) no influence
+  * on the emulation speed.
+  *
+  * Per chip type only the first sound device of that type is recorded.
+  */
+class VGMRecorder
+{
+public:
+	VGMRecorder(MSXMotherBoard& motherBoard, MSXMixer& mixer);
+	~VGMRecorder();
+
+	// Called by MSXMixer
+	void deviceAdded(SoundDevice& device);
+	void deviceRemoved(SoundDevice& device);
+
+	// Called by the recorded sound chips
+	void write(VGMChip chip, uint8_t reg, uint8_t value, EmuTime::param time);
+	void write(VGMChip chip, uint8_t port, uint8_t reg, uint8_t value, EmuTime::param time);
+
+private:
+	void start(std::string filename, std::span<const TclObject> chipNames, TclObject& result);
+	void stop(TclObject& result);
+	void abort();
+	void insert(std::span<const uint8_t> data);
+	void status(TclObject& result) const;
+
+	[[nodiscard]] bool isRecording() const { return file.is_open(); }
+	void detachDevices();
+	void updateTime(EmuTime::param time);
+	void append(std::initializer_list<uint8_t> bytes);
+	void queueBuffer();
+	void stopWriter();
+	void writeLoop();
+	void writeHeader();
+
+private:
+	MSXMotherBoard& motherBoard;
+	MSXMixer& mixer;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(std::span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} vgmCommand;
+
+	static constexpr auto NUM_CHIPS = size_t(VGMChip::NUM);
+	std::array<bool, NUM_CHIPS> selected = {};
+	std::array<SoundDevice*, NUM_CHIPS> devices = {};
+
+	File file; // only accessed by the writer thread while it's running
+	std::string filename;
+	EmuTime startTime = EmuTime::zero(); // time of the first write
+	EmuTime lastTime = EmuTime::zero(); // time of the most recent write
+	uint64_t samples = 0; // number of (44100Hz) samples written so far
+	size_t totalSize = 0; // size of the VGM data (without header)
+	bool started = false; // was there already a write?
+	bool sccPlusUsed = false;
+
+	// The data of the VGM file is appended to 'buffer'. When it's big
+	// enough, it's handed over to the writer thread.
+	static constexpr size_t BUFFER_SIZE = 32 * 1024;
+	std::vector<uint8_t> buffer;
+	std::mutex writeMutex; // protects the members below
+	std::condition_variable writeCond;
+	std::deque<std::vector<uint8_t>> writeQueue;
+	std::vector<std::vector<uint8_t>> freeBuffers;
+	std::string writeError;
+	bool exitWriter = false;
+	std::thread writeThread;
+};
+
+} // namespace openmsx
+
+#endif
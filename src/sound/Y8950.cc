@@ -6,9 +6,11 @@
 
 #include "Y8950.hh"
 #include "Y8950Periphery.hh"
+#include "LFSRJump.hh"
 #include "MSXAudio.hh"
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
+#include "VGMRecorder.hh"
 #include "Math.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
@@ -777,6 +779,11 @@ float Y8950::getAmplificationFactorImpl() const
 	return 1.0f / (1 << DB2LIN_AMP_BITS);
 }
 
+VGMChip Y8950::getVGMChip() const
+{
+	return VGMChip::Y8950;
+}
+
 void Y8950::setEnabled(bool enabled_, EmuTime::param time)
 {
 	updateStream(time);
@@ -806,14 +813,52 @@ bool Y8950::checkMuteHelper()
 	return adpcm.isMuted();
 }
 
+// Update pm_phase, am_phase, noiseA_phase, noiseB_phase and noise_seed like
+// the loop in generateChannels() does, but without generating sound. The
+// operators themselves don't need updating while muted. This takes
+// O(log(num)) time instead of O(num).
+void Y8950::advanceMuted(unsigned num)
+{
+	am_phase = (am_phase + num) % (LFO_AM_TAB_ELEMENTS * 64);
+	pm_phase = (pm_phase + num * PM_DPHASE) & (PM_DP_WIDTH - 1); // power of 2
+	noiseB_phase = (noiseB_phase + num * noiseB_dPhase) & ((0x10 << 11) - 1);
+
+	static constexpr LFSRJump noiseJump([](uint32_t x) {
+		if (x & 1) x ^= 0x24000;
+		return x >> 1;
+	});
+	noise_seed = int(noiseJump.advance(uint32_t(noise_seed), num));
+
+	// noiseA_phase counts up by noiseA_dPhase (modulo M) and restarts at 0
+	// when it reaches the range [END, M).
+	static constexpr unsigned M = 0x40 << 11;
+	static constexpr unsigned END = 0x3f << 11;
+	if ((num != 0) && (noiseA_phase >= END)) {
+		// can only happen after loading a state, take one regular step
+		noiseA_phase = (noiseA_phase + noiseA_dPhase) & (M - 1);
+		if (noiseA_phase >= END) noiseA_phase = 0;
+		--num;
+	}
+	unsigned d = noiseA_dPhase;
+	assert(d < M);
+	// number of steps from 'p' (< END) till the restart
+	auto stepsTillRestart = [&](unsigned p) {
+		return Math::firstMultipleInRange(d, M, END - p, M - 1 - p);
+	};
+	if (auto s = stepsTillRestart(noiseA_phase); s && (num >= *s)) {
+		num -= unsigned(*s);
+		if (auto period = stepsTillRestart(0)) num = unsigned(num % *period);
+		noiseA_phase = 0;
+	}
+	noiseA_phase = unsigned((noiseA_phase + uint64_t(num) * d) & (M - 1));
+}
+
 void Y8950::generateChannels(std::span<float*> bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
 	if (checkMuteHelper()) {
-		// TODO update internal state even when muted
-		// during mute pm_phase, am_phase, noiseA_phase, noiseB_phase
-		// and noise_seed aren't updated, probably ok
 		ranges::fill(bufs, nullptr);
+		advanceMuted(num);
 		return;
 	}
 
@@ -915,6 +960,9 @@ void Y8950::writeReg(uint8_t rg, uint8_t data, EmuTime::param time)
 		// update the output buffer before changing the register
 		updateStream(time);
 	//}
+	if (vgmRecorder) [[unlikely]] {
+		vgmRecorder->write(VGMChip::Y8950, rg, data, time);
+	}
 
 	switch (rg & 0xe0) {
 	case 0x00: {
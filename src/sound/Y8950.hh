@@ -78,6 +78,7 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
@@ -93,6 +94,7 @@ private:
 	void update_key_status();
 
 	[[nodiscard]] bool checkMuteHelper();
+	void advanceMuted(unsigned num);
 
 	void changeStatusMask(uint8_t newMask);
 
@@ -6,7 +6,9 @@
 
 #include "YM2151.hh"
 #include "DeviceConfig.hh"
+#include "LFSRJump.hh"
 #include "Math.hh"
+#include "VGMRecorder.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
 #include "narrow.hh"
@@ -648,6 +650,9 @@ void YM2151::refreshEG(std::span<YM2151Operator, 4> op)
 void YM2151::writeReg(uint8_t r, uint8_t v, EmuTime::param time)
 {
 	updateStream(time);
+	if (vgmRecorder) [[unlikely]] {
+		vgmRecorder->write(VGMChip::YM2151, r, v, time);
+	}
 
 	YM2151Operator& op = oper[(r & 0x07) * 4 + ((r & 0x18) >> 3)];
 
@@ -918,7 +923,9 @@ YM2151::~YM2151()
 
 bool YM2151::checkMuteHelper()
 {
-	return ranges::all_of(oper, [](auto& op) { return op.state == EG_OFF; });
+	// A pending CSM key-on is only handled in advance()
+	return (csm_req == 0) &&
+	       ranges::all_of(oper, [](auto& op) { return op.state == EG_OFF; });
 }
 
 void YM2151::reset(EmuTime::param time)
@@ -1351,9 +1358,8 @@ void YM2151::advanceEG()
 	}
 }
 
-void YM2151::advance()
+void YM2151::advanceLFO()
 {
-	// LFO
 	if (test & 2) {
 		lfo_phase = 0;
 	} else {
@@ -1365,6 +1371,76 @@ void YM2151::advance()
 			lfo_counter &= 15;
 		}
 	}
+}
+
+void YM2151::advanceNoise()
+{
+	// The Noise Generator of the YM2151 is 17-bit shift register.
+	// Input to the bit16 is negated (bit0 XOR bit3) (XNOR).
+	// Output of the register is negated (bit0 XOR bit3).
+	// Simply use bit16 as the noise output.
+
+	// noise changes depending on the index in noise_tab (noise_f = noise_tab[x])
+	// noise_tab contains how many cycles/samples (x2) the noise should change.
+	// so, when it contains 29, noise should change every 14.5 cycles (2 out of 29).
+	// if you read this code well, you'll see that is what happens here :)
+	noise_p -= 2;
+	if (noise_p < 0) {
+		noise_p += noise_f;
+		unsigned j = ((noise_rng ^ (noise_rng >> 3)) & 1) ^ 1;
+		noise_rng = (j << 16) | (noise_rng >> 1);
+	}
+}
+
+// Like calling advanceEG() and advance() 'num' times, but only for the global
+// state. Only valid while all operators are off (see checkMuteHelper()): the
+// envelope generators don't change and the phase is reset on key-on. This
+// takes O(log(num)) time instead of O(num).
+void YM2151::advanceMuted(unsigned num)
+{
+	// see advanceEG(): eg_cnt increments every 4th sample
+	unsigned t = eg_timer + num;
+	eg_cnt += t / 4;
+	eg_timer = t % 4;
+
+	// see advanceLFO(): the counter is updated every (lfo_overflow + 1)
+	// samples, the first time after 'untilUpdate' samples
+	if (test & 2) {
+		lfo_phase = 0;
+	} else {
+		unsigned untilUpdate = (lfo_timer >= lfo_overflow) ? 1 : (lfo_overflow - lfo_timer + 1);
+		if (num < untilUpdate) {
+			lfo_timer += num;
+		} else {
+			unsigned rest = num - untilUpdate;
+			uint64_t updates = 1 + rest / (lfo_overflow + 1);
+			lfo_timer = rest % (lfo_overflow + 1);
+			uint64_t counter = lfo_counter + updates * lfo_counter_add;
+			lfo_phase = unsigned((lfo_phase + (counter >> 4)) & 255);
+			lfo_counter = unsigned(counter & 15);
+		}
+	}
+
+	// see advanceNoise(): noise_f >= 2, so noise_p wraps at most once per
+	// sample, and once it wrapped it stays in the range [0, noise_f)
+	assert(noise_f >= 2);
+	int64_t p = int64_t(noise_p) - 2 * int64_t(num);
+	int64_t steps = (p >= 0) ? 0 : ((-p + noise_f - 1) / noise_f);
+	noise_p = narrow<int>(p + steps * noise_f);
+	// The feedback is XNOR instead of XOR. That's an affine instead of a
+	// linear map, so add an extra state bit (bit 17) that's always 1.
+	static constexpr LFSRJump noiseJump([](uint32_t x) {
+		uint32_t one = (x >> 17) & 1;
+		x &= 0x1ffff;
+		uint32_t j = ((x ^ (x >> 3)) & 1) ^ one;
+		return (one << 17) | (j << 16) | (x >> 1);
+	});
+	noise_rng = noiseJump.advance((noise_rng & 0x1ffff) | (1 << 17), narrow<uint32_t>(steps)) & 0x1ffff;
+}
+
+void YM2151::advance()
+{
+	advanceLFO();
 
 	unsigned i = lfo_phase;
 	// calculate LFO AM and PM waveform value (all verified on real chip,
@@ -1423,21 +1499,7 @@ void YM2151::advance()
 	lfa = a * amd / 128;
 	lfp = p * pmd / 128;
 
-	// The Noise Generator of the YM2151 is 17-bit shift register.
-	// Input to the bit16 is negated (bit0 XOR bit3) (XNOR).
-	// Output of the register is negated (bit0 XOR bit3).
-	// Simply use bit16 as the noise output.
-
-	// noise changes depending on the index in noise_tab (noise_f = noise_tab[x])
-	// noise_tab contains how many cycles/samples (x2) the noise should change.
-	// so, when it contains 29, noise should change every 14.5 cycles (2 out of 29).
-	// if you read this code well, you'll see that is what happens here :)
-	noise_p -= 2;
-	if (noise_p < 0) {
-		noise_p += noise_f;
-		unsigned j = ((noise_rng ^ (noise_rng >> 3)) & 1) ^ 1;
-		noise_rng = (j << 16) | (noise_rng >> 1);
-	}
+	advanceNoise();
 
 	// phase generator
 	for (auto c : xrange(8)) {
@@ -1496,8 +1558,8 @@ void YM2151::advance()
 void YM2151::generateChannels(std::span<float*> bufs, unsigned num)
 {
 	if (checkMuteHelper()) {
-		// TODO update internal state, even if muted
 		ranges::fill(bufs, nullptr);
+		advanceMuted(num);
 		return;
 	}
 
@@ -1519,6 +1581,11 @@ void YM2151::generateChannels(std::span<float*> bufs, unsigned num)
 	}
 }
 
+VGMChip YM2151::getVGMChip() const
+{
+	return VGMChip::YM2151;
+}
+
 void YM2151::callback(uint8_t flag)
 {
 	assert(flag == one_of(1, 2));
@@ -127,6 +127,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
 	void callback(uint8_t flag) override;
 	void setStatus(uint8_t flags);
@@ -146,7 +147,10 @@ private:
 	void chan7Calc();
 
 	void advanceEG();
+	void advanceLFO();
+	void advanceNoise();
 	void advance();
+	void advanceMuted(unsigned num);
 
 	[[nodiscard]] bool checkMuteHelper();
 
@@ -5,6 +5,7 @@
 #include "YM2413OriginalNukeYKT.hh"
 #include "DeviceConfig.hh"
 #include "MSXException.hh"
+#include "VGMRecorder.hh"
 #include "serialize.hh"
 #include "cstd.hh"
 #include "narrow.hh"
@@ -94,6 +95,14 @@ void YM2413::writePort(bool port, byte value, EmuTime::param time)
 	assert(offset < 18);
 
 	core->writePort(port, value, offset);
+
+	if (vgmRecorder) [[unlikely]] {
+		if (port == 0) {
+			vgmRegLatch = value;
+		} else {
+			vgmRecorder->write(VGMChip::YM2413, vgmRegLatch, value, time);
+		}
+	}
 }
 
 void YM2413::pokeReg(byte reg, byte value, EmuTime::param time)
@@ -119,6 +128,11 @@ float YM2413::getAmplificationFactorImpl() const
 	return core->getAmplificationFactor();
 }
 
+VGMChip YM2413::getVGMChip() const
+{
+	return VGMChip::YM2413;
+}
+
 
 template<typename Archive>
 void YM2413::serialize(Archive& ar, unsigned /*version*/)
@@ -30,9 +30,11 @@ private:
 	void setOutputRate(unsigned hostSampleRate, double speed) override;
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
 private:
 	const std::unique_ptr<YM2413Core> core;
+	byte vgmRegLatch = 0; // only used for VGM recording
 
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
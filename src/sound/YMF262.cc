@@ -39,8 +39,10 @@
 
 #include "YMF262.hh"
 #include "DeviceConfig.hh"
+#include "LFSRJump.hh"
 #include "MSXMotherBoard.hh"
 #include "Math.hh"
+#include "VGMRecorder.hh"
 #include "cstd.hh"
 #include "narrow.hh"
 #include "outer.hh"
@@ -479,12 +481,6 @@ static constexpr SinTab getSinTab()
 static constexpr SinTab sin = getSinTab();
 
 
-// TODO clean this up
-static int phase_modulation;  // phase modulation input (SLOT 2)
-static int phase_modulation2; // phase modulation input (SLOT 3
-                              // in 4 operator channels)
-
-
 YMF262::Slot::Slot()
 	: waveTable(sin.tab[0])
 {
@@ -646,6 +642,27 @@ void YMF262::advance()
 	noise_rng >>= 1;
 }
 
+// Like calling advance() 'num' times (plus the LFO AM update in
+// generateChannels()), but only for the global state. Only valid while all
+// operators are muted (see checkMuteHelper()): the per-operator phase is reset
+// on key-on and the envelopes are (close to) silent anyway. This takes
+// O(log(num)) time instead of O(num).
+void YMF262::advanceMuted(unsigned num)
+{
+	auto amPeriod = unsigned(LFOAMIndex(LFO_AM_TAB_ELEMENTS).getRawValue());
+	lfo_am_cnt = LFOAMIndex::create(
+		int((unsigned(lfo_am_cnt.getRawValue()) + num) % amPeriod));
+	lfo_pm_cnt = LFOPMIndex::create(
+		int(unsigned(lfo_pm_cnt.getRawValue()) + num));
+	eg_cnt += num;
+
+	static constexpr LFSRJump noiseJump([](uint32_t x) { // see advance()
+		if (x & 1) x ^= 0x800302;
+		return x >> 1;
+	});
+	noise_rng = noiseJump.advance(noise_rng, num);
+}
+
 inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
 {
 	unsigned env = (TLL + volume + (lfo_am & AMmask)) << 4;
@@ -655,7 +672,7 @@ inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
 
 // calculate output of a standard 2 operator channel
 // (or 1st part of a 4-op channel)
-void YMF262::Channel::chan_calc(unsigned lfo_am)
+void YMF262::Channel::chan_calc(unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! something is wrong with this, it caused bug
 	// !!    [2823673] MoonSound 4 operator FM fail
@@ -694,7 +711,7 @@ void YMF262::Channel::chan_calc(unsigned lfo_am)
 }
 
 // calculate output of a 2nd part of 4-op channel
-void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
+void YMF262::Channel::chan_calc_ext(unsigned lfo_am, int& phase_modulation, const int& phase_modulation2)
 {
 	// !! see remark in chan_cal(), something is wrong with this
 	// !! optimization disabled for now
@@ -1039,6 +1056,10 @@ void YMF262::writeReg(unsigned r, uint8_t v, EmuTime::param time)
 void YMF262::writeReg512(unsigned r, uint8_t v, EmuTime::param time)
 {
 	updateStream(time); // TODO optimize only for regs that directly influence sound
+	if (vgmRecorder) [[unlikely]] {
+		// only recorded as the FM part of a YMF278 (see getVGMChip())
+		vgmRecorder->write(VGMChip::YMF278_FM, uint8_t(r >> 8), uint8_t(r & 0xFF), v, time);
+	}
 	writeRegDirect(r, v, time);
 }
 void YMF262::writeRegDirect(unsigned r, uint8_t v, EmuTime::param time)
@@ -1513,13 +1534,38 @@ float YMF262::getAmplificationFactorImpl() const
 	return 1.0f / 4096.0f;
 }
 
+VGMChip YMF262::getVGMChip() const
+{
+	return isYMF278 ? VGMChip::YMF278_FM : VGMChip::NONE;
+}
+
+// What about a SIMD operator core (all operators of a sample in SoA layout)?
+//
+// This was considered, but it doesn't fit this chip well:
+// - Most of the work can't be done in parallel. Within a channel the
+//   modulator output is the phase modulation of the carrier, in 4-op mode two
+//   channels form one chain, the feedback uses the previous outputs of the
+//   modulator, and in rhythm mode operators share the noise and phase bits.
+//   So per sample only the (at most 18) independent chains could be done in
+//   parallel, each chain stays a sequence of dependent steps.
+// - Each operator does (at least) two table lookups (waveTable and tlTab).
+//   SSE2 has no gather, so those stay scalar loads, and AVX2 gathers aren't
+//   much faster. Envelope stepping (advance()) is a per-operator state
+//   machine full of branches.
+// - openMSX selects SIMD code at compile time (#ifdef __SSE2__ etc), there's
+//   no infrastructure for run-time CPU feature detection.
+// - Exactness matters (people compare with recordings of real chips), but
+//   the unittests can't instantiate sound devices, so there's no easy way
+//   to compare the output for a register trace with the scalar code.
+// The idle case is already cheap: while all operators are silent
+// advanceMuted() only updates the global state.
 void YMF262::generateChannels(std::span<float*> bufs, unsigned num)
 {
 	// TODO implement per-channel mute (instead of all-or-nothing)
 	// TODO output rhythm on separate channels?
 	if (checkMuteHelper()) {
-		// TODO update internal state, even if muted
 		ranges::fill(bufs, nullptr);
+		advanceMuted(num);
 		return;
 	}
 
@@ -1547,31 +1593,31 @@ void YMF262::generateChannels(std::span<float*> bufs, unsigned num)
 				auto& ch0 = channel[k + i + 0];
 				auto& ch3 = channel[k + i + 3];
 				// extended 4op ch#0 part 1 or 2op ch#0
-				ch0.chan_calc(lfo_am);
+				ch0.chan_calc(lfo_am, phase_modulation, phase_modulation2);
 				if (ch0.extended) {
 					// extended 4op ch#0 part 2
-					ch3.chan_calc_ext(lfo_am);
+					ch3.chan_calc_ext(lfo_am, phase_modulation, phase_modulation2);
 				} else {
 					// standard 2op ch#3
-					ch3.chan_calc(lfo_am);
+					ch3.chan_calc(lfo_am, phase_modulation, phase_modulation2);
 				}
 			}
 		}
 
 		// channels 6,7,8 rhythm or 2op mode
 		if (!rhythmEnabled) {
-			channel[6].chan_calc(lfo_am);
-			channel[7].chan_calc(lfo_am);
-			channel[8].chan_calc(lfo_am);
+			channel[6].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+			channel[7].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+			channel[8].chan_calc(lfo_am, phase_modulation, phase_modulation2);
 		} else {
 			// Rhythm part
 			chan_calc_rhythm(lfo_am);
 		}
 
 		// channels 15,16,17 are fixed 2-operator channels only
-		channel[15].chan_calc(lfo_am);
-		channel[16].chan_calc(lfo_am);
-		channel[17].chan_calc(lfo_am);
+		channel[15].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		channel[16].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		channel[17].chan_calc(lfo_am, phase_modulation, phase_modulation2);
 
 		for (auto i : xrange(18)) {
 			bufs[i][2 * j + 0] += narrow_cast<float>(chanOut[i] & pan[4 * i + 0]);
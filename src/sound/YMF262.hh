@@ -122,8 +122,8 @@ private:
 
 	class Channel {
 	public:
-		void chan_calc(unsigned lfo_am);
-		void chan_calc_ext(unsigned lfo_am);
+		void chan_calc(unsigned lfo_am, int& phase_modulation, int& phase_modulation2);
+		void chan_calc_ext(unsigned lfo_am, int& phase_modulation, const int& phase_modulation2);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -151,6 +151,7 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
 	void callback(uint8_t flag) override;
 
@@ -160,6 +161,7 @@ private:
 	void resetStatus(uint8_t flag);
 	void changeStatusMask(uint8_t flag);
 	void advance();
+	void advanceMuted(unsigned num);
 
 	[[nodiscard]] inline unsigned genPhaseHighHat();
 	[[nodiscard]] inline unsigned genPhaseSnare();
@@ -199,6 +201,9 @@ private:
 	IRQHelper irq;
 
 	std::array<int, 18> chanOut = {};      // 18 channels
+	int phase_modulation  = 0; // phase modulation input (SLOT 2)
+	int phase_modulation2 = 0; // phase modulation input (SLOT 3
+	                           // in 4 operator channels)
 
 	std::array<uint8_t, 512> reg = {};
 	std::array<Channel, 18> channel;  // OPL3 chips have 18 channels
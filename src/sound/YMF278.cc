@@ -33,6 +33,7 @@
 #include "DeviceConfig.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXException.hh"
+#include "VGMRecorder.hh"
 #include "enumerate.hh"
 #include "narrow.hh"
 #include "one_of.hh"
@@ -559,6 +560,11 @@ void YMF278::generateChannels(std::span<float*> bufs, unsigned num)
 	}
 }
 
+VGMChip YMF278::getVGMChip() const
+{
+	return VGMChip::YMF278_WAVE;
+}
+
 void YMF278::keyOnHelper(YMF278::Slot& slot)
 {
 	// Unlike FM, the envelope level is reset. (And it makes sense, because you restart the sample.)
@@ -579,6 +585,10 @@ void YMF278::keyOnHelper(YMF278::Slot& slot)
 void YMF278::writeReg(uint8_t reg, uint8_t data, EmuTime::param time)
 {
 	updateStream(time); // TODO optimize only for regs that directly influence sound
+	if (vgmRecorder) [[unlikely]] {
+		// in a VGM file the wave part is port 2 of the YMF278B
+		vgmRecorder->write(VGMChip::YMF278_WAVE, 2, reg, data, time);
+	}
 	writeRegDirect(reg, data, time);
 }
 
@@ -89,6 +89,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(std::span<float*> bufs, unsigned num) override;
+	[[nodiscard]] VGMChip getVGMChip() const override;
 
 	void writeRegDirect(uint8_t reg, uint8_t data, EmuTime::param time);
 	[[nodiscard]] unsigned getRamAddress(unsigned addr) const;
@@ -0,0 +1,87 @@
+#include "WorkerPool.hh"
+#include "xrange.hh"
+#include <utility>
+
+namespace openmsx {
+
+WorkerPool::WorkerPool(unsigned numWorkers)
+{
+	workers.reserve(numWorkers);
+	repeat(numWorkers, [&] {
+		workers.emplace_back([this]() { workerLoop(); });
+	});
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::scoped_lock lock(mutex);
+		exitWorkers = true;
+	}
+	startCond.notify_all();
+	for (auto& t : workers) t.join();
+}
+
+void WorkerPool::runImpl(size_t numTasks, void* task, Call call)
+{
+	if (workers.empty() || (numTasks <= 1)) {
+		for (auto i : xrange(numTasks)) call(task, i);
+		return;
+	}
+
+	{
+		std::scoped_lock lock(mutex);
+		batchTask = task;
+		batchCall = call;
+		batchSize = numTasks;
+		nextTask = 0;
+		busyWorkers = getNumWorkers();
+		++batchNum;
+	}
+	startCond.notify_all();
+
+	executeTasks();
+
+	std::unique_lock lock(mutex);
+	doneCond.wait(lock, [&] { return busyWorkers == 0; });
+	if (exception) {
+		auto e = std::exchange(exception, nullptr);
+		std::rethrow_exception(e);
+	}
+}
+
+void WorkerPool::workerLoop()
+{
+	uint64_t lastBatch = 0;
+	while (true) {
+		{
+			std::unique_lock lock(mutex);
+			startCond.wait(lock, [&] { return exitWorkers || (batchNum != lastBatch); });
+			if (exitWorkers) return;
+			lastBatch = batchNum;
+		}
+		executeTasks();
+		{
+			std::scoped_lock lock(mutex);
+			--busyWorkers;
+		}
+		doneCond.notify_one();
+	}
+}
+
+void WorkerPool::executeTasks()
+{
+	// batchTask/batchCall/batchSize don't change while a batch is running
+	while (true) {
+		auto i = nextTask.fetch_add(1);
+		if (i >= batchSize) break;
+		try {
+			batchCall(batchTask, i);
+		} catch (...) {
+			std::scoped_lock lock(mutex);
+			if (!exception) exception = std::current_exception();
+		}
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,75 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace openmsx {
+
+/** A small pool of worker threads to execute a batch of independent tasks in
+  * parallel. run() blocks until all tasks of the batch have finished. The
+  * calling thread also executes tasks, so a pool with N workers uses up to
+  * N+1 threads. With zero workers all tasks are executed sequentially in the
+  * calling thread.
+  *
+  * This is meant for short, fine grained batches (e.g. once per sound
+  * fragment): the workers stay alive between batches and are only woken up
+  * (no allocations, no thread creation) when a new batch starts.
+  */
+class WorkerPool
+{
+public:
+	explicit WorkerPool(unsigned numWorkers);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	[[nodiscard]] unsigned getNumWorkers() const { return unsigned(workers.size()); }
+
+	/** Execute 'task(i)' for all 'i' in [0, numTasks). The order in which
+	  * the tasks are executed (and in which thread) is unspecified. If a
+	  * task throws, the remaining tasks are still executed and (one of)
+	  * the exceptions is rethrown after the batch has finished.
+	  * Must not be called concurrently (or recursively from a task).
+	  */
+	template<typename F>
+	void run(size_t numTasks, F&& task)
+	{
+		using T = std::remove_reference_t<F>;
+		runImpl(numTasks, const_cast<void*>(static_cast<const void*>(&task)),
+		        [](void* t, size_t i) { (*static_cast<T*>(t))(i); });
+	}
+
+private:
+	using Call = void (*)(void*, size_t);
+	void runImpl(size_t numTasks, void* task, Call call);
+	void workerLoop();
+	void executeTasks();
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex mutex; // protects all members below (except nextTask)
+	std::condition_variable startCond;
+	std::condition_variable doneCond;
+	void* batchTask = nullptr;
+	Call batchCall = nullptr;
+	size_t batchSize = 0;
+	uint64_t batchNum = 0; // incremented for each new batch
+	unsigned busyWorkers = 0;
+	std::exception_ptr exception;
+	bool exitWorkers = false;
+
+	std::atomic<size_t> nextTask = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,135 @@
+#include "catch.hpp"
+#include "CheatFinder.hh"
+#include "Debuggable.hh"
+#include "xrange.hh"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+using Op = CheatFinder::Op;
+using Width = CheatFinder::Width;
+
+class TestDebuggable final : public Debuggable
+{
+public:
+	explicit TestDebuggable(size_t size) : data(size) {}
+
+	[[nodiscard]] unsigned getSize() const override { return unsigned(data.size()); }
+	[[nodiscard]] std::string_view getDescription() const override { return "test"; }
+	[[nodiscard]] byte read(unsigned address) override { return data[address]; }
+	void write(unsigned address, byte value) override { data[address] = value; }
+
+	std::vector<uint8_t> data;
+};
+
+static unsigned valueAt(const std::vector<uint8_t>& data, unsigned address, Width width)
+{
+	return (width == Width::BYTE) ? data[address]
+	                              : data[address] | (data[address + 1] << 8);
+}
+
+// Straightforward implementation of the search, to compare against.
+static std::vector<unsigned> reference(
+	const std::vector<uint8_t>& oldData, const std::vector<uint8_t>& newData,
+	std::vector<unsigned> candidates, Width width, const CheatFinder::Condition& cond)
+{
+	std::erase_if(candidates, [&](unsigned a) {
+		int64_t n = valueAt(newData, a, width);
+		int64_t r = cond.value ? int64_t(*cond.value)
+		                       : int64_t(valueAt(oldData, a, width)) + cond.delta;
+		switch (cond.op) {
+			case Op::EQ: return !(n == r);
+			case Op::NE: return !(n != r);
+			case Op::LT: return !(n <  r);
+			case Op::LE: return !(n <= r);
+			case Op::GT: return !(n >  r);
+			case Op::GE: return !(n >= r);
+		}
+		return true;
+	});
+	return candidates;
+}
+
+static std::vector<unsigned> addresses(const CheatFinder& finder)
+{
+	std::vector<unsigned> result;
+	for (const auto& r : finder.getResults(size_t(-1))) result.push_back(r.address);
+	return result;
+}
+
+TEST_CASE("CheatFinder: simple")
+{
+	TestDebuggable mem(8);
+	mem.data = {1, 2, 3, 4, 5, 6, 7, 8};
+	CheatFinder finder;
+	CHECK(!finder.isActive());
+
+	finder.start(mem, "test", Width::BYTE);
+	CHECK(finder.isActive());
+	CHECK(finder.count() == 8);
+
+	mem.data = {1, 3, 3, 3, 6, 6, 8, 8};
+	finder.search(mem, {Op::GT, {}, 0}); // increased
+	CHECK(addresses(finder) == std::vector<unsigned>{1, 4, 6});
+	auto results = finder.getResults(2);
+	REQUIRE(results.size() == 2);
+	CHECK(results[1].address == 4);
+	CHECK(results[1].oldValue == 5);
+	CHECK(results[1].newValue == 6);
+
+	mem.data[4] = 7;
+	finder.search(mem, {Op::EQ, {}, 1}); // increased by one
+	CHECK(addresses(finder) == std::vector<unsigned>{4});
+
+	finder.start(mem, "test", Width::WORD);
+	CHECK(finder.count() == 7);
+	finder.search(mem, {Op::EQ, 0x0303, 0});
+	CHECK(addresses(finder) == std::vector<unsigned>{1, 2});
+
+	std::vector<unsigned> keep = {2, 5};
+	finder.retain(keep);
+	CHECK(addresses(finder) == std::vector<unsigned>{2});
+
+	finder.clear();
+	CHECK(!finder.isActive());
+	CHECK(finder.count() == 0);
+}
+
+TEST_CASE("CheatFinder: compare with reference")
+{
+	std::mt19937 gen(1234);
+	auto randomByte = [&] { return uint8_t(gen() & 3); }; // small range -> many equal values
+
+	for (size_t size : {1, 15, 16, 17, 63, 64, 65, 100, 1000, 4099}) {
+		for (auto width : {Width::BYTE, Width::WORD}) {
+			TestDebuggable mem(size);
+			for (auto& b : mem.data) b = randomByte();
+			CheatFinder finder;
+			finder.start(mem, "test", width);
+
+			unsigned num = (width == Width::BYTE) ? unsigned(size) : unsigned(size - 1);
+			std::vector<unsigned> expected;
+			for (auto i : xrange(num)) expected.push_back(i);
+			CHECK(addresses(finder) == expected);
+
+			for (auto op : {Op::EQ, Op::NE, Op::LT, Op::LE, Op::GT, Op::GE}) {
+				for (const auto& cond : {CheatFinder::Condition{op, {}, 0},
+				                         CheatFinder::Condition{op, {}, 1},
+				                         CheatFinder::Condition{op, {}, -1},
+				                         CheatFinder::Condition{op, {}, 1000},
+				                         CheatFinder::Condition{op, 2, 0},
+				                         CheatFinder::Condition{op, 0x0302, 0},
+				                         CheatFinder::Condition{op, -1, 0},
+				                         CheatFinder::Condition{op, 0x10000, 0}}) {
+					finder.start(mem, "test", width);
+					auto oldData = mem.data;
+					for (auto& b : mem.data) b = randomByte();
+					finder.search(mem, cond);
+					CHECK(addresses(finder) ==
+					      reference(oldData, mem.data, expected, width, cond));
+				}
+			}
+		}
+	}
+}
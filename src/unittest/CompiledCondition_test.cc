@@ -0,0 +1,118 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+#include "CPURegs.hh"
+#include <array>
+
+using namespace openmsx;
+
+struct TestMachine final : CompiledCondition::Machine
+{
+	TestMachine() : regs(false) { mem.fill(0); }
+
+	[[nodiscard]] const CPURegs& getRegisters() const override { return regs; }
+	[[nodiscard]] byte peekMem(word address) const override { return mem[address]; }
+	[[nodiscard]] std::pair<int, int> getSelectedSlot(int page) const override {
+		return slots[page];
+	}
+
+	CPURegs regs;
+	std::array<byte, 0x10000> mem;
+	std::array<std::pair<int, int>, 4> slots = {{{0, -1}, {0, -1}, {3, 0}, {3, 0}}};
+};
+
+static std::optional<bool> eval(std::string_view expr, const TestMachine& machine)
+{
+	auto c = CompiledCondition::compile(expr);
+	REQUIRE(c);
+	return c->evaluate(machine);
+}
+static bool isTrue(std::string_view expr, const TestMachine& machine)
+{
+	auto result = eval(expr, machine);
+	REQUIRE(result);
+	return *result;
+}
+
+TEST_CASE("CompiledCondition: unsupported")
+{
+	CHECK(!CompiledCondition::compile(""));
+	CHECK(!CompiledCondition::compile("$::wp_last_address == 3"));
+	CHECK(!CompiledCondition::compile("[reg XX] == 3"));
+	CHECK(!CompiledCondition::compile("[reg PC] eq 3"));
+	CHECK(!CompiledCondition::compile("[pc_in_slot 1 2 3]"));
+	CHECK(!CompiledCondition::compile("[my_proc] == 1"));
+	CHECK(!CompiledCondition::compile("010 == 8")); // Tcl octal
+	CHECK(!CompiledCondition::compile("1.5 > 1"));
+	CHECK(!CompiledCondition::compile("1 +"));
+	CHECK(!CompiledCondition::compile("(1 == 1"));
+	CHECK(!CompiledCondition::compile("1 == 1 junk"));
+	CHECK(!CompiledCondition::compile("99999999999999999999 > 1"));
+}
+
+TEST_CASE("CompiledCondition: arithmetic")
+{
+	TestMachine m;
+	CHECK( isTrue("1", m));
+	CHECK(!isTrue("0", m));
+	CHECK( isTrue("1 + 2 * 3 == 7", m));
+	CHECK( isTrue("(1 + 2) * 3 == 9", m));
+	CHECK( isTrue("0x10 == 16 && 0b101 == 5 && 0o17 == 15", m));
+	CHECK( isTrue("-7 / 2 == -4", m)); // rounds towards -infinity
+	CHECK( isTrue("-7 % 2 == 1", m));
+	CHECK( isTrue("7 % -2 == -1", m));
+	CHECK( isTrue("1 << 4 == 16 && 0x80 >> 3 == 16", m));
+	CHECK( isTrue("(0xF0 | 0x0F) == 0xFF && (0xF0 & 0x3C) == 0x30 && (5 ^ 3) == 6", m));
+	CHECK( isTrue("~0 == -1 && !0 && !!5 == 1", m));
+	CHECK( isTrue("1 < 2 && 2 <= 2 && 3 > 2 && 3 >= 3 && 1 != 2", m));
+	CHECK( isTrue("(3 || 0) == 1 && (0 || 0) == 0 && (3 && 4) == 1", m));
+	CHECK( isTrue("(1 ? 2 : 3) == 2 && (0 ? 2 : 3) == 3", m));
+	CHECK( isTrue("(0 ? 1 : 0 ? 2 : 3) == 3", m));
+
+	// Tcl reports errors for these, let Tcl handle them
+	CHECK(!eval("1 / 0", m));
+	CHECK(!eval("1 % 0", m));
+	CHECK(!eval("1 << -1", m));
+	CHECK(!eval("0x7FFFFFFFFFFFFFFF + 1", m));
+	// ... but short circuit evaluation can avoid the error
+	CHECK(eval("0 && (1 / 0)", m) == false);
+	CHECK(eval("1 || (1 / 0)", m) == true);
+}
+
+TEST_CASE("CompiledCondition: machine state")
+{
+	TestMachine m;
+	m.regs.setPC(0x4010);
+	m.regs.setHL(0xC000);
+	m.regs.setA(0x12);
+	m.mem[0xF3AE] = 4;
+	m.mem[0xC000] = 0x34;
+	m.mem[0xC001] = 0xFE;
+
+	CHECK( isTrue("[reg PC] == 0x4010 && [peek 0xF3AE] > 3", m));
+	CHECK(!isTrue("[reg PC] == 0x4010 && [peek 0xF3AE] > 4", m));
+	CHECK( isTrue("[reg pc] == 0x4010 && [reg PCh] == 0x40 && [reg PCL] == 0x10", m));
+	CHECK( isTrue("[reg A] == 0x12 && [reg HL] == 0xC000", m));
+	CHECK( isTrue("[peek [reg HL]] == 0x34", m));
+	CHECK( isTrue("[peek16 [reg HL]] == 0xFE34", m));
+	CHECK( isTrue("[peek16_BE 0xC000 memory] == 0x34FE", m));
+	CHECK( isTrue("[peek_s8 0xC001] == -2", m));
+	CHECK( isTrue("[peek_s16 0xC000] == -460", m));
+	CHECK( isTrue("[debug read memory 0xF3AE] == 4", m));
+
+	// Tcl reports errors for addresses outside [0, 0xFFFF], let Tcl handle them
+	CHECK(!eval("[peek [peek_s8 0xC001]] == 0", m)); // address -2
+	CHECK(!eval("[peek 0x10000] == 0", m));
+	CHECK(!eval("[peek16 0xFFFF] == 0", m));
+	CHECK(!eval("[peek16_BE 0xFFFF memory] == 0", m));
+	CHECK(!eval("[peek_s16 [peek_s8 0xC001]] == 0", m));
+	CHECK( isTrue("[peek 0xFFFF] == 0 && [peek16 0xFFFE] == 0", m));
+
+	CHECK( isTrue("[pc_in_slot 0]", m));
+	CHECK(!isTrue("[pc_in_slot 1]", m));
+	CHECK( isTrue("[pc_in_slot 0 1]", m)); // page 1 is not expanded
+	m.regs.setPC(0x8000);
+	CHECK( isTrue("[pc_in_slot 3]", m));
+	CHECK( isTrue("[pc_in_slot 3 0]", m));
+	CHECK(!isTrue("[pc_in_slot 3 1]", m));
+	CHECK( isTrue("[pc_in_slot X 0]", m));
+}
@@ -0,0 +1,54 @@
+#include "catch.hpp"
+#include "LFSRJump.hh"
+#include "xrange.hh"
+#include <cstdint>
+
+template<typename Step>
+static void check(Step step, uint32_t state)
+{
+	LFSRJump jump(step);
+	CHECK(jump.advance(state, 0) == state);
+	uint32_t x = state;
+	for (auto n : xrange(1, 5000)) {
+		x = step(x);
+		CHECK(jump.advance(state, n) == x);
+		CHECK(jump.advance(jump.advance(state, n / 3), n - n / 3) == x);
+	}
+}
+
+TEST_CASE("LFSRJump")
+{
+	// Y8950
+	check([](uint32_t x) {
+		if (x & 1) x ^= 0x24000;
+		return x >> 1;
+	}, 0xffff);
+
+	// YMF262
+	check([](uint32_t x) {
+		if (x & 1) x ^= 0x800302;
+		return x >> 1;
+	}, 1);
+
+	// YM2151, XNOR feedback made linear with an extra always-1 bit
+	check([](uint32_t x) {
+		uint32_t one = (x >> 17) & 1;
+		x &= 0x1ffff;
+		uint32_t j = ((x ^ (x >> 3)) & 1) ^ one;
+		return (one << 17) | (j << 16) | (x >> 1);
+	}, 1 << 17);
+
+	// full 32 bits, Fibonacci form
+	check([](uint32_t x) {
+		uint32_t b = (x ^ (x >> 10) ^ (x >> 30) ^ (x >> 31)) & 1;
+		return (x >> 1) | (b << 31);
+	}, 0x12345678);
+
+	// compile-time
+	static constexpr LFSRJump jump([](uint32_t x) {
+		if (x & 1) x ^= 0x24000;
+		return x >> 1;
+	});
+	static_assert(jump.advance(0xffff, 0) == 0xffff);
+	static_assert(jump.advance(0xffff, 1) == (0xffff ^ 0x24000) >> 1);
+}
@@ -127,3 +127,30 @@ TEST_CASE("Math::div_mod_floor")
 	test( 10, -2, -5,  0);
 	test(-10, -2,  5,  0);
 }
+
+TEST_CASE("Math::firstMultipleInRange")
+{
+	auto bruteForce = [](uint64_t a, uint64_t m, uint64_t lo, uint64_t hi) -> std::optional<uint64_t> {
+		for (uint64_t x = 0; x < m; ++x) {
+			auto r = (a * x) % m;
+			if ((lo <= r) && (r <= hi)) return x;
+		}
+		return {};
+	};
+	for (uint64_t m : {1, 2, 7, 16, 30, 64}) {
+		for (uint64_t a = 0; a < m; ++a) {
+			for (uint64_t lo = 0; lo < m; ++lo) {
+				for (uint64_t hi = lo; hi < m; ++hi) {
+					CHECK(Math::firstMultipleInRange(a, m, lo, hi) == bruteForce(a, m, lo, hi));
+				}
+			}
+		}
+	}
+	// numbers as used in Y8950
+	static constexpr uint64_t M = 0x40 << 11;
+	static constexpr uint64_t END = 0x3f << 11;
+	for (uint64_t a : {1, 3, 2048, 2049, 4096, 12288, 65537, 130944}) {
+		CHECK(Math::firstMultipleInRange(a, M, END, M - 1) == bruteForce(a, M, END, M - 1));
+		CHECK(Math::firstMultipleInRange(a, M, 1000, END + 5) == bruteForce(a, M, 1000, END + 5));
+	}
+}
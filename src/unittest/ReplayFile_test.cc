@@ -0,0 +1,229 @@
+#include "catch.hpp"
+#include "ReplayFile.hh"
+#include "MemoryBufferFile.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "strCat.hh"
+#include "endian.hh"
+#include "xrange.hh"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+
+using namespace openmsx;
+
+// Build a file in the replay format, independently of ReplayFileWriter (that
+// one can only write to disk).
+struct TestFile
+{
+	struct Block {
+		uint64_t time;
+		std::string content;
+	};
+	std::vector<Block> snapshots = {{100, "first snapshot"}, {200, "second"}, {300, "third"}};
+	std::string log = "the event log";
+	uint32_t version = 1;
+
+	[[nodiscard]] std::vector<uint8_t> build() const {
+		std::vector<uint8_t> buf;
+		auto append = [&](std::string_view s) { buf.insert(buf.end(), s.begin(), s.end()); };
+		auto appendL32 = [&](uint32_t x) {
+			std::array<uint8_t, 4> tmp; Endian::write_UA_L32(tmp.data(), x);
+			buf.insert(buf.end(), tmp.begin(), tmp.end());
+		};
+		auto appendL64 = [&](uint64_t x) {
+			std::array<uint8_t, 8> tmp; Endian::write_UA_L64(tmp.data(), x);
+			buf.insert(buf.end(), tmp.begin(), tmp.end());
+		};
+		struct Entry { uint64_t offset, compressedSize, size; };
+		auto appendBlock = [&](std::string_view s) {
+			auto len = compressBound(uLong(s.size()));
+			std::vector<uint8_t> tmp(len);
+			REQUIRE(compress(tmp.data(), &len, reinterpret_cast<const Bytef*>(s.data()), uLong(s.size())) == Z_OK);
+			Entry e{buf.size(), len, s.size()};
+			buf.insert(buf.end(), tmp.data(), tmp.data() + len);
+			return e;
+		};
+
+		append("oMSX-rpl");
+		appendL32(version);
+		std::vector<Entry> entries;
+		for (const auto& s : snapshots) entries.push_back(appendBlock(s.content));
+		auto logEntry = appendBlock(log);
+		auto indexOffset = buf.size();
+		appendL32(uint32_t(snapshots.size()));
+		for (auto i : xrange(snapshots.size())) {
+			appendL64(snapshots[i].time);
+			appendL64(entries[i].offset);
+			appendL64(entries[i].compressedSize);
+			appendL64(entries[i].size);
+		}
+		appendL64(logEntry.offset);
+		appendL64(logEntry.compressedSize);
+		appendL64(logEntry.size);
+		appendL64(indexOffset);
+		append("oMSX-idx");
+		return buf;
+	}
+};
+
+static ReplayFileReader read(const std::vector<uint8_t>& buf)
+{
+	return ReplayFileReader(memory_buffer_file(buf), "test");
+}
+
+// Offset of the index, as stored in the trailer.
+static size_t indexOffset(const std::vector<uint8_t>& buf)
+{
+	return Endian::read_UA_L64(&buf[buf.size() - 16]);
+}
+
+TEST_CASE("ReplayFile: valid")
+{
+	TestFile test;
+	auto buf = test.build();
+	CHECK(ReplayFileReader::isReplayFile(buf));
+
+	auto reader = read(buf);
+	CHECK(reader.getName() == "test");
+	REQUIRE(reader.getNumSnapshots() == 3);
+	for (auto i : xrange(3)) {
+		CHECK(reader.getSnapshotTime(i) == EmuTime::zero() + EmuDuration(test.snapshots[i].time));
+		CHECK(reader.getSnapshot(i) == test.snapshots[i].content);
+	}
+	CHECK(reader.getLog() == test.log);
+}
+
+TEST_CASE("ReplayFile: bad header or trailer")
+{
+	auto buf = TestFile().build();
+	auto bad = buf;
+	bad[0] = 'x'; // header magic
+	CHECK(!ReplayFileReader::isReplayFile(bad));
+	CHECK_THROWS(read(bad));
+
+	TestFile other;
+	other.version = 2;
+	CHECK_THROWS(read(other.build()));
+
+	bad = buf;
+	bad.back() = 'y'; // trailer magic
+	CHECK_THROWS(read(bad));
+
+	// old XML-based format
+	std::vector<uint8_t> xml = {'<', '?', 'x', 'm', 'l'};
+	CHECK(!ReplayFileReader::isReplayFile(xml));
+}
+
+TEST_CASE("ReplayFile: truncated")
+{
+	auto buf = TestFile().build();
+	for (auto len : xrange(buf.size())) {
+		std::vector<uint8_t> truncated(buf.begin(), buf.begin() + len);
+		CHECK_THROWS(read(truncated));
+	}
+	// extra data at the end looks like a bad trailer
+	buf.push_back(0);
+	CHECK_THROWS(read(buf));
+}
+
+TEST_CASE("ReplayFile: corrupt index")
+{
+	auto buf = TestFile().build();
+	auto idx = indexOffset(buf);
+	auto entry = [&](size_t i) { return idx + 4 + i * 32; }; // time, offset, compressed size, size
+
+	SECTION("index offset") {
+		for (uint64_t offset : {uint64_t(0), uint64_t(idx + 1), uint64_t(buf.size()), ~uint64_t(0)}) {
+			auto bad = buf;
+			Endian::write_UA_L64(&bad[bad.size() - 16], offset);
+			CHECK_THROWS(read(bad));
+		}
+	}
+	SECTION("number of snapshots") {
+		for (uint32_t num : {0u, 2u, 4u, ~0u}) {
+			auto bad = buf;
+			Endian::write_UA_L32(&bad[idx], num);
+			CHECK_THROWS(read(bad));
+		}
+	}
+	SECTION("snapshots not sorted") {
+		auto bad = buf;
+		Endian::write_UA_L64(&bad[entry(1)], 50);
+		CHECK_THROWS(read(bad));
+	}
+	SECTION("block offset and size") {
+		auto check = [&](size_t pos, uint64_t value) {
+			auto bad = buf;
+			Endian::write_UA_L64(&bad[pos], value);
+			CHECK_THROWS(read(bad));
+		};
+		check(entry(0) + 8, 0);                  // offset inside header
+		check(entry(0) + 8, idx + 1);            // offset beyond index
+		check(entry(0) + 8, ~uint64_t(0));
+		check(entry(2) + 16, idx);               // compressed size too large
+		check(entry(2) + 16, ~uint64_t(0));
+		check(entry(2) + 24, ~uint64_t(0));      // uncompressed size too large
+		check(entry(3) + 0, idx + 1);            // log offset
+		check(entry(3) + 8, ~uint64_t(0));       // log compressed size
+	}
+}
+
+TEST_CASE("ReplayFile: corrupt block")
+{
+	auto buf = TestFile().build();
+	auto idx = indexOffset(buf);
+	auto entry = idx + 4;
+	auto offset = Endian::read_UA_L64(&buf[entry + 8]);
+	auto compressedSize = Endian::read_UA_L64(&buf[entry + 16]);
+
+	SECTION("corrupt data") {
+		for (auto i : xrange(compressedSize)) buf[offset + i] ^= 0x55;
+		auto reader = read(buf); // index is still fine
+		CHECK_THROWS(reader.getSnapshot(0));
+		CHECK(reader.getSnapshot(1) == "second");
+	}
+	SECTION("wrong uncompressed size") {
+		Endian::write_UA_L64(&buf[entry + 24], Endian::read_UA_L64(&buf[entry + 24]) + 1);
+		auto reader = read(buf);
+		CHECK_THROWS(reader.getSnapshot(0));
+	}
+}
+
+TEST_CASE("ReplayFile: write and read back")
+{
+	auto dir = FileOperations::getTempDir();
+	auto filename = strCat(dir, "/openmsx-replayfile-test.omr");
+	FileOperations::unlink(filename);
+
+	auto write = [&](std::string_view content, bool finish) {
+		ReplayFileWriter writer(filename);
+		writer.addSnapshot(EmuTime::zero() + EmuDuration(uint64_t(10)), content);
+		writer.addSnapshot(EmuTime::zero() + EmuDuration(uint64_t(20)), "2nd");
+		if (finish) writer.finish("log");
+	};
+	write("old content", true);
+	{
+		ReplayFileReader reader(File(filename), filename);
+		REQUIRE(reader.getNumSnapshots() == 2);
+		CHECK(reader.getSnapshotTime(1) == EmuTime::zero() + EmuDuration(uint64_t(20)));
+		CHECK(reader.getSnapshot(0) == "old content");
+		CHECK(reader.getSnapshot(1) == "2nd");
+		CHECK(reader.getLog() == "log");
+
+	}
+
+	// An unfinished write keeps the existing file (and removes the
+	// temporary file) ...
+	write("new content", false);
+	CHECK(ReplayFileReader(File(filename), filename).getSnapshot(0) == "old content");
+	CHECK(!FileOperations::exists(strCat(filename, ".tmp")));
+
+	// ... a finished write replaces it.
+	write("new content", true);
+	CHECK(ReplayFileReader(File(filename), filename).getSnapshot(0) == "new content");
+	FileOperations::unlink(filename);
+}
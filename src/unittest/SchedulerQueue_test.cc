@@ -0,0 +1,167 @@
+#include "catch.hpp"
+#include "SchedulerHeap.hh"
+#include "SchedulerQueue.hh"
+#include "xrange.hh"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Simplified version of SynchronizationPoint.
+struct SP
+{
+	uint64_t time;
+	int device;
+};
+struct LessSP {
+	bool operator()(const SP& x, const SP& y) const { return x.time < y.time; }
+};
+
+// Give both containers the same interface.
+struct Queue
+{
+	void insert(const SP& sp) {
+		q.insert(sp, [](SP& s) { s.time = std::numeric_limits<uint64_t>::max(); }, LessSP{});
+	}
+	SchedulerQueue<SP> q;
+};
+struct Heap
+{
+	void insert(const SP& sp) { q.insert(sp); }
+	SchedulerHeap<SP, LessSP> q;
+};
+
+// Pop all elements, and check they come out sorted (and in insertion order
+// for equal times).
+template<typename Q>
+static std::vector<int> drain(Q& queue)
+{
+	std::vector<int> result;
+	uint64_t last = 0;
+	while (!queue.q.empty()) {
+		const auto& f = queue.q.front();
+		CHECK(f.time >= last);
+		last = f.time;
+		result.push_back(f.device);
+		queue.q.remove_front();
+	}
+	return result;
+}
+
+TEST_CASE("SchedulerHeap: basic")
+{
+	Heap heap;
+	CHECK(heap.q.empty());
+	heap.insert({20, 1});
+	heap.insert({10, 2});
+	heap.insert({20, 3}); // same time as device 1, must come after it
+	heap.insert({15, 4});
+	heap.insert({10, 5}); // same time as device 2
+	CHECK(heap.q.size() == 5);
+	CHECK(heap.q.front().device == 2);
+
+	auto isDev = [](int d) { return [d](const SP& sp) { return sp.device == d; }; };
+	REQUIRE(heap.q.find(isDev(4)));
+	CHECK(heap.q.find(isDev(4))->time == 15);
+	CHECK(!heap.q.find(isDev(6)));
+
+	CHECK( heap.q.remove(isDev(4)));
+	CHECK(!heap.q.remove(isDev(4)));
+	CHECK(drain(heap) == std::vector{2, 5, 1, 3});
+}
+
+TEST_CASE("SchedulerHeap: same order as SchedulerQueue")
+{
+	std::mt19937 gen(1234); // fixed seed, reproducible
+	std::uniform_int_distribution<int> opDist(0, 9);
+	std::uniform_int_distribution<int> devDist(0, 15);
+	std::uniform_int_distribution<uint64_t> timeDist(0, 50); // many duplicates
+
+	Queue queue;
+	Heap heap;
+	uint64_t now = 0;
+	repeat(10000, [&] {
+		int op = opDist(gen);
+		int dev = devDist(gen);
+		auto isDev = [&](const SP& sp) { return sp.device == dev; };
+		if (op < 5) {
+			SP sp{now + timeDist(gen), dev};
+			queue.insert(sp);
+			heap.insert(sp);
+		} else if (op < 8) {
+			REQUIRE(queue.q.empty() == heap.q.empty());
+			if (!queue.q.empty()) {
+				CHECK(queue.q.front().time   == heap.q.front().time);
+				CHECK(queue.q.front().device == heap.q.front().device);
+				now = queue.q.front().time;
+				queue.q.remove_front();
+				heap.q.remove_front();
+			}
+		} else if (op < 9) {
+			const auto* q = queue.q.find(isDev);
+			const auto* h = heap.q.find(isDev);
+			REQUIRE((q == nullptr) == (h == nullptr));
+			if (q) CHECK(q->time == h->time);
+			CHECK(queue.q.remove(isDev) == heap.q.remove(isDev));
+		} else {
+			queue.q.remove_all(isDev);
+			heap.q.remove_all(isDev);
+		}
+		CHECK(queue.q.size() == heap.q.size());
+	});
+	CHECK(drain(queue) == drain(heap));
+}
+
+// Not a real test, but a micro-benchmark to compare both containers. It is
+// not run by default, run it with:
+//    unittest "[benchmark]"
+//
+// The access pattern mimics the Scheduler in a machine with many timers:
+// each device has its own period, when its sync point expires it's
+// rescheduled one period later. Now and then a device reprograms its timer
+// (removes its pending sync point and sets a new one).
+template<typename Q>
+static double benchmarkScheduler(int numDevices, int steps)
+{
+	std::mt19937 gen(5678);
+	std::uniform_int_distribution<uint64_t> periodDist(50, 20000);
+	std::uniform_int_distribution<int> reprogramDist(0, 15);
+	std::vector<uint64_t> periods;
+	repeat(numDevices, [&] { periods.push_back(periodDist(gen)); });
+
+	Q queue;
+	for (auto d : xrange(numDevices)) queue.insert({periods[d], d});
+
+	auto start = std::chrono::steady_clock::now();
+	uint64_t checksum = 0;
+	repeat(steps, [&] {
+		auto [time, dev] = queue.q.front();
+		checksum += time;
+		queue.q.remove_front();
+		queue.insert({time + periods[dev], dev});
+		if (reprogramDist(gen) == 0) {
+			int other = (dev * 7 + 3) % numDevices;
+			if (queue.q.remove([&](const SP& sp) { return sp.device == other; })) {
+				queue.insert({time + periods[other] / 2, other});
+			}
+		}
+	});
+	auto stop = std::chrono::steady_clock::now();
+	CHECK(checksum != 0); // don't optimize away
+	return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+TEST_CASE("SchedulerQueue versus SchedulerHeap", "[.][benchmark]")
+{
+	static constexpr int STEPS = 10'000'000;
+	for (int numDevices : {5, 10, 20, 40, 60, 100}) {
+		double tq = benchmarkScheduler<Queue>(numDevices, STEPS);
+		double th = benchmarkScheduler<Heap >(numDevices, STEPS);
+		std::cout << numDevices << " sync points: SchedulerQueue "
+		          << tq << "ms, SchedulerHeap " << th << "ms\n";
+	}
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "SoftwareScaler.hh"
+#include "RawFrame.hh"
+#include "xrange.hh"
+#include <vector>
+
+using namespace openmsx;
+using Pixel = SoftwareScaler::Pixel;
+
+// A frame with a mix of 320 and 640 pixel wide lines and border lines.
+static RawFrame createTestFrame()
+{
+	RawFrame frame(640, 240);
+	for (auto y : xrange(240u)) {
+		if ((y % 10) == 9) {
+			frame.setBlank(y, 0xFF000000 | (y * 0x010203));
+		} else {
+			unsigned width = (y < 120) ? 320 : 640;
+			auto line = frame.getLineDirect(y);
+			for (auto x : xrange(width)) {
+				line[x] = 0xFF000000 | ((x * 7 + y * 13) * 0x0103070B);
+			}
+			frame.setLineWidth(y, width);
+		}
+	}
+	return frame;
+}
+
+static std::vector<Pixel> scale(unsigned numWorkers, const FrameSource& frame,
+                                const SoftwareScaler::Config& config)
+{
+	SoftwareScaler scaler(numWorkers);
+	std::vector<Pixel> out(size_t(320) * 240 * config.factor * config.factor);
+	scaler.scaleImage(frame, config, out);
+	return out;
+}
+
+TEST_CASE("SoftwareScaler: plain resize")
+{
+	// No blur and no scanlines: same result as FrameSource::getLinePtrXXX()
+	auto frame = createTestFrame();
+	for (unsigned factor : {1, 2, 3}) {
+		SoftwareScaler::Config config{RenderSettings::SCALER_SIMPLE, factor, 0, 255};
+		auto out = scale(0, frame, config);
+		unsigned width = 320 * factor;
+		std::vector<Pixel> buf(width);
+		for (auto y : xrange(240 * factor)) {
+			auto line = frame.getLine(narrow<int>(y / factor), buf);
+			for (auto x : xrange(width)) {
+				CHECK(out[y * width + x] == line[x]);
+			}
+		}
+	}
+}
+
+TEST_CASE("SoftwareScaler: scanlines and blur")
+{
+	RawFrame frame(320, 240);
+	for (auto y : xrange(240u)) {
+		auto line = frame.getLineDirect(y);
+		for (auto x : xrange(320u)) line[x] = 0xFF806040;
+		frame.setLineWidth(y, 320);
+	}
+
+	// 100% scanlines at factor 2: every other line is black (alpha is preserved)
+	auto out = scale(0, frame, {RenderSettings::SCALER_SIMPLE, 2, 0, 0});
+	for (auto y : xrange(480u)) {
+		auto expected = (y & 1) ? 0xFF806040 : 0xFF000000;
+		CHECK(out[y * 640 +   0] == expected);
+		CHECK(out[y * 640 + 639] == expected);
+	}
+
+	// blurring a single color has no effect
+	out = scale(0, frame, {RenderSettings::SCALER_SIMPLE, 3, 256, 255});
+	for (auto p : out) CHECK(p == 0xFF806040);
+}
+
+TEST_CASE("SoftwareScaler: same result for any number of threads")
+{
+	auto frame = createTestFrame();
+	for (auto algo : {RenderSettings::SCALER_SIMPLE, RenderSettings::SCALER_RGBTRIPLET}) {
+		for (unsigned factor : {1, 2, 3}) {
+			SoftwareScaler::Config config{algo, factor, 128, 200};
+			auto expected = scale(0, frame, config);
+			CHECK(scale(1, frame, config) == expected);
+			CHECK(scale(3, frame, config) == expected);
+		}
+	}
+}
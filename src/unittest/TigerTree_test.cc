@@ -2,7 +2,11 @@
 #include "TigerTree.hh"
 #include "tiger.hh"
 #include "ranges.hh"
+#include "ScopedAssign.hh"
+#include "xrange.hh"
+#include <random>
 #include <span>
+#include <vector>
 
 using namespace openmsx;
 
@@ -10,17 +14,52 @@ struct TTTestData final : public TTData
 {
 	uint8_t* getData(size_t offset, size_t /*size*/) override
 	{
+		++numGetData;
 		return buffer + offset;
 	}
 
-	bool isCacheStillValid(time_t&) override
+	bool isCacheStillValid(time_t& t) override
 	{
+		t = time;
 		return false;
 	}
 
 	uint8_t* buffer;
+	time_t time = 0;
+	size_t numGetData = 0;
 };
 
+// Straightforward (non-incremental) tiger-tree-hash calculation.
+// Like TTData::getData() it requires one writable byte in front of 'data'.
+static TigerHash referenceHash(std::span<uint8_t> data)
+{
+	static constexpr auto BLOCK_SIZE = TigerTree::BLOCK_SIZE;
+	std::vector<TigerHash> hashes;
+	for (size_t offset = 0; offset < data.size(); offset += BLOCK_SIZE) {
+		auto& h = hashes.emplace_back();
+		auto size = std::min(BLOCK_SIZE, data.size() - offset);
+		auto* d = &data[offset];
+		if (size == BLOCK_SIZE) {
+			tiger_leaf(std::span{d, size}, h);
+		} else {
+			auto sa = ScopedAssign(d[-1], uint8_t(0));
+			tiger(std::span{d - 1, size + 1}, h);
+		}
+	}
+	while (hashes.size() > 1) {
+		std::vector<TigerHash> next;
+		for (size_t i = 0; i < hashes.size(); i += 2) {
+			if ((i + 1) < hashes.size()) {
+				tiger_int(hashes[i], hashes[i + 1], next.emplace_back());
+			} else {
+				next.push_back(hashes[i]);
+			}
+		}
+		std::swap(hashes, next);
+	}
+	return hashes[0];
+}
+
 
 // TODO check that hash (re)calculation is indeed incremental
 
@@ -88,3 +127,65 @@ TEST_CASE("TigerTree")
 		      "PLHCYOTPV4TTXTUPHYGGVPMARGMFE4U5JYRV4VA");
 	}
 }
+
+TEST_CASE("TigerTree: large tree, save/load cache")
+{
+	static constexpr auto BLOCK_SIZE = TigerTree::BLOCK_SIZE;
+	static constexpr auto SUBTREE_SIZE = TigerTree::SUBTREE_BLOCKS * BLOCK_SIZE;
+	static constexpr size_t SIZE = 5 * SUBTREE_SIZE + 300;
+	std::vector<uint8_t> buffer_(SIZE + 1);
+	auto buffer = subspan(buffer_, 1);
+	std::mt19937 gen(1234);
+	for (auto& b : buffer) b = uint8_t(gen());
+
+	TTTestData data;
+	data.buffer = buffer.data();
+	data.time = 1000;
+	std::string name = "large";
+	auto dummyCallback = [](size_t, size_t) {};
+
+	// (possibly) calculated in parallel, see TigerTree::calcSubtrees()
+	std::vector<uint8_t> cache;
+	{
+		TigerTree tt(data, SIZE, name);
+		CHECK(tt.getTime() == 1000);
+		CHECK(tt.calcHash(dummyCallback).toString() == referenceHash(buffer).toString());
+		cache = tt.saveCache();
+		CHECK(!cache.empty());
+	}
+	SECTION("restore cache, no recalculation needed") {
+		TigerTree tt(data, SIZE, name);
+		CHECK(tt.loadCache(cache));
+		data.numGetData = 0;
+		CHECK(tt.calcHash(dummyCallback).toString() == referenceHash(buffer).toString());
+		CHECK(data.numGetData == 0);
+
+		// only the subtree containing the change gets recalculated
+		buffer[2 * SUBTREE_SIZE + 10] ^= 1;
+		tt.notifyChange(2 * SUBTREE_SIZE + 10, 1, data.time);
+		CHECK(tt.calcHash(dummyCallback).toString() == referenceHash(buffer).toString());
+		CHECK(data.numGetData == TigerTree::SUBTREE_BLOCKS);
+
+		// and again after save/load of a partially invalid tree
+		buffer[4 * SUBTREE_SIZE + 20] ^= 1;
+		tt.notifyChange(4 * SUBTREE_SIZE + 20, 1, data.time);
+		CHECK(tt.getTime() == data.time);
+		auto cache2 = tt.saveCache();
+		TigerTree tt2(data, SIZE, name);
+		CHECK(tt2.loadCache(cache2));
+		CHECK(tt2.calcHash(dummyCallback).toString() == referenceHash(buffer).toString());
+	}
+	SECTION("cache is not used when time doesn't match") {
+		data.time = 2000;
+		TigerTree tt(data, SIZE, name);
+		CHECK(!tt.loadCache(cache));
+	}
+	SECTION("cache is not used when name doesn't match") {
+		TigerTree tt(data, SIZE, "other");
+		CHECK(!tt.loadCache(cache));
+	}
+	SECTION("cache is not used for different size") {
+		TigerTree tt(data, SIZE - 1, name);
+		CHECK(!tt.loadCache(cache));
+	}
+}
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+#include "WorkerPool.hh"
+#include "xrange.hh"
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("WorkerPool: all tasks executed exactly once")
+{
+	for (unsigned numWorkers : {0, 1, 3, 7}) {
+		WorkerPool pool(numWorkers);
+		CHECK(pool.getNumWorkers() == numWorkers);
+		for (size_t numTasks : {0, 1, 2, 5, 100}) {
+			std::vector<int> count(numTasks);
+			std::atomic<int> total = 0;
+			// run several batches on the same pool
+			repeat(10, [&] {
+				pool.run(numTasks, [&](size_t i) {
+					++count[i];
+					++total;
+				});
+			});
+			for (auto c : count) CHECK(c == 10);
+			CHECK(total == int(10 * numTasks));
+		}
+	}
+}
+
+TEST_CASE("WorkerPool: same result as sequential")
+{
+	// Each task writes its own output, so the result doesn't depend on
+	// the number of threads or on the order of execution.
+	auto calc = [](unsigned numWorkers) {
+		WorkerPool pool(numWorkers);
+		std::vector<std::vector<float>> out(9, std::vector<float>(1000));
+		pool.run(out.size(), [&](size_t i) {
+			float phase = 0.0f;
+			for (auto& o : out[i]) {
+				phase += 0.01f * float(i + 1);
+				o = std::sin(phase);
+			}
+		});
+		return out;
+	};
+	auto expected = calc(0);
+	CHECK(calc(1) == expected);
+	CHECK(calc(4) == expected);
+}
+
+TEST_CASE("WorkerPool: exceptions")
+{
+	WorkerPool pool(2);
+	std::atomic<int> total = 0;
+	CHECK_THROWS_AS(pool.run(10, [&](size_t i) {
+		++total;
+		if (i == 3) throw std::runtime_error("task 3");
+	}), std::runtime_error);
+	CHECK(total == 10); // other tasks still executed
+
+	// pool is still usable afterwards
+	total = 0;
+	pool.run(10, [&](size_t) { ++total; });
+	CHECK(total == 10);
+}
@@ -0,0 +1,218 @@
+#include "catch.hpp"
+#include "ZMBVEncoder.hh"
+#include "FileOperations.hh"
+#include "PNG.hh"
+#include "SDLSurfacePtr.hh"
+#include "endian.hh"
+#include "enumerate.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+#include <zlib.h>
+
+using namespace openmsx;
+using Pixel = ZMBVEncoder::Pixel;
+
+// Minimal ZMBV decoder (only what ZMBVEncoder produces: 32bpp, 16x16 blocks).
+// Output pixels are in the format of the AVI file (0x00RRGGBB).
+class Decoder
+{
+public:
+	Decoder(unsigned width_, unsigned height_)
+		: width(width_), height(height_)
+		, frame(size_t(width) * height), prev(size_t(width) * height)
+		, buf(size_t(width) * height * 4 + 4096)
+	{
+		inflateInit(&zstream);
+	}
+	~Decoder() { inflateEnd(&zstream); }
+
+	std::span<const uint32_t> decode(std::span<const uint8_t> data)
+	{
+		REQUIRE(!data.empty());
+		bool keyFrame = data[0] & 1;
+		size_t pos = 1;
+		if (keyFrame) {
+			REQUIRE(data.size() >= 7);
+			CHECK(data[3] == 1);  // zlib
+			CHECK(data[4] == 8);  // 32bpp
+			CHECK(data[5] == 16); // block width
+			CHECK(data[6] == 16); // block height
+			pos += 6;
+			inflateReset(&zstream);
+		}
+		zstream.next_in = const_cast<uint8_t*>(data.data() + pos);
+		zstream.avail_in = narrow<unsigned>(data.size() - pos);
+		zstream.next_out = buf.data();
+		zstream.avail_out = narrow<unsigned>(buf.size());
+		zstream.total_out = 0;
+		REQUIRE(inflate(&zstream, Z_SYNC_FLUSH) == Z_OK);
+		const uint8_t* in = buf.data();
+
+		std::swap(frame, prev);
+		if (keyFrame) {
+			for (auto& p : frame) {
+				p = Endian::read_UA_L32(in);
+				in += 4;
+			}
+		} else {
+			unsigned xBlocks = width / 16;
+			unsigned yBlocks = height / 16;
+			const auto* vectors = reinterpret_cast<const int8_t*>(in);
+			in += (xBlocks * yBlocks * 2 + 3) & ~3;
+			for (auto by : xrange(yBlocks)) {
+				for (auto bx : xrange(xBlocks)) {
+					auto b = by * xBlocks + bx;
+					int vx = vectors[2 * b + 0] >> 1;
+					int vy = vectors[2 * b + 1] >> 1;
+					bool hasXor = vectors[2 * b + 0] & 1;
+					for (auto y : xrange(16u)) {
+						for (auto x : xrange(16u)) {
+							int dx = int(bx * 16 + x);
+							int dy = int(by * 16 + y);
+							int sx = dx + vx;
+							int sy = dy + vy;
+							uint32_t p = ((0 <= sx) && (sx < int(width)) && (0 <= sy) && (sy < int(height)))
+							           ? prev[sy * width + sx] : 0;
+							if (hasXor) {
+								p ^= Endian::read_UA_L32(in);
+								in += 4;
+							}
+							frame[dy * width + dx] = p;
+						}
+					}
+				}
+			}
+		}
+		CHECK(size_t(in - buf.data()) == zstream.total_out);
+		return frame;
+	}
+
+private:
+	unsigned width, height;
+	std::vector<uint32_t> frame, prev;
+	std::vector<uint8_t> buf;
+	z_stream zstream = {};
+};
+
+// A scrolling background with some moving objects and a bit of noise.
+static std::vector<std::vector<Pixel>> createTestFrames(unsigned width, unsigned height, int num)
+{
+	std::mt19937 gen(1234);
+	std::vector<std::vector<Pixel>> result;
+	for (auto f : xrange(num)) {
+		auto& frame = result.emplace_back(size_t(width) * height);
+		for (auto y : xrange(height)) {
+			for (auto x : xrange(width)) {
+				auto sx = x + 2 * f;
+				frame[y * width + x] = 0xFF000000 | (((sx / 8 + y / 8) & 1) ? 0x204080 : 0x806040);
+			}
+		}
+		for (auto obj : xrange(5)) {
+			unsigned ox = (obj * 57 + f * (obj + 1) * 3) % (width - 16);
+			unsigned oy = (obj * 41 + f * (5 - obj)) % (height - 16);
+			for (auto y : xrange(16u)) {
+				for (auto x : xrange(16u)) {
+					frame[(oy + y) * width + (ox + x)] = 0xFF000000 | (obj * 0x332211 + x * y);
+				}
+			}
+		}
+		repeat(20, [&] { frame[gen() % frame.size()] = gen() | 0xFF000000; });
+	}
+	return result;
+}
+
+static uint32_t toAvi(Pixel p)
+{
+	return ((p & 0xFF) << 16) | (p & 0xFF00) | ((p >> 16) & 0xFF);
+}
+
+TEST_CASE("ZMBVEncoder: decoded frames equal the input")
+{
+	static constexpr unsigned W = 320, H = 240;
+	auto frames = createTestFrames(W, H, 12);
+	ZMBVEncoder encoder(W, H, 2);
+	Decoder decoder(W, H);
+	for (auto [i, frame] : enumerate(frames)) {
+		bool keyFrame = (i % 5) == 0;
+		auto decoded = decoder.decode(encoder.compressFrame(keyFrame, frame));
+		for (auto j : xrange(frame.size())) {
+			CHECK(decoded[j] == toAvi(frame[j]));
+		}
+	}
+}
+
+TEST_CASE("ZMBVEncoder: same output for any number of threads")
+{
+	static constexpr unsigned W = 320, H = 240;
+	auto frames = createTestFrames(W, H, 8);
+	auto encode = [&](unsigned numWorkers) {
+		ZMBVEncoder encoder(W, H, numWorkers);
+		std::vector<std::vector<uint8_t>> result;
+		for (auto [i, frame] : enumerate(frames)) {
+			auto data = encoder.compressFrame(i == 0, frame);
+			result.emplace_back(data.begin(), data.end());
+		}
+		return result;
+	};
+	auto expected = encode(0);
+	CHECK(encode(1) == expected);
+	CHECK(encode(3) == expected);
+}
+
+// Not a real test, but a benchmark of the encoder. It is not run by default,
+// run it with:
+//    unittest "[benchmark]"
+//
+// It uses the frames in OPENMSX_ZMBV_FRAMES<NNNN>.png (starting at 0001),
+// e.g. a sequence of consecutive frames saved in openMSX with:
+//    proc bench_shot {n} {
+//        screenshot -raw -prefix bench
+//        if {$n > 1} {after frame [list bench_shot [expr {$n - 1}]]}
+//    }
+//    bench_shot 300
+// or run it on generated frames when that environment variable isn't set.
+TEST_CASE("ZMBVEncoder benchmark", "[.][benchmark]")
+{
+	unsigned width = 320, height = 240;
+	std::vector<std::vector<Pixel>> frames;
+	if (const char* prefix = getenv("OPENMSX_ZMBV_FRAMES")) {
+		for (int n = 1; /**/; ++n) {
+			std::ostringstream os;
+			os << prefix << std::setw(4) << std::setfill('0') << n << ".png";
+			if (!FileOperations::exists(os.str())) break;
+			auto surface = PNG::load(os.str(), true);
+			width  = narrow<unsigned>(surface->w & ~15);
+			height = narrow<unsigned>(surface->h & ~15);
+			if (!frames.empty() && (frames[0].size() != size_t(width) * height)) break;
+			auto& frame = frames.emplace_back(size_t(width) * height);
+			for (auto y : xrange(height)) {
+				const auto* line = reinterpret_cast<const Pixel*>(
+					static_cast<const uint8_t*>(surface->pixels) + y * surface->pitch);
+				std::copy_n(line, width, &frame[y * width]);
+			}
+		}
+	}
+	if (frames.empty()) frames = createTestFrames(width, height, 300);
+
+	for (unsigned numWorkers : {0, 1, 3}) {
+		ZMBVEncoder encoder(width, height, numWorkers);
+		size_t totalSize = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (auto [i, frame] : enumerate(frames)) {
+			totalSize += encoder.compressFrame((i % 300) == 0, frame).size();
+		}
+		auto stop = std::chrono::steady_clock::now();
+		auto ms = std::chrono::duration<double, std::milli>(stop - start).count();
+		std::cout << frames.size() << " frames " << width << 'x' << height
+		          << ", " << numWorkers << " workers: " << ms << "ms, "
+		          << totalSize << " bytes\n";
+	}
+}
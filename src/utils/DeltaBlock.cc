@@ -252,6 +252,7 @@ DeltaBlock::~DeltaBlock()
 
 DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
 	: block(data.size())
+	, uncompressedSize(data.size())
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data);
@@ -268,6 +269,7 @@ DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
 
 void DeltaBlockCopy::apply(std::span<uint8_t> dst) const
 {
+	std::scoped_lock lock(mutex);
 	if (compressed()) {
 		LZ4::decompress(block.data(), dst.data(), int(compressedSize), int(dst.size()));
 	} else {
@@ -278,8 +280,17 @@ void DeltaBlockCopy::apply(std::span<uint8_t> dst) const
 #endif
 }
 
+size_t DeltaBlockCopy::getMemorySize() const
+{
+	std::scoped_lock lock(mutex);
+	return compressed() ? compressedSize : uncompressedSize;
+}
+
 void DeltaBlockCopy::compress(size_t size)
 {
+	// Only compress() itself modifies 'block', and it's never called
+	// concurrently for the same object. So reading 'block' doesn't
+	// require the lock, only modifying it does.
 	if (compressed()) return;
 
 	size_t dstLen = LZ4::compressBound(int(size));
@@ -290,10 +301,13 @@ void DeltaBlockCopy::compress(size_t size)
 		// compression isn't beneficial
 		return;
 	}
-	compressedSize = dstLen;
-	block.swap(buf2);
-	block.resize(compressedSize); // shrink to fit
-	assert(compressed());
+	{
+		std::scoped_lock lock(mutex);
+		compressedSize = dstLen;
+		block.swap(buf2);
+		block.resize(compressedSize); // shrink to fit
+		assert(compressed());
+	}
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
 	apply({buf3.data(), size});
@@ -347,6 +361,11 @@ void DeltaBlockDiff::apply(std::span<uint8_t> dst) const
 #endif
 }
 
+size_t DeltaBlockDiff::getMemorySize() const
+{
+	return delta.size();
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
 	return delta.size();
@@ -373,7 +392,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		if (ref) {
 			// We will switch to a new DeltaBlockCopy object. So
 			// now is a good time to compress the old one.
-			ref->compress(size);
+			compressLater(std::move(ref), size);
 		}
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
@@ -422,10 +441,54 @@ void LastDeltaBlocks::clear()
 {
 	for (const Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
-			ref->compress(info.size);
+			compressLater(std::move(ref), info.size);
 		}
 	}
 	infos.clear();
 }
 
+LastDeltaBlocks::~LastDeltaBlocks()
+{
+	if (!compressThread.joinable()) return;
+	{
+		std::scoped_lock lock(compressMutex);
+		exitCompressor = true;
+	}
+	compressCond.notify_one();
+	compressThread.join();
+}
+
+void LastDeltaBlocks::compressLater(std::shared_ptr<DeltaBlockCopy> block, size_t size)
+{
+	{
+		std::scoped_lock lock(compressMutex);
+		compressQueue.emplace_back(std::move(block), size);
+	}
+	if (!compressThread.joinable()) {
+		compressThread = std::thread([this]() { compressLoop(); });
+	}
+	compressCond.notify_one();
+}
+
+void LastDeltaBlocks::compressLoop()
+{
+	std::unique_lock lock(compressMutex);
+	while (true) {
+		compressCond.wait(lock, [&] { return exitCompressor || !compressQueue.empty(); });
+		// On exit, drop the remaining blocks (they're still correct,
+		// just not compressed).
+		if (exitCompressor) return;
+
+		auto [block, size] = std::move(compressQueue.front());
+		compressQueue.pop_front();
+		lock.unlock();
+		// Compressing is pointless when this was the last reference.
+		if (block.use_count() > 1) {
+			block->compress(size);
+		}
+		block.reset(); // release outside the lock
+		lock.lock();
+	}
+}
+
 } // namespace openmsx
@@ -4,9 +4,14 @@
 #define STATISTICS 0
 
 #include "MemBuffer.hh"
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <span>
+#include <thread>
+#include <utility>
 #include <vector>
 #ifdef DEBUG
 #include "sha1.hh"
@@ -24,6 +29,12 @@ public:
 #endif
 	virtual void apply(std::span<uint8_t> dst) const = 0;
 
+	// Number of bytes of heap memory owned by this block (excluding
+	// blocks it refers to, see getReference()).
+	[[nodiscard]] virtual size_t getMemorySize() const = 0;
+	// Other block this one depends on, or nullptr.
+	[[nodiscard]] virtual const DeltaBlock* getReference() const { return nullptr; }
+
 protected:
 	DeltaBlock() = default;
 
@@ -45,13 +56,19 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	DeltaBlockCopy(std::span<const uint8_t> data);
 	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getMemorySize() const override;
 	void compress(size_t size);
 	[[nodiscard]] const uint8_t* getData();
 
 private:
 	[[nodiscard]] bool compressed() const { return compressedSize != 0; }
 
+	// compress() may run in a background thread (see LastDeltaBlocks),
+	// this protects 'block' and 'compressedSize' against a concurrent
+	// apply().
+	mutable std::mutex mutex;
 	MemBuffer<uint8_t> block;
+	const size_t uncompressedSize;
 	size_t compressedSize = 0;
 };
 
@@ -62,6 +79,8 @@ public:
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
 	               std::span<const uint8_t> data);
 	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getMemorySize() const override;
+	[[nodiscard]] const DeltaBlock* getReference() const override { return prev.get(); }
 	[[nodiscard]] size_t getDeltaSize() const;
 
 private:
@@ -73,6 +92,9 @@ private:
 class LastDeltaBlocks
 {
 public:
+	LastDeltaBlocks() = default;
+	~LastDeltaBlocks();
+
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNew(
 		const void* id, std::span<const uint8_t> data);
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNullDiff(
@@ -80,6 +102,12 @@ public:
 	void clear();
 
 private:
+	// A DeltaBlockCopy that's no longer used as reference for new diffs
+	// gets compressed. That's done in a background thread, so that
+	// taking a snapshot doesn't stall the emulation thread.
+	void compressLater(std::shared_ptr<DeltaBlockCopy> block, size_t size);
+	void compressLoop();
+
 	struct Info {
 		Info(const void* id_, size_t size_)
 			: id(id_), size(size_) {}
@@ -92,6 +120,12 @@ private:
 	};
 
 	std::vector<Info> infos;
+
+	std::mutex compressMutex; // protects the 3 members below
+	std::condition_variable compressCond;
+	std::deque<std::pair<std::shared_ptr<DeltaBlockCopy>, size_t>> compressQueue;
+	bool exitCompressor = false;
+	std::thread compressThread; // started on first use
 };
 
 } // namespace openmsx
@@ -0,0 +1,60 @@
+#ifndef LFSRJUMP_HH
+#define LFSRJUMP_HH
+
+#include <array>
+#include <cstdint>
+
+/** Advance a linear feedback shift register by many steps at once.
+ *
+ * More generally this works for any step function that is a linear map over
+ * GF(2) on (at most) 32 bits, e.g. both the Galois and the Fibonacci form of
+ * an LFSR. Such a map is a 32x32 bit matrix, this class precalculates the
+ * matrices for 2^k steps (k = 0..31). Advancing 'n' steps then takes at most
+ * 32 matrix-vector multiplications instead of 'n' single steps.
+ *
+ * An affine step function (e.g. a shift register with XNOR feedback) can be
+ * made linear by adding an extra state bit that's always 1.
+ */
+class LFSRJump
+{
+public:
+	/** 'step' must be linear: step(a ^ b) == step(a) ^ step(b). */
+	template<typename Step>
+	constexpr explicit LFSRJump(Step step)
+	{
+		for (int i = 0; i < 32; ++i) {
+			pow2[0][i] = step(uint32_t(1) << i);
+		}
+		for (int k = 1; k < 32; ++k) {
+			for (int i = 0; i < 32; ++i) {
+				pow2[k][i] = apply(pow2[k - 1], pow2[k - 1][i]);
+			}
+		}
+	}
+
+	/** Same result as applying 'step' 'n' times to 'state'. */
+	[[nodiscard]] constexpr uint32_t advance(uint32_t state, uint32_t n) const
+	{
+		for (int k = 0; n; ++k, n >>= 1) {
+			if (n & 1) state = apply(pow2[k], state);
+		}
+		return state;
+	}
+
+private:
+	using Matrix = std::array<uint32_t, 32>; // column 'i' is the image of bit 'i'
+
+	[[nodiscard]] static constexpr uint32_t apply(const Matrix& m, uint32_t x)
+	{
+		uint32_t result = 0;
+		for (int i = 0; x; ++i, x >>= 1) {
+			if (x & 1) result ^= m[i];
+		}
+		return result;
+	}
+
+private:
+	std::array<Matrix, 32> pow2 = {}; // matrix for 2^k steps
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <concepts>
 #include <cstdint>
 #include <numbers>
+#include <optional>
 #include <span>
 
 #ifdef _MSC_VER
@@ -201,6 +202,28 @@ constexpr int mod_floor(int dividend, int divisor) {
     return div_mod_floor(dividend, divisor).remainder;
 }
 
+/** Returns the smallest 'x >= 0' for which '(a * x) % m' lies in the range
+  * [lo, hi], or std::nullopt if there's no such 'x'.
+  * Requires 'a < m' and 'lo <= hi < m'. This is a variant of Euclid's
+  * algorithm, it takes O(log(m)) steps.
+  */
+[[nodiscard]] constexpr std::optional<uint64_t> firstMultipleInRange(
+	uint64_t a, uint64_t m, uint64_t lo, uint64_t hi)
+{
+	assert(a < m);
+	assert(lo <= hi);
+	assert(hi < m);
+	if (lo == 0) return 0;
+	if (a == 0) return {};
+	if (auto x = (lo + a - 1) / a; a * x <= hi) return x; // no wrapping needed
+	// [lo, hi] doesn't contain a multiple of 'a'. Search the smallest 'y'
+	// for which [lo + m*y, hi + m*y] does, that's a similar problem but
+	// with smaller numbers.
+	auto y = firstMultipleInRange(m % a, a, a - (hi % a), a - (lo % a));
+	if (!y) return {};
+	return (lo + m * *y + a - 1) / a;
+}
+
 } // namespace Math
 
 #endif // MATH_HH
@@ -4,9 +4,15 @@
 #include "MemBuffer.hh"
 #include "ranges.hh"
 #include "ScopedAssign.hh"
+#include "WorkerPool.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstring>
 #include <map>
 #include <span>
+#include <thread>
 
 namespace openmsx {
 
@@ -23,6 +29,19 @@ struct TTCacheEntry
 // inserted. So still use std::map instead of std::vector.
 static std::map<std::pair<size_t, std::string>, TTCacheEntry> ttCache;
 
+// Header of the buffer produced by saveCache(). It's followed by the name and
+// then, for each stored node, a 'valid' byte and the hash value. This is only
+// meant as a local cache, so it's fine to use the native byte order.
+struct TTCacheHeader
+{
+	std::array<char, 8> magic;
+	uint64_t dataSize;
+	int64_t time;
+	uint64_t nameSize;
+};
+static constexpr std::array<char, 8> TT_CACHE_MAGIC = {'o', 'M', 'S', 'X', 'T', 'T', 'H', '1'};
+static constexpr size_t TT_CACHE_NODE_SIZE = 1 + sizeof(TigerHash);
+
 [[nodiscard]] static constexpr size_t calcNumNodes(size_t dataSize)
 {
 	auto numBlocks = (dataSize + TigerTree::BLOCK_SIZE - 1) / TigerTree::BLOCK_SIZE;
@@ -44,43 +63,16 @@ static std::map<std::pair<size_t, std::string>, TTCacheEntry> ttCache;
 	return result;
 }
 
-TigerTree::TigerTree(TTData& data_, size_t dataSize_, const std::string& name)
+TigerTree::TigerTree(TTData& data_, size_t dataSize_, const std::string& name_)
 	: data(data_)
 	, dataSize(dataSize_)
+	, name(name_)
 	, entry(getCacheEntry(data, dataSize, name))
 {
 }
 
-const TigerHash& TigerTree::calcHash(const std::function<void(size_t, size_t)>& progressCallback)
-{
-	return calcHash(getTop(), progressCallback);
-}
-
-void TigerTree::notifyChange(size_t offset, size_t len, time_t time)
-{
-	entry.time = time;
-
-	assert((offset + len) <= dataSize);
-	if (len == 0) return;
-
-	if (entry.valid[getTop().n]) {
-		entry.valid[getTop().n] = false; // set sentinel
-		entry.numNodesValid--;
-	}
-	auto first = offset / BLOCK_SIZE;
-	auto last = (offset + len - 1) / BLOCK_SIZE;
-	assert(first <= last); // requires len != 0
-	do {
-		auto node = getLeaf(first);
-		while (entry.valid[node.n]) {
-			entry.valid[node.n] = false;
-			entry.numNodesValid--;
-			node = getParent(node);
-		}
-	} while (++first <= last);
-}
-
-const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t, size_t)>& progressCallback)
+template<typename GetData, typename Progress>
+const TigerHash& TigerTree::calcHash(Node node, GetData getData, Progress progress)
 {
 	auto n = node.n;
 	if (!entry.valid[n]) {
@@ -88,8 +80,8 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 			// interior node
 			auto left  = getLeftChild (node);
 			auto right = getRightChild(node);
-			const auto& h1 = calcHash(left, progressCallback);
-			const auto& h2 = calcHash(right, progressCallback);
+			const auto& h1 = calcHash(left, getData, progress);
+			const auto& h2 = calcHash(right, getData, progress);
 			tiger_int(h1, h2, entry.hash[n]);
 		} else {
 			// leaf node
@@ -97,22 +89,171 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 			size_t l = dataSize - b;
 
 			if (l >= BLOCK_SIZE) {
-				auto* d = data.getData(b, BLOCK_SIZE);
+				auto* d = getData(b, BLOCK_SIZE);
 				tiger_leaf(std::span{d, BLOCK_SIZE}, entry.hash[n]);
 			} else {
 				// partial last block
-				auto* d = data.getData(b, l);
+				auto* d = getData(b, l);
 				auto sa = ScopedAssign(d[-1], uint8_t(0));
 				tiger(std::span{d - 1, l + 1}, entry.hash[n]);
 			}
 		}
 		entry.valid[n] = true;
-		entry.numNodesValid++;
+		progress();
+	}
+	return entry.hash[n];
+}
+
+const TigerHash& TigerTree::calcHash(const std::function<void(size_t, size_t)>& progressCallback)
+{
+	calcSubtrees(progressCallback);
+	return calcHash(
+		getTop(),
+		[&](size_t offset, size_t size) { return data.getData(offset, size); },
+		[&] {
+			entry.numNodesValid++;
+			if (progressCallback) {
+				progressCallback(entry.numNodesValid, entry.numNodes);
+			}
+		});
+}
+
+// Calculate all (complete) subtrees of SUBTREE_BLOCKS blocks that are not yet
+// valid, in parallel. TTData is not thread-safe, so the data is first fetched
+// (sequentially) into a buffer per subtree, and then those are hashed in
+// parallel.
+void TigerTree::calcSubtrees(const std::function<void(size_t, size_t)>& progressCallback)
+{
+	std::vector<Node> todo;
+	static constexpr size_t L = SUBTREE_BLOCKS;
+	for (size_t n = L - 1; (n + L - 1) < entry.numNodes; n += 2 * L) {
+		if (!entry.valid[n]) todo.emplace_back(n, L);
+	}
+	auto numThreads = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+	if ((numThreads == 1) || (todo.size() < 2)) return;
+
+	WorkerPool workerPool(numThreads - 1);
+	size_t batchSize = 4 * numThreads;
+	// one extra byte in front of each subtree, see TTData::getData()
+	static constexpr size_t STRIDE = L * BLOCK_SIZE + 1;
+	MemBuffer<uint8_t> buffer(batchSize * STRIDE);
+	std::vector<size_t> counts(batchSize);
+	for (size_t first = 0; first < todo.size(); first += batchSize) {
+		auto num = std::min(batchSize, todo.size() - first);
+		for (auto i : xrange(num)) {
+			auto* dst = &buffer[i * STRIDE + 1];
+			size_t offset = (todo[first + i].n - (L - 1)) * (BLOCK_SIZE / 2);
+			for (size_t b = 0; b < (L * BLOCK_SIZE); b += BLOCK_SIZE) {
+				auto size = std::min(BLOCK_SIZE, dataSize - (offset + b));
+				memcpy(dst + b, data.getData(offset + b, size), size);
+			}
+		}
+		workerPool.run(num, [&](size_t i) {
+			auto* base = &buffer[i * STRIDE + 1];
+			size_t offset = (todo[first + i].n - (L - 1)) * (BLOCK_SIZE / 2);
+			size_t count = 0;
+			calcHash(todo[first + i],
+			         [&](size_t o, size_t /*size*/) { return base + (o - offset); },
+			         [&] { ++count; });
+			counts[i] = count;
+		});
+		for (auto i : xrange(num)) entry.numNodesValid += counts[i];
 		if (progressCallback) {
 			progressCallback(entry.numNodesValid, entry.numNodes);
 		}
 	}
-	return entry.hash[n];
+}
+
+void TigerTree::notifyChange(size_t offset, size_t len, time_t time)
+{
+	entry.time = time;
+
+	assert((offset + len) <= dataSize);
+	if (len == 0) return;
+
+	auto invalidate = [&](Node node) {
+		if (entry.valid[node.n]) {
+			entry.valid[node.n] = false;
+			entry.numNodesValid--;
+		}
+	};
+	auto top = getTop();
+	invalidate(top); // set sentinel
+	auto first = offset / BLOCK_SIZE;
+	auto last = (offset + len - 1) / BLOCK_SIZE;
+	assert(first <= last); // requires len != 0
+	do {
+		auto node = getLeaf(first);
+		// After loadCache() the nodes below SUBTREE_BLOCKS are invalid
+		// while their parents are valid. So only above that level we can
+		// stop at the first invalid node.
+		while ((node.l < SUBTREE_BLOCKS) && (node.n != top.n)) {
+			invalidate(node);
+			node = getParent(node);
+		}
+		while (entry.valid[node.n]) {
+			invalidate(node);
+			node = getParent(node);
+		}
+	} while (++first <= last);
+}
+
+time_t TigerTree::getTime() const
+{
+	return entry.time;
+}
+
+std::vector<uint8_t> TigerTree::saveCache() const
+{
+	static constexpr size_t L = SUBTREE_BLOCKS;
+	size_t numValid = 0;
+	for (size_t n = L - 1; n < entry.numNodes; n += L) {
+		numValid += entry.valid[n];
+	}
+	if (numValid == 0) return {};
+
+	TTCacheHeader header = {TT_CACHE_MAGIC, dataSize, int64_t(entry.time), name.size()};
+	std::vector<uint8_t> result(sizeof(header) + name.size());
+	memcpy(result.data(), &header, sizeof(header));
+	memcpy(result.data() + sizeof(header), name.data(), name.size());
+	for (size_t n = L - 1; n < entry.numNodes; n += L) {
+		result.push_back(entry.valid[n]);
+		const auto* h = entry.hash[n].h8.data();
+		result.insert(result.end(), h, h + sizeof(TigerHash));
+	}
+	return result;
+}
+
+bool TigerTree::loadCache(std::span<const uint8_t> buf)
+{
+	if (entry.numNodesValid != 0) return false;
+
+	TTCacheHeader header;
+	if (buf.size() < sizeof(header)) return false;
+	memcpy(&header, buf.data(), sizeof(header));
+	buf = buf.subspan(sizeof(header));
+	if ((header.magic != TT_CACHE_MAGIC) ||
+	    (header.dataSize != dataSize) ||
+	    (header.time != int64_t(entry.time)) ||
+	    (header.nameSize != name.size()) ||
+	    (buf.size() < name.size()) ||
+	    (memcmp(buf.data(), name.data(), name.size()) != 0)) {
+		return false;
+	}
+	buf = buf.subspan(name.size());
+
+	static constexpr size_t L = SUBTREE_BLOCKS;
+	size_t numStored = entry.numNodes / L;
+	if (buf.size() != (numStored * TT_CACHE_NODE_SIZE)) return false;
+	for (size_t n = L - 1; n < entry.numNodes; n += L) {
+		if (buf[0]) {
+			entry.valid[n] = true;
+			memcpy(entry.hash[n].h8.data(), &buf[1], sizeof(TigerHash));
+			entry.numNodesValid++;
+		}
+		buf = buf.subspan(TT_CACHE_NODE_SIZE);
+	}
+	return true;
 }
 
 
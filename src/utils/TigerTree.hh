@@ -32,6 +32,8 @@
 #include <cstdint>
 #include <ctime>
 #include <functional>
+#include <span>
+#include <vector>
 
 namespace openmsx {
 
@@ -74,6 +76,12 @@ class TigerTree
 public:
 	static constexpr size_t BLOCK_SIZE = 1024;
 
+	/** Number of blocks covered by the smallest subtrees that are stored
+	 * by saveCache(). This is also the granularity in which the hash
+	 * calculation is spread over multiple threads.
+	 */
+	static constexpr size_t SUBTREE_BLOCKS = 256;
+
 	/** Create TigerTree calculator for the given (abstract) data block
 	 * of given size.
 	 */
@@ -90,6 +98,25 @@ public:
 	 */
 	void notifyChange(size_t offset, size_t len, time_t time);
 
+	/** The (modification) time of the data the tree currently belongs
+	 * to, as given to the last notifyChange() or isCacheStillValid().
+	 */
+	[[nodiscard]] time_t getTime() const;
+
+	/** Serialize the already calculated part of the tree (only the nodes
+	 * that cover at least SUBTREE_BLOCKS blocks), so that it can be
+	 * restored in a later session with loadCache(). Returns an empty
+	 * buffer when there's nothing worth storing.
+	 */
+	[[nodiscard]] std::vector<uint8_t> saveCache() const;
+
+	/** Restore a tree that was stored with saveCache(). This is only done
+	 * when nothing is calculated yet and when the stored tree is for the
+	 * same data (same name, size and (modification) time).
+	 * @return true iff the stored tree was used.
+	 */
+	bool loadCache(std::span<const uint8_t> buf);
+
 private:
 	// functions to navigate in binary tree
 	struct Node {
@@ -103,11 +130,14 @@ private:
 	[[nodiscard]] Node getLeftChild(Node node) const;
 	[[nodiscard]] Node getRightChild(Node node) const;
 
-	[[nodiscard]] const TigerHash& calcHash(Node node, const std::function<void(size_t, size_t)>& progressCallback);
+	template<typename GetData, typename Progress>
+	const TigerHash& calcHash(Node node, GetData getData, Progress progress);
+	void calcSubtrees(const std::function<void(size_t, size_t)>& progressCallback);
 
 private:
 	TTData& data;
 	const size_t dataSize;
+	const std::string name;
 	TTCacheEntry& entry;
 };
 
@@ -8,21 +8,27 @@
 #include "CommandException.hh"
 #include "Display.hh"
 #include "PostProcessor.hh"
+#include "RenderSettings.hh"
+#include "SoftwareScaler.hh"
 #include "Math.hh"
 #include "MSXMixer.hh"
 #include "Filename.hh"
 #include "CliComm.hh"
 #include "FileOperations.hh"
+#include "FrameSource.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "enumerate.hh"
 #include "narrow.hh"
 #include "outer.hh"
+#include "ranges.hh"
+#include "unreachable.hh"
 #include "vla.hh"
 #include "xrange.hh"
 #include <array>
 #include <cassert>
 #include <memory>
+#include <utility>
 
 namespace openmsx {
 
@@ -39,7 +45,7 @@ AviRecorder::~AviRecorder()
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const Filename& filename)
+                        bool recordStereo, bool scaled, const Filename& filename)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -87,6 +93,11 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
 		}
+		if (scaled) {
+			scaler = std::make_unique<SoftwareScaler>(
+				SoftwareScaler::getDefaultNumWorkers());
+		}
+		startEncoder();
 	} else {
 		assert(recordAudio);
 		wavWriter = std::make_unique<Wav16Writer>(
@@ -110,10 +121,94 @@ void AviRecorder::stop()
 		mixer = nullptr;
 	}
 	sampleRate = 0;
+	stopEncoder(); // first write the remaining frames
 	aviWriter.reset();
+	scaler.reset();
 	wavWriter.reset();
 }
 
+void AviRecorder::startEncoder()
+{
+	assert(!encodeThread.joinable());
+	encodeQueue.clear();
+	freeFrames.clear();
+	repeat(NUM_VIDEO_FRAMES, [&] {
+		auto& f = freeFrames.emplace_back();
+		f.image.resize(size_t(frameWidth) * frameHeight);
+	});
+	encodeError.clear();
+	encodeFailed = false;
+	exitEncoder = false;
+	lateFrames = 0;
+	encodeThread = std::thread([this]() { encodeLoop(); });
+}
+
+void AviRecorder::stopEncoder()
+{
+	if (!encodeThread.joinable()) return;
+	{
+		std::scoped_lock lock(encodeMutex);
+		exitEncoder = true;
+	}
+	encodeCond.notify_one();
+	encodeThread.join();
+
+	if (!encodeError.empty()) {
+		reactor.getCliComm().printWarning(
+			"Recording stopped with error: ", encodeError);
+	}
+	encodeQueue.clear();
+	freeFrames.clear();
+}
+
+void AviRecorder::encodeLoop()
+{
+	std::unique_lock lock(encodeMutex);
+	while (true) {
+		encodeCond.wait(lock, [&] { return exitEncoder || !encodeQueue.empty(); });
+		// On exit, first finish the frames that are still queued.
+		if (encodeQueue.empty()) return;
+
+		auto frame = std::move(encodeQueue.front());
+		encodeQueue.pop_front();
+		if (!encodeFailed) {
+			lock.unlock();
+			// Only this thread accesses 'aviWriter' while the
+			// encoder is running.
+			std::string error;
+			try {
+				if (frame.fps != 0.0f) aviWriter->setFps(frame.fps);
+				aviWriter->addFrame(frame.image, frame.audio);
+			} catch (MSXException& e) {
+				error = e.getMessage();
+			}
+			lock.lock();
+			if (!error.empty()) {
+				encodeError = std::move(error);
+				encodeFailed = true;
+			}
+		}
+		freeFrames.push_back(std::move(frame));
+		freeCond.notify_one();
+	}
+}
+
+void AviRecorder::copyImage(FrameSource& frame, std::span<uint32_t> out) const
+{
+	for (auto y : xrange(frameHeight)) {
+		auto line = out.subspan(size_t(y) * frameWidth, frameWidth);
+		auto scaled = [&]() -> std::span<const uint32_t> {
+			switch (frameHeight) {
+			case 240: return frame.getLinePtr320_240(y, subspan<320>(line));
+			case 480: return frame.getLinePtr640_480(y, subspan<640>(line));
+			case 720: return frame.getLinePtr960_720(y, subspan<960>(line));
+			default: UNREACHABLE;
+			}
+		}();
+		if (scaled.data() != line.data()) ranges::copy(scaled, line);
+	}
+}
+
 static int16_t float2int16(float f)
 {
 	return Math::clipToInt16(lrintf(32768.0f * f));
@@ -175,6 +270,7 @@ void AviRecorder::addWave(std::span<const StereoFloat> data)
 void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 {
 	assert(!wavWriter);
+	float newFps = 0.0f; // (the encoder thread owns 'aviWriter')
 	if (duration != EmuDuration::infinity()) {
 		if (!warnedFps && ((time - prevTime) != duration)) {
 			warnedFps = true;
@@ -185,15 +281,45 @@ void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity()) {
 		duration = time - prevTime;
-		aviWriter->setFps(narrow_cast<float>(1.0 / duration.toDouble()));
+		newFps = narrow_cast<float>(1.0 / duration.toDouble());
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, audioBuf);
+
+	auto videoFrame = [&] {
+		std::unique_lock lock(encodeMutex);
+		if (freeFrames.empty() && !encodeFailed) {
+			++lateFrames;
+			freeCond.wait(lock, [&] { return !freeFrames.empty() || encodeFailed; });
+		}
+		if (encodeFailed) {
+			// report the error only once (the caller stops recording)
+			throw MSXException(std::exchange(encodeError, {}));
+		}
+		auto result = std::move(freeFrames.back());
+		freeFrames.pop_back();
+		return result;
+	}();
+
+	if (scaler) {
+		auto config = SoftwareScaler::getConfig(
+			reactor.getDisplay().getRenderSettings(), frameHeight / 240);
+		scaler->scaleImage(*frame, config, videoFrame.image);
+	} else {
+		copyImage(*frame, videoFrame.image);
+	}
+	std::swap(videoFrame.audio, audioBuf); // reuse the allocated buffers
 	audioBuf.clear();
+	videoFrame.fps = newFps;
+
+	{
+		std::scoped_lock lock(encodeMutex);
+		encodeQueue.push_back(std::move(videoFrame));
+	}
+	encodeCond.notify_one();
 }
 
 // TODO: Can this be dropped?
@@ -211,6 +337,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	bool recordStereo = false;
 	bool doubleSize   = false;
 	bool tripleSize   = false;
+	bool scaled       = false;
 	std::array info = {
 		valueArg("-prefix", prefix),
 		flagArg("-audioonly", audioOnly),
@@ -219,6 +346,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 		flagArg("-stereo",    recordStereo),
 		flagArg("-doublesize", doubleSize),
 		flagArg("-triplesize", tripleSize),
+		flagArg("-scaled",     scaled),
 	};
 	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
 
@@ -234,6 +362,9 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	if (videoOnly && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	if (audioOnly && scaled) {
+		throw CommandException("Can't have both -audioonly and -scaled.");
+	}
 	std::string_view filenameArg;
 	switch (arguments.size()) {
 	case 0:
@@ -265,7 +396,7 @@ void AviRecorder::processStart(Interpreter& interp, std::span<const TclObject> t
 	if (aviWriter || wavWriter) {
 		result = "Already recording.";
 	} else {
-		start(recordAudio, recordVideo, recordMono, recordStereo,
+		start(recordAudio, recordVideo, recordMono, recordStereo, scaled,
 				Filename(filename));
 		result = tmpStrCat("Recording to ", filename);
 	}
@@ -289,6 +420,12 @@ void AviRecorder::processToggle(Interpreter& interp, std::span<const TclObject>
 void AviRecorder::status(std::span<const TclObject> /*tokens*/, TclObject& result) const
 {
 	result.addDictKeyValue("status", (aviWriter || wavWriter) ? "recording" : "idle");
+	if (aviWriter) {
+		std::scoped_lock lock(encodeMutex);
+		result.addDictKeyValues("queued_frames", int(encodeQueue.size()),
+		                        "max_queued_frames", int(NUM_VIDEO_FRAMES),
+		                        "late_frames", int(lateFrames));
+	}
 }
 
 // class AviRecorder::Cmd
@@ -326,9 +463,11 @@ std::string AviRecorder::Cmd::help(std::span<const TclObject> /*tokens*/) const
 	       "record status             Query recording state\n"
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
-	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
+	       " -mono, -stereo, -doublesize, -triplesize, -scaled flag.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
-	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
+	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.\n"
+	       "With -scaled the video is scaled with the current scale_algorithm, "
+	       "scanline and blur settings (on the CPU) instead of just resized.";
 }
 
 void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
@@ -342,7 +481,7 @@ void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static constexpr std::array options = {
 			"-prefix"sv, "-videoonly"sv, "-audioonly"sv,
-			"-doublesize"sv, "-triplesize"sv,
+			"-doublesize"sv, "-triplesize"sv, "-scaled"sv,
 			"-mono"sv, "-stereo"sv,
 		};
 		completeFileName(tokens, userFileContext(), options);
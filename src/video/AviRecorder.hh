@@ -5,9 +5,14 @@
 #include "EmuDuration.hh"
 #include "EmuTime.hh"
 #include "Mixer.hh"
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <span>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace openmsx {
@@ -19,6 +24,7 @@ class Interpreter;
 class MSXMixer;
 class PostProcessor;
 class Reactor;
+class SoftwareScaler;
 class TclObject;
 class Wav16Writer;
 
@@ -35,9 +41,14 @@ public:
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const Filename& filename);
+		   bool recordStereo, bool scaled, const Filename& filename);
 	void status(std::span<const TclObject> tokens, TclObject& result) const;
 
+	void copyImage(FrameSource& frame, std::span<uint32_t> out) const;
+	void startEncoder();
+	void stopEncoder();
+	void encodeLoop();
+
 	void processStart (Interpreter& interp, std::span<const TclObject> tokens, TclObject& result);
 	void processStop  (std::span<const TclObject> tokens);
 	void processToggle(Interpreter& interp, std::span<const TclObject> tokens, TclObject& result);
@@ -56,6 +67,7 @@ private:
 	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
 	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
+	std::unique_ptr<SoftwareScaler> scaler; // only for 'record start -scaled'
 	MSXMixer* mixer = nullptr;
 	EmuDuration duration = EmuDuration::infinity();
 	EmuTime prevTime = EmuTime::infinity();
@@ -66,6 +78,27 @@ private:
 	bool warnedSampleRate;
 	bool warnedStereo;
 	bool stereo;
+
+	// Compressing and writing the video frames is done in a background
+	// thread. addImage() copies (or scales) the frame into one of a fixed
+	// number of preallocated buffers and queues it. When all buffers are
+	// in use the emulation thread has to wait for the encoder.
+	struct VideoFrame {
+		std::vector<uint32_t> image; // frameWidth x frameHeight pixels
+		std::vector<int16_t> audio;
+		float fps = 0.0f; // when non-zero, (re)set the frame rate
+	};
+	static constexpr unsigned NUM_VIDEO_FRAMES = 8;
+	mutable std::mutex encodeMutex; // protects the members below
+	std::condition_variable encodeCond; // new frame queued or exit requested
+	std::condition_variable freeCond;   // buffer returned to 'freeFrames'
+	std::deque<VideoFrame> encodeQueue;
+	std::vector<VideoFrame> freeFrames;
+	std::string encodeError; // not yet reported error from the encoder
+	bool encodeFailed = false; // after an error, frames are discarded
+	bool exitEncoder = false;
+	unsigned lateFrames = 0; // number of times addImage() had to wait
+	std::thread encodeThread;
 };
 
 } // namespace openmsx
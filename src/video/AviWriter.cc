@@ -23,7 +23,7 @@ static constexpr unsigned AVI_HEADER_SIZE = 500;
 AviWriter::AviWriter(const Filename& filename, unsigned width_,
                      unsigned height_, unsigned channels_, unsigned freq_)
 	: file(filename, "wb")
-	, codec(width_, height_)
+	, codec(width_, height_, ZMBVEncoder::getDefaultNumWorkers())
 	, width(width_)
 	, height(height_)
 	, channels(channels_)
@@ -271,7 +271,7 @@ void AviWriter::addAviChunk(std::span<const char, 4> tag, size_t size_, const vo
 	index[idxSize + 3] = size;
 }
 
-void AviWriter::addFrame(FrameSource* video, std::span<const int16_t> audio)
+void AviWriter::addFrame(std::span<const uint32_t> video, std::span<const int16_t> audio)
 {
 	bool keyFrame = (frames++ % 300 == 0);
 	auto buffer = codec.compressFrame(keyFrame, video);
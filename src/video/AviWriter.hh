@@ -13,7 +13,6 @@
 namespace openmsx {
 
 class Filename;
-class FrameSource;
 
 class AviWriter
 {
@@ -21,7 +20,9 @@ public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned channels, unsigned freq);
 	~AviWriter();
-	void addFrame(FrameSource* video, std::span<const int16_t> audio);
+	/** Add an image of 'width x height' pixels (lines stored consecutively)
+	  * plus the audio that belongs to it. */
+	void addFrame(std::span<const uint32_t> video, std::span<const int16_t> audio);
 	void setFps(float fps_) { fps = fps_; }
 
 private:
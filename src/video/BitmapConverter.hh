@@ -80,6 +80,16 @@ public:
 		dPaletteValid = false;
 	}
 
+	/** Bring the (lazily calculated) internal tables up-to-date.
+	  * After this convertLine() and convertLinePlanar() don't modify this
+	  * object anymore, so (as long as the palette doesn't change) they can
+	  * be called from multiple threads at the same time.
+	  */
+	inline void updateTables()
+	{
+		if (!dPaletteValid) calcDPalette();
+	}
+
 private:
 	void calcDPalette();
 
@@ -392,12 +392,16 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 	bool rawShot = false;
 	bool msxOnly = false;
 	bool doubleSize = false;
+	bool tripleSize = false;
+	bool scaled = false;
 	bool withOsd = false;
 	std::array info = {
 		valueArg("-prefix", prefix),
 		flagArg("-raw", rawShot),
 		flagArg("-msxonly", msxOnly),
 		flagArg("-doublesize", doubleSize),
+		flagArg("-triplesize", tripleSize),
+		flagArg("-scaled", scaled),
 		flagArg("-with-osd", withOsd)
 	};
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
@@ -410,9 +414,13 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 			"-raw option for the same effect.");
 		rawShot = true;
 	}
-	if (doubleSize && !rawShot) {
-		throw CommandException("-doublesize option can only be used in "
-		                       "combination with -raw");
+	if ((doubleSize || tripleSize || scaled) && !rawShot) {
+		throw CommandException("-doublesize, -triplesize and -scaled "
+		                       "options can only be used in combination "
+		                       "with -raw");
+	}
+	if (doubleSize && tripleSize) {
+		throw CommandException("Can't have both -doublesize and -triplesize.");
 	}
 	if (rawShot && withOsd) {
 		throw CommandException("-with-osd cannot be used in "
@@ -448,9 +456,9 @@ void Display::ScreenShotCmd::execute(std::span<const TclObject> tokens, TclObjec
 			throw CommandException(
 				"Current renderer doesn't support taking screenshots.");
 		}
-		unsigned height = doubleSize ? 480 : 240;
+		unsigned height = doubleSize ? 480 : tripleSize ? 720 : 240;
 		try {
-			videoLayer->takeRawScreenShot(height, filename);
+			videoLayer->takeRawScreenShot(height, filename, scaled);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
@@ -471,6 +479,8 @@ string Display::ScreenShotCmd::help(std::span<const TclObject> /*tokens*/) const
 	       "screenshot -prefix foo       Write screenshot to file \"fooNNNN.png\"\n"
 	       "screenshot -raw              320x240 raw screenshot (of MSX screen only)\n"
 	       "screenshot -raw -doublesize  640x480 raw screenshot (of MSX screen only)\n"
+	       "screenshot -raw -triplesize  960x720 raw screenshot (of MSX screen only)\n"
+	       "screenshot -raw -scaled      Apply the current scale_algorithm to the raw screenshot\n"
 	       "screenshot -with-osd         Include OSD elements in the screenshot\n"
 	       "screenshot -no-sprites       Don't include sprites in the screenshot\n"
 	       "screenshot -guess-name       Guess the name of the running software and use it as prefix\n";
@@ -480,7 +490,8 @@ void Display::ScreenShotCmd::tabCompletion(std::vector<string>& tokens) const
 {
 	using namespace std::literals;
 	static constexpr std::array extra = {
-		"-prefix"sv, "-raw"sv, "-doublesize"sv, "-with-osd"sv, "-no-sprites"sv, "-guess-name"sv,
+		"-prefix"sv, "-raw"sv, "-doublesize"sv, "-triplesize"sv, "-scaled"sv,
+		"-with-osd"sv, "-no-sprites"sv, "-guess-name"sv,
 	};
 	completeFileName(tokens, userFileContext(), extra);
 }
@@ -19,6 +19,7 @@
 #include "RawFrame.hh"
 #include "Reactor.hh"
 #include "RenderSettings.hh"
+#include "SoftwareScaler.hh"
 #include "SuperImposedFrame.hh"
 #include "aligned.hh"
 #include "gl_transform.hh"
@@ -133,7 +134,7 @@ static void getScaledFrame(FrameSource& paintFrame,
                            WorkBuffer& workBuffer)
 {
 	auto height = narrow<unsigned>(lines.size());
-	unsigned width = (height == 240) ? 320 : 640;
+	unsigned width = (height / 3) * 4;
 	unsigned pitch = width * 4;
 	const void* linePtr = nullptr;
 	void* work = nullptr;
@@ -147,26 +148,39 @@ static void getScaledFrame(FrameSource& paintFrame,
 		if (height == 240) {
 			auto line = paintFrame.getLinePtr320_240(i, std::span<uint32_t, 320>{work2, 320});
 			linePtr = line.data();
-		} else {
-			assert (height == 480);
+		} else if (height == 480) {
 			auto line = paintFrame.getLinePtr640_480(i, std::span<uint32_t, 640>{work2, 640});
 			linePtr = line.data();
+		} else {
+			assert (height == 720);
+			auto line = paintFrame.getLinePtr960_720(i, std::span<uint32_t, 960>{work2, 960});
+			linePtr = line.data();
 		}
 		lines[i] = linePtr;
 	}
 }
 
-void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
+void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename, bool scaled)
 {
 	if (!paintFrame) {
 		throw CommandException("TODO");
 	}
 
+	unsigned width = (height2 / 3) * 4;
 	VLA(const void*, lines, height2);
-	WorkBuffer workBuffer;
-	getScaledFrame(*paintFrame, lines, workBuffer);
-	unsigned width = (height2 == 240) ? 320 : 640;
-	PNG::saveRGBA(width, lines, filename);
+	if (scaled) {
+		SoftwareScaler scaler(SoftwareScaler::getDefaultNumWorkers());
+		std::vector<uint32_t> image(size_t(width) * height2);
+		scaler.scaleImage(*paintFrame, SoftwareScaler::getConfig(renderSettings, height2 / 240), image);
+		for (auto y : xrange(height2)) {
+			lines[y] = &image[size_t(width) * y];
+		}
+		PNG::saveRGBA(width, lines, filename);
+	} else {
+		WorkBuffer workBuffer;
+		getScaledFrame(*paintFrame, lines, workBuffer);
+		PNG::saveRGBA(width, lines, filename);
+	}
 }
 
 void PostProcessor::createRegions()
@@ -92,7 +92,7 @@ public:
 	[[nodiscard]] FrameSource* getPaintFrame() const { return paintFrame; }
 
 	// VideoLayer
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	void takeRawScreenShot(unsigned height, const std::string& filename, bool scaled) override;
 
 	[[nodiscard]] CliComm& getCliComm();
 
@@ -88,6 +88,14 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"renderer", "rendering back-end used to display the MSX screen",
 		SDLGL_PP, getRendererMap(), Setting::DONT_SAVE)
 
+	, renderThreadsSetting(commandController,
+		"render_threads",
+		"number of threads used to convert the MSX screen to pixels, "
+		"only makes a difference when large parts of the screen are "
+		"rendered at once (e.g. accuracy screen); 1 means all rendering "
+		"is done in the emulation thread",
+		1, 1, 16)
+
 	, horizontalBlurSetting(commandController,
 		"blur", "amount of horizontal blur effect: 0 = none, 100 = full",
 		50, 0, 100)
@@ -115,6 +115,10 @@ public:
 	[[nodiscard]] RendererSetting& getRendererSetting() { return rendererSetting; }
 	[[nodiscard]] RendererID getRenderer() const { return rendererSetting.getEnum(); }
 
+	/** Number of threads used to convert VRAM to pixels. */
+	[[nodiscard]] IntegerSetting& getRenderThreadsSetting() { return renderThreadsSetting; }
+	[[nodiscard]] int getRenderThreads() const { return renderThreadsSetting.getInt(); }
+
 	/** The current scaling algorithm. */
 	[[nodiscard]] auto& getScaleAlgorithmSetting() { return scaleAlgorithmSetting; }
 	[[nodiscard]] ScaleAlgorithm getScaleAlgorithm() const {
@@ -223,6 +227,7 @@ private:
 	IntegerSetting glowSetting;
 	FloatSetting noiseSetting;
 	RendererSetting rendererSetting;
+	IntegerSetting renderThreadsSetting;
 	IntegerSetting horizontalBlurSetting;
 	EnumSetting<ScaleAlgorithm> scaleAlgorithmSetting;
 	IntegerSetting scaleFactorSetting;
@@ -8,6 +8,7 @@
 #include "PostProcessor.hh"
 #include "MemoryOps.hh"
 #include "OutputSurface.hh"
+#include "WorkerPool.hh"
 #include "enumerate.hh"
 #include "one_of.hh"
 #include "xrange.hh"
@@ -68,6 +69,36 @@ inline void SDLRasterizer::renderBitmapLine(std::span<Pixel> buf, unsigned vramL
 	}
 }
 
+template<typename F>
+void SDLRasterizer::drawLines(int startY, int endY, F drawLine)
+{
+	// Waking up the worker threads only pays off for a large number of
+	// lines. With 'accuracy screen' the complete display area is typically
+	// drawn at once, with the other settings it's mostly one line at a time.
+	static constexpr int LINES_PER_BAND = 16;
+
+	auto numThreads = unsigned(renderSettings.getRenderThreads());
+	int numLines = endY - startY;
+	if ((numThreads <= 1) || (numLines < 2 * LINES_PER_BAND)) {
+		for (auto y : xrange(startY, endY)) drawLine(y);
+		return;
+	}
+	if (!workerPool || (workerPool->getNumWorkers() != (numThreads - 1))) {
+		workerPool.reset(); // first stop the old threads
+		workerPool = std::make_unique<WorkerPool>(numThreads - 1); // +1 for this thread
+	}
+
+	// Each line only depends on the (during this call unchanging) VDP and
+	// VRAM state, and each line is written to its own part of 'workFrame'.
+	// So the lines can be drawn in any order, the result is the same.
+	auto numBands = (numLines + LINES_PER_BAND - 1) / LINES_PER_BAND;
+	workerPool->run(numBands, [&](size_t band) {
+		int y0 = startY + narrow<int>(band) * LINES_PER_BAND;
+		int y1 = std::min(y0 + LINES_PER_BAND, endY);
+		for (auto y : xrange(y0, y1)) drawLine(y);
+	});
+}
+
 SDLRasterizer::SDLRasterizer(
 		VDP& vdp_, Display& display, OutputSurface& screen_,
 		std::unique_ptr<PostProcessor> postProcessor_)
@@ -474,7 +505,9 @@ void SDLRasterizer::drawDisplay(
 	}
 
 	if (mode.isBitmapMode()) {
-		for (auto y : xrange(screenY, screenLimitY)) {
+		bitmapConverter.updateTables();
+		drawLines(screenY, screenLimitY, [&](int y) {
+			unsigned lineY = (displayY + (y - screenY)) & 255;
 			// Which bits in the name mask determine the page?
 			// TODO optimize this?
 			//   Calculating pageMaskOdd/Even is a non-trivial amount
@@ -488,8 +521,8 @@ void SDLRasterizer::drawDisplay(
 				? (pageMaskOdd & ~0x100)
 				: pageMaskOdd;
 			const std::array<unsigned, 2> vramLine = {
-				(vram.nameTable.getMask() >> 7) & (pageMaskEven | displayY),
-				(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | displayY)
+				(vram.nameTable.getMask() >> 7) & (pageMaskEven | lineY),
+				(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | lineY)
 			};
 
 			std::array<Pixel, 512> buf;
@@ -519,26 +552,23 @@ void SDLRasterizer::drawDisplay(
 				ranges::copy(subspan(buf, x, displayWidth - firstPageWidth),
 				             subspan(dst, firstPageWidth));
 			}
-
-			displayY = (displayY + 1) & 255;
-		}
+		});
 	} else {
 		// horizontal scroll (high) is implemented in CharacterConverter
-		for (auto y : xrange(screenY, screenLimitY)) {
-			assert(!vdp.isMSX1VDP() || displayY < 192);
+		drawLines(screenY, screenLimitY, [&](int y) {
+			int lineY = (displayY + (y - screenY)) & 255;
+			assert(!vdp.isMSX1VDP() || lineY < 192);
 
 			auto dst = workFrame->getLineDirect(y).subspan(leftBackground + displayX);
 			if ((displayX == 0) && (displayWidth == narrow<int>(lineWidth))){
-				characterConverter.convertLine(dst, displayY);
+				characterConverter.convertLine(dst, lineY);
 			} else {
 				std::array<Pixel, 512> buf;
-				characterConverter.convertLine(buf, displayY);
+				characterConverter.convertLine(buf, lineY);
 				auto src = subspan(buf, displayX, displayWidth);
 				ranges::copy(src, dst);
 			}
-
-			displayY = (displayY + 1) & 255;
-		}
+		});
 	}
 }
 
@@ -570,30 +600,30 @@ void SDLRasterizer::drawSprites(
 		vdp.getLeftSprites(),
 		vdp.getDisplayMode().getLineWidth() == 512);
 	if (spriteMode == 1) {
-		for (int y = fromY; y < limitY; y++, screenY++) {
-			auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+		drawLines(fromY, limitY, [&](int y) {
+			auto dst = workFrame->getLineDirect(y - lineRenderTop).subspan(screenX);
 			spriteConverter.drawMode1(y, displayX, displayLimitX, dst);
-		}
+		});
 	} else {
 		byte mode = vdp.getDisplayMode().getByte();
 		if (mode == DisplayMode::GRAPHIC5) {
-			for (int y = fromY; y < limitY; y++, screenY++) {
-				auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+			drawLines(fromY, limitY, [&](int y) {
+				auto dst = workFrame->getLineDirect(y - lineRenderTop).subspan(screenX);
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC5>(
 					y, displayX, displayLimitX, dst);
-			}
+			});
 		} else if (mode == DisplayMode::GRAPHIC6) {
-			for (int y = fromY; y < limitY; y++, screenY++) {
-				auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+			drawLines(fromY, limitY, [&](int y) {
+				auto dst = workFrame->getLineDirect(y - lineRenderTop).subspan(screenX);
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC6>(
 					y, displayX, displayLimitX, dst);
-			}
+			});
 		} else {
-			for (int y = fromY; y < limitY; y++, screenY++) {
-				auto dst = workFrame->getLineDirect(screenY).subspan(screenX);
+			drawLines(fromY, limitY, [&](int y) {
+				auto dst = workFrame->getLineDirect(y - lineRenderTop).subspan(screenX);
 				spriteConverter.template drawMode2<DisplayMode::GRAPHIC4>(
 					y, displayX, displayLimitX, dst);
-			}
+			});
 		}
 	}
 }
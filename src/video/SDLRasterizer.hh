@@ -21,6 +21,7 @@ class RawFrame;
 class RenderSettings;
 class Setting;
 class PostProcessor;
+class WorkerPool;
 
 /** Rasterizer using a frame buffer approach: it writes pixels to a single
   * rectangular pixel buffer.
@@ -67,6 +68,12 @@ public:
 private:
 	inline void renderBitmapLine(std::span<Pixel> buf, unsigned vramLine);
 
+	/** Call 'drawLine(y)' for all 'y' in [startY, endY). When this is a
+	  * large range, the lines may be drawn in parallel (see the
+	  * 'render_threads' setting).
+	  */
+	template<typename F> void drawLines(int startY, int endY, F drawLine);
+
 	/** Reload entire palette from VDP.
 	  */
 	void resetPalette();
@@ -160,6 +167,10 @@ private:
 	/** Host colors corresponding to each possible V9958 color.
 	  */
 	std::array<Pixel, 32768> V9958_COLORS;
+
+	/** Only created when 'render_threads' is more than 1.
+	  */
+	std::unique_ptr<WorkerPool> workerPool;
 };
 
 } // namespace openmsx
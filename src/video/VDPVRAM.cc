@@ -4,6 +4,7 @@
 #include "outer.hh"
 #include "ranges.hh"
 #include "serialize.hh"
+#include "xrange.hh"
 #include <algorithm>
 #include <array>
 #include <bit>
@@ -62,6 +63,17 @@ void VDPVRAM::LogicalVRAMDebuggable::write(
 	vram.cpuWrite(transform(address), value, time);
 }
 
+void VDPVRAM::LogicalVRAMDebuggable::readBlock(unsigned address, std::span<byte> output)
+{
+	auto& vram = OUTER(VDPVRAM, logicalVRAMDebug);
+	if (vram.vdp.getDisplayMode().isPlanar()) {
+		// consecutive addresses are not consecutive in VRAM
+		SimpleDebuggable::readBlock(address, output);
+	} else {
+		vram.cpuReadBlock(address, output, getMotherBoard().getCurrentTime());
+	}
+}
+
 
 // class PhysicalVRAMDebuggable
 
@@ -87,6 +99,12 @@ void VDPVRAM::PhysicalVRAMDebuggable::write(
 	vram.cpuWrite(address, value, time);
 }
 
+void VDPVRAM::PhysicalVRAMDebuggable::readBlock(unsigned address, std::span<byte> output)
+{
+	auto& vram = OUTER(VDPVRAM, physicalVRAMDebug);
+	vram.cpuReadBlock(address, output, getMotherBoard().getCurrentTime());
+}
+
 
 // class VDPVRAM
 
@@ -141,6 +159,36 @@ void VDPVRAM::clear()
 	}
 }
 
+void VDPVRAM::cpuReadBlock(unsigned address, std::span<byte> output, EmuTime::param time)
+{
+	if (output.empty()) return;
+	#ifdef DEBUG
+	assert(time >= vramTime);
+	vramTime = time;
+	#endif
+	assert(vdp.isInsideFrame(time));
+
+	auto num = unsigned(output.size());
+	if (ranges::any_of(xrange(num), [&](unsigned i) {
+		return cmdWriteWindow.isInside((address + i) & sizeMask); })) {
+		cmdEngine->sync(time);
+	}
+	// Only the first read steals an access slot, for the next reads (at
+	// the same time) the command engine is already ahead.
+	cmdEngine->stealAccessSlot(time);
+
+	unsigned last = address + num - 1;
+	unsigned changedBits = (1u << std::bit_width(address ^ last)) - 1;
+	if ((changedBits & ~sizeMask) == 0) {
+		// no mirroring within the block
+		ranges::copy(std::span{&data[address & sizeMask], num}, output);
+	} else {
+		for (auto i : xrange(num)) {
+			output[i] = data[(address + i) & sizeMask];
+		}
+	}
+}
+
 void VDPVRAM::updateDisplayMode(DisplayMode mode, bool cmdBit, EmuTime::param time)
 {
 	assert(vdp.isInsideFrame(time));
@@ -500,6 +500,12 @@ public:
 		return data[address];
 	}
 
+	/** Read a block of VRAM through the CPU interface. This has the same
+	  * result as calling cpuRead() for the addresses 'address + i', but
+	  * it syncs with the command engine only once.
+	  */
+	void cpuReadBlock(unsigned address, std::span<byte> output, EmuTime::param time);
+
 	/** Used by the VDP to signal display mode changes.
 	  * VDPVRAM will inform the Renderer, command engine and the sprite
 	  * checker of this change.
@@ -634,6 +640,7 @@ private:
 		explicit LogicalVRAMDebuggable(VDP& vdp);
 		[[nodiscard]] byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned address, std::span<byte> output) override;
 	private:
 		unsigned transform(unsigned address);
 	} logicalVRAMDebug;
@@ -646,6 +653,7 @@ private:
 		PhysicalVRAMDebuggable(VDP& vdp, unsigned actualSize);
 		[[nodiscard]] byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned address, std::span<byte> output) override;
 	} physicalVRAMDebug;
 
 	// TODO: Renderer field can be removed, if updateDisplayMode
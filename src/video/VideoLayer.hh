@@ -29,10 +29,12 @@ public:
 	[[nodiscard]] int getVideoSourceSetting() const;
 
 	/** Create a raw (=non-post-processed) screenshot. The 'height'
-	 * parameter should be either '240' or '480'. The current image will be
-	 * scaled to '320x240' or '640x480' and written to a png file. */
+	 * parameter should be either '240', '480' or '720'. The current image
+	 * will be resized to '320x240', '640x480' or '960x720' and written to
+	 * a png file. When 'scaled' is true the current scale algorithm is
+	 * applied (in software, see SoftwareScaler) instead of only resizing. */
 	virtual void takeRawScreenShot(
-		unsigned height, const std::string& filename) = 0;
+		unsigned height, const std::string& filename, bool scaled) = 0;
 
 	// We used to test whether a Layer is active by looking at the
 	// Z-coordinate (Z_MSX_ACTIVE vs Z_MSX_PASSIVE). Though in case of
@@ -1,20 +1,24 @@
 // Code based on DOSBox-0.65
 
 #include "ZMBVEncoder.hh"
-#include "FrameSource.hh"
 #include "PixelOperations.hh"
 #include "cstd.hh"
 #include "endian.hh"
 #include "narrow.hh"
 #include "ranges.hh"
-#include "unreachable.hh"
+#include "xrange.hh"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <thread>
 #include <tuple>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -112,8 +116,16 @@ static inline void writePixel(
 }
 
 
-ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_)
-	: width(width_)
+unsigned ZMBVEncoder::getDefaultNumWorkers()
+{
+	// The calling thread also participates. Even at 960x720 there are
+	// only 45 rows of blocks, more threads don't help much.
+	return std::clamp(std::thread::hardware_concurrency(), 1u, 4u) - 1;
+}
+
+ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned numWorkers)
+	: workerPool(numWorkers)
+	, width(width_)
 	, height(height_)
 {
 	setupBuffers();
@@ -139,6 +151,11 @@ ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_)
 	// Level 6 seems a good compromise between size/speed for THIS test.
 }
 
+ZMBVEncoder::~ZMBVEncoder()
+{
+	deflateEnd(&zstream);
+}
+
 void ZMBVEncoder::setupBuffers()
 {
 	static constexpr size_t pixelSize = sizeof(Pixel);
@@ -159,6 +176,7 @@ void ZMBVEncoder::setupBuffers()
 	size_t xBlocks = width / BLOCK_WIDTH;
 	size_t yBlocks = height / BLOCK_HEIGHT;
 	blockOffsets.resize(xBlocks * yBlocks);
+	xorOffsets.resize(xBlocks * yBlocks);
 	for (auto y : xrange(yBlocks)) {
 		for (auto x : xrange(xBlocks)) {
 			blockOffsets[y * xBlocks + x] =
@@ -175,11 +193,11 @@ unsigned ZMBVEncoder::neededSize() const
 	return f + f / 1000;
 }
 
-unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset)
+unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset) const
 {
 	int ret = 0;
-	auto* pOld = &(reinterpret_cast<Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
-	auto* pNew = &(reinterpret_cast<Pixel*>(newFrame.data()))[offset];
+	const auto* pOld = &(reinterpret_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
+	const auto* pNew = &(reinterpret_cast<const Pixel*>(newFrame.data()))[offset];
 	for (unsigned y = 0; y < BLOCK_HEIGHT; y += 4) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; x += 4) {
 			if (pOld[x] != pNew[x]) ++ret;
@@ -190,11 +208,27 @@ unsigned ZMBVEncoder::possibleBlock(int vx, int vy, size_t offset)
 	return ret;
 }
 
-unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset)
+unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset) const
 {
+	const auto* pOld = &(reinterpret_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
+	const auto* pNew = &(reinterpret_cast<const Pixel*>(newFrame.data()))[offset];
+#ifdef __SSE2__
+	// count the equal pixels, 4 at a time
+	__m128i equal = _mm_setzero_si128();
+	repeat(BLOCK_HEIGHT, [&] {
+		for (unsigned x = 0; x < BLOCK_WIDTH; x += 4) {
+			auto o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pOld + x));
+			auto n = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pNew + x));
+			equal = _mm_sub_epi32(equal, _mm_cmpeq_epi32(o, n)); // +1 when equal
+		}
+		pOld += pitch;
+		pNew += pitch;
+	});
+	equal = _mm_add_epi32(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(1, 0, 3, 2)));
+	equal = _mm_add_epi32(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+	return BLOCK_WIDTH * BLOCK_HEIGHT - unsigned(_mm_cvtsi128_si32(equal));
+#else
 	int ret = 0;
-	auto* pOld = &(reinterpret_cast<Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
-	auto* pNew = &(reinterpret_cast<Pixel*>(newFrame.data()))[offset];
 	repeat(BLOCK_HEIGHT, [&] {
 		for (auto x : xrange(BLOCK_WIDTH)) {
 			if (pOld[x] != pNew[x]) ++ret;
@@ -203,23 +237,42 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, size_t offset)
 		pNew += pitch;
 	});
 	return ret;
+#endif
 }
 
-void ZMBVEncoder::addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed)
+void ZMBVEncoder::addXorBlock(int vx, int vy, size_t offset, uint8_t* dest) const
 {
+	const auto* pOld = &(reinterpret_cast<const Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
+	const auto* pNew = &(reinterpret_cast<const Pixel*>(newFrame.data()))[offset];
+#ifdef __SSE2__
+	// Same as writePixel() below (x86 is little endian).
+	auto* out = reinterpret_cast<__m128i*>(dest);
+	const __m128i mask00FF = _mm_set1_epi32(0x000000FF);
+	const __m128i maskFF00 = _mm_set1_epi32(0x0000FF00);
+	repeat(BLOCK_HEIGHT, [&] {
+		for (unsigned x = 0; x < BLOCK_WIDTH; x += 4) {
+			auto o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pOld + x));
+			auto n = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pNew + x));
+			auto p = _mm_xor_si128(o, n);
+			auto r = _mm_slli_epi32(_mm_and_si128(p, mask00FF), 16);
+			auto g = _mm_and_si128(p, maskFF00);
+			auto b = _mm_and_si128(_mm_srli_epi32(p, 16), mask00FF);
+			_mm_storeu_si128(out++, _mm_or_si128(_mm_or_si128(r, g), b));
+		}
+		pOld += pitch;
+		pNew += pitch;
+	});
+#else
 	using LE_P = typename Endian::Little<Pixel>::type;
-
-	auto* pOld = &(reinterpret_cast<Pixel*>(oldFrame.data()))[offset + (vy * pitch) + vx];
-	auto* pNew = &(reinterpret_cast<Pixel*>(newFrame.data()))[offset];
+	auto* out = reinterpret_cast<LE_P*>(dest);
 	repeat(BLOCK_HEIGHT, [&] {
 		for (auto x : xrange(BLOCK_WIDTH)) {
-			auto pXor = pNew[x] ^ pOld[x];
-			writePixel(pXor, *reinterpret_cast<LE_P*>(&work[workUsed]));
-			workUsed += sizeof(Pixel);
+			writePixel(pNew[x] ^ pOld[x], *out++);
 		}
 		pOld += pitch;
 		pNew += pitch;
 	});
+#endif
 }
 
 void ZMBVEncoder::addXorFrame(unsigned& workUsed)
@@ -233,35 +286,52 @@ void ZMBVEncoder::addXorFrame(unsigned& workUsed)
 	// Align the following xor data on 4 byte boundary
 	workUsed = (workUsed + blockCount * 2 + 3) & ~3;
 
-	int bestVx = 0;
-	int bestVy = 0;
-	for (auto b : xrange(blockCount)) {
-		auto offset = blockOffsets[b];
-		// first try best vector of previous block
-		unsigned bestChange = compareBlock(bestVx, bestVy, offset);
-		if (bestChange >= 4) {
-			int possibles = 64;
-			for (const auto& v : vectorTable) {
-				if (possibleBlock(v.x, v.y, offset) < 4) {
-					unsigned testChange = compareBlock(v.x, v.y, offset);
-					if (testChange < bestChange) {
-						bestChange = testChange;
-						bestVx = narrow<int>(v.x);
-						bestVy = narrow<int>(v.y);
-						if (bestChange < 4) break;
+	// Find the best motion vector for each block. Each row of blocks is
+	// searched independently (the search starts from the best vector of
+	// the previous block in the same row), so the rows can be searched in
+	// parallel, and the result doesn't depend on the number of threads.
+	workerPool.run(yBlocks, [&](size_t row) {
+		int bestVx = 0;
+		int bestVy = 0;
+		for (auto b : xrange(row * xBlocks, (row + 1) * xBlocks)) {
+			auto offset = blockOffsets[b];
+			// first try best vector of previous block
+			unsigned bestChange = compareBlock(bestVx, bestVy, offset);
+			if (bestChange >= 4) {
+				int possibles = 64;
+				for (const auto& v : vectorTable) {
+					if (possibleBlock(v.x, v.y, offset) < 4) {
+						unsigned testChange = compareBlock(v.x, v.y, offset);
+						if (testChange < bestChange) {
+							bestChange = testChange;
+							bestVx = narrow<int>(v.x);
+							bestVy = narrow<int>(v.y);
+							if (bestChange < 4) break;
+						}
+						--possibles;
+						if (possibles == 0) break;
 					}
-					--possibles;
-					if (possibles == 0) break;
 				}
 			}
+			vectors[b * 2 + 0] = narrow<int8_t>((bestVx << 1) | (bestChange ? 1 : 0));
+			vectors[b * 2 + 1] = narrow<int8_t>(bestVy << 1);
 		}
-		vectors[b * 2 + 0] = narrow<int8_t>(bestVx << 1);
-		vectors[b * 2 + 1] = narrow<int8_t>(bestVy << 1);
-		if (bestChange) {
-			vectors[b * 2 + 0] |= 1;
-			addXorBlock(bestVx, bestVy, offset, workUsed);
-		}
+	});
+
+	// The xor data of the changed blocks follows in block order. Now that
+	// it's known which blocks changed, it can also be produced in parallel.
+	static constexpr unsigned BLOCK_SIZE = BLOCK_WIDTH * BLOCK_HEIGHT * sizeof(Pixel);
+	for (auto b : xrange(blockCount)) {
+		xorOffsets[b] = workUsed;
+		if (vectors[b * 2 + 0] & 1) workUsed += BLOCK_SIZE;
 	}
+	workerPool.run(yBlocks, [&](size_t row) {
+		for (auto b : xrange(row * xBlocks, (row + 1) * xBlocks)) {
+			if (!(vectors[b * 2 + 0] & 1)) continue;
+			addXorBlock(vectors[b * 2 + 0] >> 1, vectors[b * 2 + 1] >> 1,
+			            blockOffsets[b], &work[xorOffsets[b]]);
+		}
+	});
 }
 
 void ZMBVEncoder::addFullFrame(unsigned& workUsed)
@@ -282,25 +352,19 @@ void ZMBVEncoder::addFullFrame(unsigned& workUsed)
 	});
 }
 
-const void* ZMBVEncoder::getScaledLine(const FrameSource* frame, unsigned y, void* workBuf_) const
-{
-	auto* workBuf = static_cast<uint32_t*>(workBuf_);
-	switch (height) {
-	case 240:
-		return frame->getLinePtr320_240(y, std::span<uint32_t, 320>(workBuf, 320)).data();
-	case 480:
-		return frame->getLinePtr640_480(y, std::span<uint32_t, 640>(workBuf, 640)).data();
-	case 720:
-		return frame->getLinePtr960_720(y, std::span<uint32_t, 960>(workBuf, 960)).data();
-	default:
-		UNREACHABLE;
-	}
-}
-
-std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame)
+std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, std::span<const Pixel> image)
 {
+	assert(image.size() == size_t(width) * height);
 	std::swap(newFrame, oldFrame); // replace oldFrame with newFrame
 
+	// copy lines (to add black border)
+	auto* dest = reinterpret_cast<Pixel*>(
+		&newFrame[sizeof(Pixel) * (MAX_VECTOR + MAX_VECTOR * pitch)]);
+	for (auto i : xrange(height)) {
+		ranges::copy(image.subspan(size_t(width) * i, width), dest);
+		dest += pitch;
+	}
+
 	// Reset the work buffer
 	unsigned workUsed = 0;
 	unsigned writeDone = 1;
@@ -323,18 +387,6 @@ std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource*
 		deflateReset(&zstream); // restart deflate
 	}
 
-	// copy lines (to add black border)
-	static constexpr size_t pixelSize = sizeof(Pixel);
-	auto linePitch = pitch * pixelSize;
-	auto lineWidth = size_t(width) * pixelSize;
-	uint8_t* dest =
-		&newFrame[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	for (auto i : xrange(height)) {
-		const auto* scaled = getScaledLine(frame, i, dest);
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
-		dest += linePitch;
-	}
-
 	// Add the frame data.
 	if (keyFrame) {
 		// Key frame: full frame data.
@@ -4,6 +4,7 @@
 #define ZMBVENCODER_HH
 
 #include "MemBuffer.hh"
+#include "WorkerPool.hh"
 #include "aligned.hh"
 #include <concepts>
 #include <cstdint>
@@ -13,27 +14,37 @@
 
 namespace openmsx {
 
-class FrameSource;
-
 class ZMBVEncoder
 {
 public:
 	static constexpr std::string_view CODEC_4CC = "ZMBV";
 	using Pixel = uint32_t;
 
-	ZMBVEncoder(unsigned width, unsigned height);
+	/** Suggested number of worker threads, based on the number of cores. */
+	[[nodiscard]] static unsigned getDefaultNumWorkers();
+
+	/** The motion search for delta frames is split over 'numWorkers'
+	  * threads (plus the calling thread). The output doesn't depend on
+	  * the number of threads.
+	  */
+	ZMBVEncoder(unsigned width, unsigned height, unsigned numWorkers);
+	~ZMBVEncoder();
+
+	ZMBVEncoder(const ZMBVEncoder&) = delete;
+	ZMBVEncoder& operator=(const ZMBVEncoder&) = delete;
 
-	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, FrameSource* frame);
+	/** Compress an image of 'width x height' pixels (lines stored
+	  * consecutively). */
+	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, std::span<const Pixel> image);
 
 private:
 	void setupBuffers();
 	[[nodiscard]] unsigned neededSize() const;
 	void addFullFrame(unsigned& workUsed);
 	void addXorFrame (unsigned& workUsed);
-	[[nodiscard]] unsigned possibleBlock(int vx, int vy, size_t offset);
-	[[nodiscard]] unsigned compareBlock(int vx, int vy, size_t offset);
-	void addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed);
-	[[nodiscard]] const void* getScaledLine(const FrameSource* frame, unsigned y, void* workBuf) const;
+	[[nodiscard]] unsigned possibleBlock(int vx, int vy, size_t offset) const;
+	[[nodiscard]] unsigned compareBlock(int vx, int vy, size_t offset) const;
+	void addXorBlock(int vx, int vy, size_t offset, uint8_t* dest) const;
 
 private:
 	MemBuffer<uint8_t, SSE_ALIGNMENT> oldFrame;
@@ -41,9 +52,11 @@ private:
 	MemBuffer<uint8_t, SSE_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<size_t> blockOffsets;
+	MemBuffer<unsigned> xorOffsets; // per block, position of xor data in 'work'
 	unsigned outputSize;
 
 	z_stream zstream;
+	WorkerPool workerPool;
 
 	const unsigned width;
 	const unsigned height;
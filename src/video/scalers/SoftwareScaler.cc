@@ -0,0 +1,454 @@
+#include "SoftwareScaler.hh"
+#include "FrameSource.hh"
+#include "HQCommon.hh"
+#include "PixelOperations.hh"
+#include "File.hh"
+#include "FileContext.hh"
+#include "MSXException.hh"
+#include "enumerate.hh"
+#include "narrow.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include "unreachable.hh"
+#include "vla.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx {
+
+using Pixel = SoftwareScaler::Pixel;
+
+// Number of source lines per task. Small enough to keep all threads busy,
+// large enough to make the per-band overhead (hq: edges of one extra line)
+// negligible.
+static constexpr unsigned BAND_HEIGHT = 16;
+
+// Blurring looks at most this many (replicated) pixels to the left/right.
+static constexpr unsigned MAX_ZOOM = 3;
+
+SoftwareScaler::Config SoftwareScaler::getConfig(const RenderSettings& settings, unsigned factor)
+{
+	return {settings.getScaleAlgorithm(), factor,
+	        settings.getBlurFactor(), settings.getScanlineFactor()};
+}
+
+unsigned SoftwareScaler::getDefaultNumWorkers()
+{
+	// The calling thread also participates. More than 4 threads in total
+	// doesn't help much: even 960x720 at 60fps is only ~40 Mpixel/s.
+	return std::clamp(std::thread::hardware_concurrency(), 1u, 4u) - 1;
+}
+
+SoftwareScaler::SoftwareScaler(unsigned numWorkers)
+	: workerPool(numWorkers)
+{
+}
+
+// Multiply the R,G,B components of all pixels with 'factor/256' (alpha is
+// preserved). Gives the same result as PixelOperations::multiply().
+static void scanlineRow(std::span<const Pixel> in, std::span<Pixel> out, unsigned factor)
+{
+	assert(in.size() == out.size());
+	if (factor == 256) {
+		if (in.data() != out.data()) ranges::copy(in, out);
+		return;
+	}
+	size_t i = 0;
+#ifdef __SSE2__
+	auto zero = _mm_setzero_si128();
+	auto f16 = narrow<short>(factor);
+	auto f = _mm_set_epi16(256, f16, f16, f16, 256, f16, f16, f16);
+	for (; (i + 4) <= in.size(); i += 4) {
+		auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[i]));
+		auto lo = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), f), 8);
+		auto hi = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), f), 8);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), _mm_packus_epi16(lo, hi));
+	}
+#endif
+	for (/**/; i < in.size(); ++i) {
+		Pixel p = in[i];
+		out[i] = (PixelOperations::multiply(p, factor) & 0x00FFFFFF) | (p & 0xFF000000);
+	}
+}
+
+// Weighted sum of 3 pixels, the weights must add up to 256.
+[[nodiscard]] static inline Pixel blend3(Pixel p0, unsigned w0, Pixel p1, unsigned w1, Pixel p2, unsigned w2)
+{
+	unsigned rb = ((p0 & 0x00FF00FF) * w0 + (p1 & 0x00FF00FF) * w1 + (p2 & 0x00FF00FF) * w2) >> 8;
+	unsigned ag = ((p0 >> 8) & 0x00FF00FF) * w0 + ((p1 >> 8) & 0x00FF00FF) * w1 + ((p2 >> 8) & 0x00FF00FF) * w2;
+	return (rb & 0x00FF00FF) | (ag & 0xFF00FF00);
+}
+
+// Horizontal filter on a line where each source pixel is replicated 'k'
+// times: output pixel 'j' is a weighted sum of input pixels 'j-k', 'j' and
+// 'j+k' (so the left neighbour, the pixel itself and the right neighbour).
+// The weights depend on the position within the (replicated) source pixel.
+// 'in' must have 'k' valid pixels before the start and after the end.
+static void blurLine(const Pixel* in, std::span<Pixel> out, unsigned k,
+                     const SoftwareScaler::BlurWeights& w)
+{
+	size_t j = 0;
+#ifdef __SSE2__
+	auto zero = _mm_setzero_si128();
+	auto load = [](const Pixel* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+	auto weights = [](const std::array<uint16_t, 4 * 12>& a, unsigned i) {
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(&a[8 * i]));
+	};
+	unsigned g = 0; // group of 4 pixels within the cycle of 12
+	for (/**/; (j + 4) <= out.size(); j += 4) {
+		auto l = load(in + j - k);
+		auto c = load(in + j);
+		auto r = load(in + j + k);
+		auto lo = _mm_add_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(l, zero), weights(w.left,   2 * g)),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), weights(w.center, 2 * g))),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(r, zero), weights(w.right,  2 * g)));
+		auto hi = _mm_add_epi16(_mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(l, zero), weights(w.left,   2 * g + 1)),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), weights(w.center, 2 * g + 1))),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(r, zero), weights(w.right,  2 * g + 1)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&out[j]),
+		                 _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+		g = (g == 2) ? 0 : g + 1;
+	}
+#endif
+	for (/**/; j < out.size(); ++j) {
+		auto m = 4 * (j % 12);
+		out[j] = blend3(in[j - k], w.left[m], in[j], w.center[m], in[j + k], w.right[m]);
+	}
+}
+
+// Weights for the 'simple' scaler (see simple.frag): the average of two
+// linearly interpolated samples, one shifted 'blur' pixels to the left.
+[[nodiscard]] static SoftwareScaler::BlurWeights calcBlurWeights(unsigned k, int blur)
+{
+	SoftwareScaler::BlurWeights result;
+	for (auto j : xrange(12u)) {
+		auto s = j % k; // sub-pixel position is (s + 0.5) / k
+		auto wl = narrow<uint16_t>((blur * int(2 * (k - s) - 1)) / int(4 * k));
+		auto wr = narrow<uint16_t>((blur * int(2 * s + 1)) / int(4 * k));
+		for (auto c : xrange(4u)) {
+			result.left  [4 * j + c] = wl;
+			result.right [4 * j + c] = wr;
+			result.center[4 * j + c] = narrow<uint16_t>(256 - wl - wr);
+		}
+	}
+	return result;
+}
+
+// Weights for the 'RGBtriplet' scaler: a linearly interpolated sample at the
+// center of each output pixel.
+[[nodiscard]] static SoftwareScaler::BlurWeights calcInterpolateWeights(unsigned k)
+{
+	SoftwareScaler::BlurWeights result;
+	for (auto j : xrange(12u)) {
+		auto s = int(j % k);
+		auto wl = narrow<uint16_t>(std::max(0, (128 * (int(k) - 2 * s - 1)) / int(k)));
+		auto wr = narrow<uint16_t>(std::max(0, (128 * (2 * s + 1 - int(k))) / int(k)));
+		for (auto c : xrange(4u)) {
+			result.left  [4 * j + c] = wl;
+			result.right [4 * j + c] = wr;
+			result.center[4 * j + c] = narrow<uint16_t>(256 - wl - wr);
+		}
+	}
+	return result;
+}
+
+void SoftwareScaler::setup(const Config& config)
+{
+	assert(1 <= config.factor && config.factor <= MAX_ZOOM);
+	factor = config.factor;
+	auto algo = config.algorithm;
+	hq = (factor > 1) && ((algo == RenderSettings::SCALER_HQ) ||
+	                      (algo == RenderSettings::SCALER_HQLITE));
+	// Same condition as in GLRGBScaler: otherwise it's a plain resize.
+	rgbTriplet = (algo == RenderSettings::SCALER_RGBTRIPLET) &&
+	             ((config.blur != 0) || (config.scanline != 255));
+	blur = !hq && !rgbTriplet && (config.blur != 0);
+
+	// Scanlines, see simple.frag and GLSimpleScaler: intensity of the
+	// output rows within one source line.
+	float scanline = narrow<float>(config.scanline) * (1.0f / 255.0f);
+	auto N = narrow<float>(factor);
+	float a = (factor & 1) ? 0.5f : ((N + 1.0f) / (2.0f * N));
+	std::array<float, MAX_ZOOM> scan = {};
+	for (auto r : xrange(factor)) {
+		float y = (narrow<float>(r) + 0.5f) / N + 0.5f;
+		scan[r] = scanline + (2.0f - 2.0f * scanline) * std::abs(y - std::floor(y) - a);
+		scanlineFactor[r] = std::clamp(narrow<unsigned>(std::lround(256.0f * scan[r])), 0u, 256u);
+	}
+
+	if (blur) {
+		for (auto k : xrange(1u, MAX_ZOOM + 1)) {
+			blurWeights[k - 1] = calcBlurWeights(k, config.blur);
+		}
+	} else if (rgbTriplet) {
+		for (auto k : xrange(1u, MAX_ZOOM + 1)) {
+			blurWeights[k - 1] = calcInterpolateWeights(k);
+		}
+		// See rgb.frag: per color component, for the 'main' component
+		// of the sub-pixel (e.g. red in the left-most sub-pixel) and for
+		// the other two components.
+		float c1 = narrow<float>(config.blur) * (1.0f / 256.0f);
+		float c2 = 3.0f - 2.0f * c1;
+		for (auto r : xrange(factor)) {
+			for (auto v : xrange(256)) {
+				float n = narrow<float>(v) * (1.0f / 255.0f) * scan[r] * c2;
+				float other = n * (c1 / c2) + std::clamp((n - 1.0f) * 0.5f, 0.0f, 1.0f);
+				auto toByte = [](float x) {
+					return narrow<uint8_t>(std::lround(std::clamp(x, 0.0f, 1.0f) * 255.0f));
+				};
+				rgbLut[r][0][v] = toByte(n);
+				rgbLut[r][1][v] = toByte(other);
+			}
+		}
+	}
+
+	if (hq) {
+		bool lite = algo == RenderSettings::SCALER_HQLITE;
+		if ((hqTableFactor != factor) || (hqTableLite != lite)) {
+			hqTableFactor = 0; // in case loading fails
+			loadHQTable(lite, factor);
+			hqTableFactor = factor;
+			hqTableLite = lite;
+		}
+	}
+}
+
+// Convert the tables that are used by the hq and hqlite shaders (see hq.py).
+// Both have one entry per 12-bit edge pattern and per output sub-pixel, laid
+// out as a (64 * factor) x (64 * factor) texture.
+void SoftwareScaler::loadHQTable(bool lite, unsigned n)
+{
+	const auto& context = systemFileContext();
+	size_t size = 64 * n;
+	hqTable.resize(size * size);
+	auto cell = [](uint8_t v) { return narrow<uint8_t>((v + 64) / 128); }; // 0, 128, 255 -> 0, 1, 2
+
+	if (!lite) {
+		File offsetsFile(context.resolve(strCat("shaders/HQ", n, "xOffsets.dat")));
+		File weightsFile(context.resolve(strCat("shaders/HQ", n, "xWeights.dat")));
+		auto offsets = offsetsFile.mmap();
+		auto weights = weightsFile.mmap();
+		if ((offsets.size() != 4 * hqTable.size()) ||
+		    (weights.size() != 3 * hqTable.size())) {
+			throw MSXException("Invalid hq scaler tables.");
+		}
+		for (auto [i, e] : enumerate(hqTable)) {
+			std::array<unsigned, 3> w = {weights[3 * i + 0], weights[3 * i + 1], weights[3 * i + 2]};
+			// weights are scaled to a sum of 256, then clipped to 255
+			if ((w[0] + w[1] + w[2]) == 255) ++*std::ranges::max_element(w);
+			e.col0 = cell(offsets[4 * i + 0]);
+			e.row0 = cell(offsets[4 * i + 1]);
+			e.col1 = cell(offsets[4 * i + 2]);
+			e.row1 = cell(offsets[4 * i + 3]);
+			e.weight0 = narrow<uint16_t>(w[0]);
+			e.weight1 = narrow<uint16_t>(w[1]);
+		}
+	} else {
+		// In the hqlite table the result is encoded as a (horizontal)
+		// offset in an interpolated texture.
+		File offsetsFile(context.resolve(strCat("shaders/HQ", n, "xLiteOffsets.dat")));
+		auto offsets = offsetsFile.mmap();
+		if (offsets.size() != 2 * hqTable.size()) {
+			throw MSXException("Invalid hqlite scaler table.");
+		}
+		for (auto [i, e] : enumerate(hqTable)) {
+			auto subX = narrow<unsigned>(i % n);
+			auto center = int(192.5 - 128.0 * (0.5 + subX) / n); // truncate, like hq.py
+			int delta = offsets[2 * i] - center; // [-128..128]
+			e.row0 = 1;
+			e.col0 = (delta < 0) ? 0 : 2;
+			e.weight0 = narrow<uint16_t>(2 * std::abs(delta));
+			e.row1 = e.col1 = 1;
+			e.weight1 = 0;
+		}
+	}
+}
+
+void SoftwareScaler::scaleImage(
+	const FrameSource& frame, const Config& config, std::span<Pixel> out)
+{
+	setup(config);
+	unsigned width = 320 * factor;
+	assert(out.size() == size_t(width) * 240 * factor);
+
+	unsigned numBands = (240 + BAND_HEIGHT - 1) / BAND_HEIGHT;
+	workerPool.run(numBands, [&](size_t band) {
+		auto startY = narrow<unsigned>(band * BAND_HEIGHT);
+		auto endY = std::min(startY + BAND_HEIGHT, 240u);
+		auto bandOut = out.subspan(size_t(width) * factor * startY,
+		                           size_t(width) * factor * (endY - startY));
+		if (frame.getHeight() != 240) {
+			scaleBandInterlaced(frame, startY, endY, bandOut);
+		} else if (hq) {
+			scaleBandHQ(frame, startY, endY, bandOut);
+		} else {
+			scaleBand(frame, startY, endY, bandOut);
+		}
+	});
+}
+
+void SoftwareScaler::scaleBand(
+	const FrameSource& frame, unsigned startY, unsigned endY,
+	std::span<Pixel> out) const
+{
+	unsigned width = 320 * factor;
+	VLA_SSE_ALIGNED(Pixel, work, 2 * width + 2 * MAX_ZOOM);
+	for (auto y : xrange(startY, endY)) {
+		scaleLine(frame, y, out.subspan(size_t(width) * factor * (y - startY), size_t(width) * factor),
+		          work.data());
+	}
+}
+
+// Scale one (non-interlaced) source line to 'factor' output rows.
+// 'work' must have room for '2 * width + 2 * MAX_ZOOM' pixels.
+void SoftwareScaler::scaleLine(
+	const FrameSource& frame, unsigned y, std::span<Pixel> out, Pixel* work) const
+{
+	unsigned width = 320 * factor;
+	unsigned lineWidth = frame.getLineWidth(y);
+
+	// horizontally replicated line, with room to extend it at both sides
+	std::span<Pixel> buf{work + MAX_ZOOM, width};
+	auto line = frame.getLine(narrow<int>(y), buf);
+
+	std::span<const Pixel> row = line;
+	// Treat a border line as a 320 pixel wide line (like GLRGBScaler).
+	unsigned srcWidth = (lineWidth == 1) ? 320 : lineWidth;
+	unsigned k = ((width % srcWidth) == 0) ? width / srcWidth : 0; // zoom factor
+	if ((blur || rgbTriplet) && (lineWidth != 1) && (1 <= k) && (k <= MAX_ZOOM)) {
+		if (line.data() != buf.data()) ranges::copy(line, buf);
+		std::fill_n(buf.data() - k, k, buf.front());
+		std::fill_n(buf.data() + width, k, buf.back());
+		std::span<Pixel> filtered{work + width + 2 * MAX_ZOOM, width};
+		blurLine(buf.data(), filtered, k, blurWeights[k - 1]);
+		row = filtered;
+	}
+
+	if (rgbTriplet) {
+		// Sub-pixel 0, 1, 2 within each source pixel emphasizes
+		// respectively the red, green and blue component.
+		VLA(uint8_t, mainComponent, width);
+		for (auto x : xrange(width)) {
+			auto pos = ((2 * x + 1) * srcWidth) % (2 * width);
+			mainComponent[x] = narrow<uint8_t>((3 * pos) / (2 * width));
+		}
+		for (auto r : xrange(factor)) {
+			auto dst = out.subspan(size_t(width) * r, width);
+			const auto& lut = rgbLut[r];
+			for (auto x : xrange(width)) {
+				Pixel p = row[x];
+				auto m = mainComponent[x];
+				dst[x] = (lut[m != 0][(p >>  0) & 0xFF] <<  0)
+				       | (lut[m != 1][(p >>  8) & 0xFF] <<  8)
+				       | (lut[m != 2][(p >> 16) & 0xFF] << 16)
+				       | (p & 0xFF000000);
+			}
+		}
+	} else {
+		for (auto r : xrange(factor)) {
+			scanlineRow(row, out.subspan(size_t(width) * r, width), scanlineFactor[r]);
+		}
+	}
+}
+
+void SoftwareScaler::scaleBandHQ(
+	const FrameSource& frame, unsigned startY, unsigned endY,
+	std::span<Pixel> out) const
+{
+	// Same as GLHQScaler::uploadBlock(), but on the CPU.
+	unsigned width = 320 * factor;
+	size_t tableWidth = 64 * factor;
+
+	std::array<Endian::L32, 320 / 2> edges; // 2 x uint16_t
+	#ifndef NDEBUG
+	// Avoid UMR. In optimized mode we don't care.
+	ranges::fill(edges, 0);
+	#endif
+
+	// 3 consecutive lines, with one extra pixel at both sides
+	VLA_SSE_ALIGNED(Pixel, buf, 3 * 324);
+	std::array<Pixel*, 3> lines = {&buf[0 * 324 + 1], &buf[1 * 324 + 1], &buf[2 * 324 + 1]};
+	auto getLine = [&](int y, Pixel* dst) {
+		std::span<Pixel> s{dst, 320};
+		auto line = frame.getLine(y, s);
+		if (line.data() != dst) ranges::copy(line, s);
+		dst[-1] = dst[0];
+		dst[320] = dst[319];
+	};
+	getLine(narrow<int>(startY) - 1, lines[1]);
+	getLine(narrow<int>(startY) + 0, lines[2]);
+	EdgeHQ edgeHQ(0, 8, 16);
+	auto calcEdges = [&] {
+		std::span<const Pixel, 320> curr{lines[1], 320};
+		std::span<const Pixel, 320> next{lines[2], 320};
+		if (hqTableLite) {
+			calcEdgesGL(curr, next, edges, EdgeHQLite());
+		} else {
+			calcEdgesGL(curr, next, edges, edgeHQ);
+		}
+	};
+	calcEdges();
+
+	VLA_SSE_ALIGNED(Pixel, work, 2 * width + 2 * MAX_ZOOM);
+	for (auto y : xrange(startY, endY)) {
+		std::rotate(lines.begin(), lines.begin() + 1, lines.end());
+		getLine(narrow<int>(y) + 1, lines[2]);
+		calcEdges();
+
+		auto dst = out.subspan(size_t(width) * factor * (y - startY), size_t(width) * factor);
+		if (frame.getLineWidth(y) != 320) {
+			scaleLine(frame, y, dst, work.data());
+			continue;
+		}
+		for (auto x : xrange(320)) {
+			unsigned e = (uint32_t(edges[x / 2]) >> (16 * (x & 1))) & 0xFFFF;
+			const auto* table = &hqTable[(((e >> 10) & 63) * tableWidth + ((e >> 2) & 63)) * factor];
+			auto* d = &dst[size_t(x) * factor];
+			for (auto sy : xrange(factor)) {
+				for (auto sx : xrange(factor)) {
+					const auto& t = table[sy * tableWidth + sx];
+					d[sx] = blend3(lines[t.row0][x + t.col0 - 1], t.weight0,
+					               lines[t.row1][x + t.col1 - 1], t.weight1,
+					               lines[1][x], 256 - t.weight0 - t.weight1);
+				}
+				d += width;
+			}
+		}
+	}
+}
+
+void SoftwareScaler::scaleBandInterlaced(
+	const FrameSource& frame, unsigned startY, unsigned endY,
+	std::span<Pixel> out) const
+{
+	unsigned width = 320 * factor;
+	VLA_SSE_ALIGNED(Pixel, work, width);
+	for (auto y : xrange(startY * factor, endY * factor)) {
+		auto dst = out.subspan(size_t(width) * (y - startY * factor), width);
+		std::span<const Pixel> line;
+		switch (factor) {
+		case 1:
+			line = frame.getLinePtr320_240(y, std::span<Pixel, 320>(work.data(), 320));
+			break;
+		case 2:
+			line = frame.getLinePtr640_480(y, std::span<Pixel, 640>(work.data(), 640));
+			break;
+		case 3:
+			line = frame.getLinePtr960_720(y, std::span<Pixel, 960>(work.data(), 960));
+			break;
+		default:
+			UNREACHABLE;
+		}
+		ranges::copy(line, dst);
+	}
+}
+
+} // namespace openmsx
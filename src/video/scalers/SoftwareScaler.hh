@@ -0,0 +1,100 @@
+#ifndef SOFTWARESCALER_HH
+#define SOFTWARESCALER_HH
+
+#include "RenderSettings.hh"
+#include "WorkerPool.hh"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace openmsx {
+
+class FrameSource;
+
+/** CPU implementation of the scale algorithms.
+  *
+  * The normal output path scales the MSX screen with openGL shaders (see
+  * GLScaler and subclasses). This class produces (approximately) the same
+  * image on the CPU, for output that doesn't go through the openGL
+  * post-processor: video recording and raw screenshots. This also works on
+  * machines without (a usable) GPU.
+  *
+  * Implemented are 'simple' (including horizontal blur and scanlines),
+  * 'RGBtriplet', 'hq' and 'hqlite'. Like their GL counterparts, hq and
+  * hqlite fall back to 'simple' for lines that are not 320 pixels wide. The
+  * other algorithms also fall back to 'simple'. Interlaced (480 lines) frames
+  * are only resized.
+  *
+  * The frame is split in horizontal bands which are scaled in parallel.
+  */
+class SoftwareScaler
+{
+public:
+	using Pixel = uint32_t;
+
+	struct Config {
+		RenderSettings::ScaleAlgorithm algorithm = RenderSettings::SCALER_SIMPLE;
+		unsigned factor = 1; // 1, 2 or 3
+		int blur = 0;        // [0..256], see RenderSettings::getBlurFactor()
+		int scanline = 255;  // [0..255], see RenderSettings::getScanlineFactor()
+	};
+	[[nodiscard]] static Config getConfig(const RenderSettings& settings, unsigned factor);
+
+	/** Suggested number of worker threads, based on the number of cores. */
+	[[nodiscard]] static unsigned getDefaultNumWorkers();
+
+	explicit SoftwareScaler(unsigned numWorkers);
+
+	/** Scale 'frame' to an image of (320 * factor) x (240 * factor) pixels.
+	  * The lines of the result are stored consecutively in 'out'.
+	  * Throws MSXException when the tables for the hq algorithms can't be
+	  * loaded.
+	  */
+	void scaleImage(const FrameSource& frame, const Config& config,
+	                std::span<Pixel> out);
+
+	struct HQEntry {
+		// 2 (out of the 3x3) neighbours and their weights, the remaining
+		// weight (out of 256) is for the center pixel
+		uint8_t row0, col0, row1, col1;
+		uint16_t weight0, weight1;
+	};
+	struct BlurWeights {
+		// per channel weights for a cycle of 12 output pixels
+		alignas(16) std::array<uint16_t, 4 * 12> left, center, right;
+	};
+
+private:
+	void setup(const Config& config);
+	void loadHQTable(bool lite, unsigned factor);
+
+	void scaleBand(const FrameSource& frame, unsigned startY, unsigned endY,
+	               std::span<Pixel> out) const;
+	void scaleBandHQ(const FrameSource& frame, unsigned startY, unsigned endY,
+	                 std::span<Pixel> out) const;
+	void scaleBandInterlaced(const FrameSource& frame, unsigned startY, unsigned endY,
+	                         std::span<Pixel> out) const;
+	void scaleLine(const FrameSource& frame, unsigned y, std::span<Pixel> out,
+	               Pixel* work) const;
+
+private:
+	WorkerPool workerPool;
+
+	// derived from Config, only read while scaling
+	unsigned factor = 1;
+	bool hq = false;
+	bool rgbTriplet = false;
+	bool blur = false;
+	std::array<unsigned, 3> scanlineFactor; // per output row, [0..256]
+	std::array<BlurWeights, 3> blurWeights; // per horizontal zoom factor
+	std::array<std::array<std::array<uint8_t, 256>, 2>, 3> rgbLut; // [row][main/other][value]
+
+	std::vector<HQEntry> hqTable;
+	bool hqTableLite = false;
+	unsigned hqTableFactor = 0;
+};
+
+} // namespace openmsx
+
+#endif
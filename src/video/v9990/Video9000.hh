@@ -39,7 +39,7 @@ private:
 
 	// VideoLayer
 	void paint(OutputSurface& output) override;
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	void takeRawScreenShot(unsigned height, const std::string& filename, bool scaled) override;
 
 	// EventListener
 	int signalEvent(const Event& event) override;